@@ -238,6 +238,7 @@ typedef struct OptionsContext {
     SpecifierOptList passlogfiles;
     SpecifierOptList max_muxing_queue_size;
     SpecifierOptList muxing_queue_data_threshold;
+    SpecifierOptList enc_affinity;
     SpecifierOptList guess_layout_max;
     SpecifierOptList apad;
     SpecifierOptList discard;
@@ -712,7 +713,9 @@ extern AVIOContext *progress_avio;
 extern float max_error_rate;
 
 extern char *filter_nbthreads;
+extern AVBufferRef *thread_pool;
 extern int filter_complex_nbthreads;
+extern int filter_pipeline;
 extern int vstats_version;
 extern int auto_conversion_filters;
 
@@ -1599,6 +1599,12 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     dp->apply_cropping          = dp->dec_ctx->apply_cropping;
     dp->dec_ctx->apply_cropping = 0;
 
+    if (thread_pool) {
+        dp->dec_ctx->thread_pool = av_buffer_ref(thread_pool);
+        if (!dp->dec_ctx->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if ((ret = avcodec_open2(dp->dec_ctx, codec, NULL)) < 0) {
         av_log(dp, AV_LOG_ERROR, "Error while opening decoder: %s\n",
                av_err2str(ret));
@@ -334,6 +334,12 @@ int enc_open(void *opaque, const AVFrame *frame)
         return ret;
     }
 
+    if (thread_pool) {
+        enc_ctx->thread_pool = av_buffer_ref(thread_pool);
+        if (!enc_ctx->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if ((ret = avcodec_open2(enc_ctx, enc, NULL)) < 0) {
         if (ret != AVERROR_EXPERIMENTAL)
             av_log(e, AV_LOG_ERROR, "Error while opening encoder - maybe "
@@ -1904,6 +1904,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
     if (!fgt->graph)
         return AVERROR(ENOMEM);
 
+    if (thread_pool) {
+        fgt->graph->thread_pool = av_buffer_ref(thread_pool);
+        if (!fgt->graph->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if (simple) {
         OutputFilterPriv *ofp = ofp_from_ofilter(fg->outputs[0]);
 
@@ -1937,6 +1943,9 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
         fgt->graph->nb_threads = filter_complex_nbthreads;
     }
 
+    if (filter_pipeline)
+        fgt->graph->thread_type |= AVFILTER_THREAD_PIPELINE;
+
     hw_device = hw_device_for_filter();
 
     ret = graph_parse(fg, fgt->graph, graph_desc, &inputs, &outputs, hw_device);
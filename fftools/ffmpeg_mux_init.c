@@ -1256,12 +1256,21 @@ static int ost_add(Muxer *mux, const OptionsContext *o, enum AVMediaType type,
     }
 
     if (enc) {
+        const char *affinity = NULL;
+
         ret = sch_add_enc(mux->sch, encoder_thread, ost,
                           ost->type == AVMEDIA_TYPE_SUBTITLE ? NULL : enc_open);
         if (ret < 0)
             return ret;
         ms->sch_idx_enc = ret;
 
+        opt_match_per_stream_str(ost, &o->enc_affinity, oc, st, &affinity);
+        if (affinity) {
+            ret = sch_set_affinity(mux->sch, SCH_ENC(ms->sch_idx_enc), affinity);
+            if (ret < 0)
+                return ret;
+        }
+
         ret = enc_alloc(&ost->enc, enc, mux->sch, ms->sch_idx_enc, ost);
         if (ret < 0)
             return ret;
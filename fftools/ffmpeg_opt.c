@@ -47,6 +47,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/threadpool.h"
 
 HWDevice *filter_hw_device;
 
@@ -76,7 +77,9 @@ int print_stats       = -1;
 int stdin_interaction = 1;
 float max_error_rate  = 2.0/3;
 char *filter_nbthreads;
+AVBufferRef *thread_pool;
 int filter_complex_nbthreads = 0;
+int filter_pipeline = 0;
 int vstats_version = 2;
 int auto_conversion_filters = 1;
 int64_t stats_period = 500000;
@@ -418,6 +421,28 @@ static int apply_sync_offsets(void)
     return 0;
 }
 
+static int opt_thread_affinity(void *optctx, const char *opt, const char *arg)
+{
+    GlobalOptionsContext *go = optctx;
+    return sch_set_affinity(go->sch, (SchedulerNode){ .type = SCH_NODE_TYPE_NONE }, arg);
+}
+
+static int opt_thread_pool(void *optctx, const char *opt, const char *arg)
+{
+    double num;
+    int ret = parse_number(opt, arg, OPT_TYPE_INT, 0, INT_MAX, &num);
+    if (ret < 0)
+        return ret;
+
+    av_buffer_unref(&thread_pool);
+    thread_pool = av_thread_pool_alloc(num);
+    if (!thread_pool) {
+        av_log(NULL, AV_LOG_ERROR, "Could not create a thread pool\n");
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
 static int opt_filter_threads(void *optctx, const char *opt, const char *arg)
 {
     av_free(filter_nbthreads);
@@ -1728,6 +1753,15 @@ const OptionDef options[] = {
     { "filter_complex_threads", OPT_TYPE_INT, OPT_EXPERT,
         { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "filter_pipeline",        OPT_TYPE_BOOL, OPT_EXPERT,
+        { &filter_pipeline },
+        "run different filters of a filtergraph concurrently" },
+    { "thread_affinity",        OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
+        { .func_arg = opt_thread_affinity },
+        "restrict all threads to a set of CPUs", "cpus" },
+    { "thread_pool",            OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
+        { .func_arg = opt_thread_pool },
+        "share one pool of slice threads between all codecs and filters", "nb_threads" },
     { "lavfi",               OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
@@ -2030,6 +2064,9 @@ const OptionDef options[] = {
     { "muxing_queue_data_threshold", OPT_TYPE_INT, OPT_PERSTREAM | OPT_EXPERT | OPT_OUTPUT,
         { .off = OFFSET(muxing_queue_data_threshold) },
         "set the threshold after which max_muxing_queue_size is taken into account", "bytes" },
+    { "enc_affinity",     OPT_TYPE_STRING, OPT_PERSTREAM | OPT_EXPERT | OPT_OUTPUT,
+        { .off = OFFSET(enc_affinity) },
+        "restrict the encoder threads to a set of CPUs", "cpus" },
 
     /* data codec support */
     { "dcodec", OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_DATA | OPT_PERFILE | OPT_EXPERT | OPT_INPUT | OPT_OUTPUT | OPT_HAS_CANON,
@@ -19,9 +19,20 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
+#if HAVE_SCHED_GETAFFINITY
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sched.h>
+#endif
+
+#include <errno.h>
 #include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "cmdutils.h"
 #include "ffmpeg_sched.h"
@@ -40,6 +51,10 @@
 #include "libavutil/threadmessage.h"
 #include "libavutil/time.h"
 
+#if HAVE_GETPROCESSAFFINITYMASK
+#include <windows.h>
+#endif
+
 // 100 ms
 // FIXME: some other value? make this dynamic?
 #define SCHEDULE_TOLERANCE (100 * 1000)
@@ -60,6 +75,12 @@ typedef struct SchWaiter {
     int                 choked_next;
 } SchWaiter;
 
+#define SCH_MAX_CPUS 1024
+
+typedef struct SchAffinity {
+    uint64_t            mask[SCH_MAX_CPUS / 64];
+} SchAffinity;
+
 typedef struct SchTask {
     Scheduler          *parent;
     SchedulerNode       node;
@@ -67,6 +88,10 @@ typedef struct SchTask {
     SchThreadFunc       func;
     void               *func_arg;
 
+    // CPUs the task is restricted to, if has_affinity is set
+    SchAffinity         affinity;
+    int                 has_affinity;
+
     pthread_t           thread;
     int                 thread_running;
 } SchTask;
@@ -409,6 +434,149 @@ static int queue_alloc(ThreadQueue **ptq, unsigned nb_streams, unsigned queue_si
     return 0;
 }
 
+static int affinity_parse(SchAffinity *a, const char *cpus, void *logctx)
+{
+    const char *p = cpus;
+    int nb_cpus = 0;
+
+    memset(a, 0, sizeof(*a));
+
+    while (*p) {
+        char *end;
+        long first, last;
+
+        first = last = strtol(p, &end, 10);
+        if (end == p)
+            goto fail;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p)
+                goto fail;
+        }
+        if (first < 0 || last < first || last >= SCH_MAX_CPUS)
+            goto fail;
+
+        for (long i = first; i <= last; i++)
+            a->mask[i / 64] |= UINT64_C(1) << (i % 64);
+        nb_cpus += last - first + 1;
+
+        p = end;
+        if (*p == ',')
+            p++;
+        else if (*p)
+            goto fail;
+    }
+
+    if (!nb_cpus)
+        goto fail;
+
+    return 0;
+fail:
+    av_log(logctx, AV_LOG_ERROR, "Invalid CPU list: '%s'\n", cpus);
+    return AVERROR(EINVAL);
+}
+
+static int affinity_get(SchAffinity *a)
+{
+#if HAVE_SCHED_GETAFFINITY && defined(CPU_SET)
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set))
+        return AVERROR(errno);
+
+    memset(a, 0, sizeof(*a));
+    for (int i = 0; i < FFMIN(SCH_MAX_CPUS, CPU_SETSIZE); i++)
+        if (CPU_ISSET(i, &set))
+            a->mask[i / 64] |= UINT64_C(1) << (i % 64);
+    return 0;
+#elif HAVE_GETPROCESSAFFINITYMASK
+    DWORD_PTR proc_aff, sys_aff;
+
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &proc_aff, &sys_aff))
+        return AVERROR_EXTERNAL;
+
+    memset(a, 0, sizeof(*a));
+    a->mask[0] = proc_aff;
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+// apply the affinity to the calling thread
+static int affinity_set(const SchAffinity *a)
+{
+#if HAVE_SCHED_GETAFFINITY && defined(CPU_SET)
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for (int i = 0; i < FFMIN(SCH_MAX_CPUS, CPU_SETSIZE); i++)
+        if (a->mask[i / 64] & (UINT64_C(1) << (i % 64)))
+            CPU_SET(i, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set))
+        return AVERROR(errno);
+    return 0;
+#elif HAVE_GETPROCESSAFFINITYMASK
+    if (!SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)a->mask[0]))
+        return AVERROR_EXTERNAL;
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+static SchTask *task_get(Scheduler *sch, SchedulerNode node)
+{
+    switch (node.type) {
+    case SCH_NODE_TYPE_DEMUX:
+        av_assert0(node.idx < sch->nb_demux);
+        return &sch->demux[node.idx].task;
+    case SCH_NODE_TYPE_MUX:
+        av_assert0(node.idx < sch->nb_mux);
+        return &sch->mux[node.idx].task;
+    case SCH_NODE_TYPE_DEC:
+        av_assert0(node.idx < sch->nb_dec);
+        return &sch->dec[node.idx].task;
+    case SCH_NODE_TYPE_ENC:
+        av_assert0(node.idx < sch->nb_enc);
+        return &sch->enc[node.idx].task;
+    case SCH_NODE_TYPE_FILTER_IN:
+    case SCH_NODE_TYPE_FILTER_OUT:
+        av_assert0(node.idx < sch->nb_filters);
+        return &sch->filters[node.idx].task;
+    default: av_assert0(0);
+    }
+}
+
+int sch_set_affinity(Scheduler *sch, SchedulerNode node, const char *cpus)
+{
+    SchAffinity a;
+    SchTask *task;
+    int ret;
+
+    av_assert0(sch->state == SCH_STATE_UNINIT);
+
+    ret = affinity_parse(&a, cpus, sch);
+    if (ret < 0)
+        return ret;
+
+    if (node.type == SCH_NODE_TYPE_NONE) {
+        ret = affinity_set(&a);
+        if (ret < 0)
+            av_log(sch, AV_LOG_ERROR, "Error setting thread affinity to '%s': %s\n",
+                   cpus, av_err2str(ret));
+        return ret;
+    }
+
+    task = task_get(sch, node);
+    task->affinity     = a;
+    task->has_affinity = 1;
+
+    return 0;
+}
+
 static void *task_wrapper(void *arg);
 
 static int task_start(SchTask *task)
@@ -1607,6 +1775,21 @@ int sch_start(Scheduler *sch)
     av_assert0(sch->state == SCH_STATE_UNINIT);
     sch->state = SCH_STATE_STARTED;
 
+    // filtergraphs feeding a single pinned encoder follow it
+    for (unsigned i = 0; i < sch->nb_enc; i++) {
+        SchEnc *enc = &sch->enc[i];
+        SchFilterGraph *fg;
+
+        if (!enc->task.has_affinity || enc->src.type != SCH_NODE_TYPE_FILTER_OUT)
+            continue;
+
+        fg = &sch->filters[enc->src.idx];
+        if (fg->nb_outputs == 1 && !fg->task.has_affinity) {
+            fg->task.affinity     = enc->task.affinity;
+            fg->task.has_affinity = 1;
+        }
+    }
+
     for (unsigned i = 0; i < sch->nb_mux; i++) {
         SchMux *mux = &sch->mux[i];
 
@@ -1691,9 +1874,20 @@ int sch_wait(Scheduler *sch, uint64_t timeout_us, int64_t *transcode_ts)
 
 static int enc_open(Scheduler *sch, SchEnc *enc, const AVFrame *frame)
 {
+    SchAffinity orig;
+    int restore = 0;
     int ret;
 
+    // the encoder is opened from the sending thread, so temporarily move it
+    // to the encoder's CPUs for any codec worker threads to inherit them
+    if (enc->task.has_affinity && affinity_get(&orig) >= 0 &&
+        memcmp(&orig, &enc->task.affinity, sizeof(orig)))
+        restore = affinity_set(&enc->task.affinity) >= 0;
+
     ret = enc->open_cb(enc->task.func_arg, frame);
+
+    if (restore)
+        affinity_set(&orig);
     if (ret < 0)
         return ret;
 
@@ -2541,6 +2735,13 @@ static void *task_wrapper(void *arg)
     int ret;
     int err = 0;
 
+    if (task->has_affinity) {
+        ret = affinity_set(&task->affinity);
+        if (ret < 0)
+            av_log(task->func_arg, AV_LOG_WARNING,
+                   "Error setting thread affinity: %s\n", av_err2str(ret));
+    }
+
     ret = task->func(task->func_arg);
     if (ret < 0)
         av_log(task->func_arg, AV_LOG_ERROR,
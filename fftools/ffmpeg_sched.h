@@ -330,6 +330,27 @@ int sch_sq_add_enc(Scheduler *sch, unsigned sq_idx, unsigned enc_idx,
 
 int sch_connect(Scheduler *sch, SchedulerNode src, SchedulerNode dst);
 
+/**
+ * Restrict a task to a set of CPUs.
+ *
+ * The thread running the task is pinned to the given CPUs when it starts, and
+ * so are the worker threads it creates, e.g. for codec frame/slice threading
+ * or filtergraph threads, and the memory it first touches is allocated on the
+ * corresponding NUMA nodes by the usual operating system policy. The threads
+ * of an encoder opened from another task are moved to the encoder's CPUs too.
+ * A filtergraph feeding only a pinned encoder inherits its CPUs, unless it was
+ * given its own.
+ *
+ * @param node A demuxer, decoder, filtergraph, encoder or muxer node. A node
+ *             of type SCH_NODE_TYPE_NONE pins the calling thread immediately,
+ *             which applies to all threads it creates afterwards.
+ * @param cpus Comma-separated list of CPU indices or ranges of indices,
+ *             e.g. "0-7,16-23".
+ *
+ * Must be called before sch_start().
+ */
+int sch_set_affinity(Scheduler *sch, SchedulerNode node, const char *cpus);
+
 enum DemuxSendFlags {
     /**
      * Treat the packet as an EOF for SCH_NODE_TYPE_MUX destinations
@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -23,6 +24,7 @@
 #include "libavutil/error.h"
 #include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 
@@ -34,22 +36,48 @@ enum {
     FINISHED_RECV = (1 << 1),
 };
 
+/* maximum number of items moved to the receiving thread per lock acquisition */
+#define TQ_BATCH_SIZE 16
+
 typedef struct FifoElem {
     void        *obj;
     unsigned int stream_idx;
 } FifoElem;
 
 struct ThreadQueue {
-    int              *finished;
+    atomic_int       *finished;
     unsigned int    nb_streams;
 
     AVFifo  *fifo;
+    size_t   queue_size;
 
     ObjPool *obj_pool;
     void   (*obj_move)(void *dst, void *src);
 
     pthread_mutex_t lock;
-    pthread_cond_t  cond;
+    // signalled when space is available for sending
+    pthread_cond_t  cond_send;
+    // signalled when an item or EOF is available for receiving
+    pthread_cond_t  cond_recv;
+
+    /*
+     * Items taken out of the FIFO in one go by the receiving thread, which
+     * owns them. They keep counting towards queue_size until they have been
+     * returned, nb_batched is the number of such items.
+     */
+    FifoElem     batch[TQ_BATCH_SIZE];
+    unsigned int batch_pos;
+    unsigned int batch_count;
+    atomic_uint  nb_batched;
+
+    // emptied containers of returned items, put back into obj_pool when the
+    // receiving thread next takes the lock
+    void        *spent[TQ_BATCH_SIZE];
+    unsigned int nb_spent;
+
+    // wakeups are only sent when the other side is waiting
+    atomic_int   nb_send_waiting;
+    int          recv_waiting;
 };
 
 void tq_free(ThreadQueue **ptq)
@@ -59,6 +87,11 @@ void tq_free(ThreadQueue **ptq)
     if (!tq)
         return;
 
+    for (unsigned int i = tq->batch_pos; i < tq->batch_count; i++)
+        objpool_release(tq->obj_pool, &tq->batch[i].obj);
+    for (unsigned int i = 0; i < tq->nb_spent; i++)
+        objpool_release(tq->obj_pool, &tq->spent[i]);
+
     if (tq->fifo) {
         FifoElem elem;
         while (av_fifo_read(tq->fifo, &elem, 1) >= 0)
@@ -70,7 +103,8 @@ void tq_free(ThreadQueue **ptq)
 
     av_freep(&tq->finished);
 
-    pthread_cond_destroy(&tq->cond);
+    pthread_cond_destroy(&tq->cond_recv);
+    pthread_cond_destroy(&tq->cond_send);
     pthread_mutex_destroy(&tq->lock);
 
     av_freep(ptq);
@@ -86,27 +120,41 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
     if (!tq)
         return NULL;
 
-    ret = pthread_cond_init(&tq->cond, NULL);
+    ret = pthread_cond_init(&tq->cond_send, NULL);
+    if (ret) {
+        av_freep(&tq);
+        return NULL;
+    }
+
+    ret = pthread_cond_init(&tq->cond_recv, NULL);
     if (ret) {
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
     ret = pthread_mutex_init(&tq->lock, NULL);
     if (ret) {
-        pthread_cond_destroy(&tq->cond);
+        pthread_cond_destroy(&tq->cond_recv);
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
+    atomic_init(&tq->nb_batched, 0);
+    atomic_init(&tq->nb_send_waiting, 0);
+
     tq->finished = av_calloc(nb_streams, sizeof(*tq->finished));
     if (!tq->finished)
         goto fail;
+    for (unsigned int i = 0; i < nb_streams; i++)
+        atomic_init(&tq->finished[i], 0);
     tq->nb_streams = nb_streams;
 
     tq->fifo = av_fifo_alloc2(queue_size, sizeof(FifoElem), 0);
     if (!tq->fifo)
         goto fail;
+    tq->queue_size = queue_size;
 
     tq->obj_pool = obj_pool;
     tq->obj_move = obj_move;
@@ -117,9 +165,14 @@ fail:
     return NULL;
 }
 
+static int can_send_locked(ThreadQueue *tq)
+{
+    return av_fifo_can_read(tq->fifo) + atomic_load(&tq->nb_batched) < tq->queue_size;
+}
+
 int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 {
-    int *finished;
+    atomic_int *finished;
     int ret;
 
     av_assert0(stream_idx < tq->nb_streams);
@@ -127,17 +180,29 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 
     pthread_mutex_lock(&tq->lock);
 
-    if (*finished & FINISHED_SEND) {
+    if (atomic_load(finished) & FINISHED_SEND) {
         ret = AVERROR(EINVAL);
         goto finish;
     }
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo))
-        pthread_cond_wait(&tq->cond, &tq->lock);
+    while (!(atomic_load(finished) & FINISHED_RECV)) {
+        int full;
+
+        // announce the wait before checking for space, so that the receiving
+        // thread either sees us waiting or we see the space it freed
+        atomic_fetch_add(&tq->nb_send_waiting, 1);
+        full = !can_send_locked(tq);
+        if (full)
+            pthread_cond_wait(&tq->cond_send, &tq->lock);
+        atomic_fetch_sub(&tq->nb_send_waiting, 1);
 
-    if (*finished & FINISHED_RECV) {
+        if (!full)
+            break;
+    }
+
+    if (atomic_load(finished) & FINISHED_RECV) {
         ret = AVERROR_EOF;
-        *finished |= FINISHED_SEND;
+        atomic_fetch_or(finished, FINISHED_SEND);
     } else {
         FifoElem elem = { .stream_idx = stream_idx };
 
@@ -149,7 +214,9 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
 
         ret = av_fifo_write(tq->fifo, &elem, 1);
         av_assert0(ret >= 0);
-        pthread_cond_broadcast(&tq->cond);
+
+        if (tq->recv_waiting)
+            pthread_cond_signal(&tq->cond_recv);
     }
 
 finish:
@@ -158,31 +225,91 @@ finish:
     return ret;
 }
 
-static int receive_locked(ThreadQueue *tq, int *stream_idx,
-                          void *data)
+/* an item left the batch, wake up senders waiting for space */
+static void batch_item_done(ThreadQueue *tq)
+{
+    atomic_fetch_sub(&tq->nb_batched, 1);
+
+    if (atomic_load(&tq->nb_send_waiting)) {
+        pthread_mutex_lock(&tq->lock);
+        pthread_cond_broadcast(&tq->cond_send);
+        pthread_mutex_unlock(&tq->lock);
+    }
+}
+
+static int receive_batch(ThreadQueue *tq, int *stream_idx, void *data)
 {
-    FifoElem elem;
+    while (tq->batch_pos < tq->batch_count) {
+        FifoElem *elem = &tq->batch[tq->batch_pos++];
+        int drop = atomic_load(&tq->finished[elem->stream_idx]) & FINISHED_RECV;
+
+        if (!drop) {
+            tq->obj_move(data, elem->obj);
+            *stream_idx = elem->stream_idx;
+        }
+
+        tq->spent[tq->nb_spent++] = elem->obj;
+        elem->obj = NULL;
+
+        batch_item_done(tq);
+
+        if (!drop)
+            return 0;
+    }
+
+    return AVERROR(EAGAIN);
+}
+
+static int receive_locked(ThreadQueue *tq, int *stream_idx)
+{
+    size_t can_read = av_fifo_can_read(tq->fifo);
     unsigned int nb_finished = 0;
 
-    while (av_fifo_read(tq->fifo, &elem, 1) >= 0) {
-        if (tq->finished[elem.stream_idx] & FINISHED_RECV) {
-            objpool_release(tq->obj_pool, &elem.obj);
-            continue;
+    for (unsigned int i = 0; i < tq->nb_spent; i++)
+        objpool_release(tq->obj_pool, &tq->spent[i]);
+    tq->nb_spent = 0;
+
+    tq->batch_pos   = 0;
+    tq->batch_count = 0;
+
+    if (can_read) {
+        size_t nb_read = FFMIN(can_read, TQ_BATCH_SIZE);
+        int ret;
+
+        ret = av_fifo_read(tq->fifo, tq->batch, nb_read);
+        av_assert0(ret >= 0);
+
+        for (size_t i = 0; i < nb_read; i++) {
+            FifoElem *elem = &tq->batch[i];
+
+            if (atomic_load(&tq->finished[elem->stream_idx]) & FINISHED_RECV) {
+                objpool_release(tq->obj_pool, &elem->obj);
+                continue;
+            }
+
+            tq->batch[tq->batch_count++] = *elem;
         }
+        atomic_fetch_add(&tq->nb_batched, tq->batch_count);
+
+        // signal senders if discarded items freed some space
+        if (tq->batch_count < nb_read)
+            pthread_cond_broadcast(&tq->cond_send);
 
-        tq->obj_move(data, elem.obj);
-        objpool_release(tq->obj_pool, &elem.obj);
-        *stream_idx = elem.stream_idx;
-        return 0;
+        if (tq->batch_count)
+            return 0;
+        if (nb_read < can_read)
+            return AVERROR(EAGAIN);
     }
 
     for (unsigned int i = 0; i < tq->nb_streams; i++) {
-        if (!tq->finished[i])
+        int finished = atomic_load(&tq->finished[i]);
+
+        if (!finished)
             continue;
 
         /* return EOF to the consumer at most once for each stream */
-        if (!(tq->finished[i] & FINISHED_RECV)) {
-            tq->finished[i] |= FINISHED_RECV;
+        if (!(finished & FINISHED_RECV)) {
+            atomic_fetch_or(&tq->finished[i], FINISHED_RECV);
             *stream_idx   = i;
             return AVERROR_EOF;
         }
@@ -199,28 +326,29 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
 
     *stream_idx = -1;
 
-    pthread_mutex_lock(&tq->lock);
-
     while (1) {
-        size_t can_read = av_fifo_can_read(tq->fifo);
+        // items already taken from the FIFO do not require the lock
+        ret = receive_batch(tq, stream_idx, data);
+        if (ret != AVERROR(EAGAIN))
+            return ret;
 
-        ret = receive_locked(tq, stream_idx, data);
+        pthread_mutex_lock(&tq->lock);
 
-        // signal other threads if the fifo state changed
-        if (can_read != av_fifo_can_read(tq->fifo))
-            pthread_cond_broadcast(&tq->cond);
+        while (1) {
+            ret = receive_locked(tq, stream_idx);
+            if (ret != AVERROR(EAGAIN) || av_fifo_can_read(tq->fifo))
+                break;
 
-        if (ret == AVERROR(EAGAIN)) {
-            pthread_cond_wait(&tq->cond, &tq->lock);
-            continue;
+            tq->recv_waiting = 1;
+            pthread_cond_wait(&tq->cond_recv, &tq->lock);
+            tq->recv_waiting = 0;
         }
 
-        break;
-    }
-
-    pthread_mutex_unlock(&tq->lock);
+        pthread_mutex_unlock(&tq->lock);
 
-    return ret;
+        if (ret < 0 && ret != AVERROR(EAGAIN))
+            return ret;
+    }
 }
 
 void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
@@ -232,8 +360,8 @@ void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as send-finished;
      * next time the consumer thread tries to read this stream it will get
      * an EOF and recv-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_SEND;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_SEND);
+    pthread_cond_broadcast(&tq->cond_recv);
 
     pthread_mutex_unlock(&tq->lock);
 }
@@ -247,8 +375,9 @@ void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
     /* mark the stream as recv-finished;
      * next time the producer thread tries to send for this stream, it will
      * get an EOF and send-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_RECV;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_RECV);
+    pthread_cond_broadcast(&tq->cond_send);
+    pthread_cond_broadcast(&tq->cond_recv);
 
     pthread_mutex_unlock(&tq->lock);
 }
@@ -826,6 +826,222 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+enum {
+    ELEMENT_TNS  = 1 << 0,
+    ELEMENT_IS   = 1 << 1,
+    ELEMENT_PRED = 1 << 2,
+};
+
+typedef struct ElementJobs {
+    const FFPsyWindowInfo *windows;
+    const int *start_chs;
+    const int *bitres_allocs;
+    int *modes;
+} ElementJobs;
+
+/* Run the psy model on a channel element, leaving its bit allocation in
+ * s->psy.bitres.alloc. */
+static void analyze_element(AVCodecContext *avctx, AACEncContext *s, int el,
+                            int start_ch, const FFPsyWindowInfo *wi,
+                            int *target_bits)
+{
+    ChannelElement *cpe = &s->cpe[el];
+    int chans = s->chan_map[el + 1] == TYPE_CPE ? 2 : 1;
+    const float *coeffs[2];
+
+    cpe->common_window = 0;
+    memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
+    memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
+    for (int ch = 0; ch < chans; ch++) {
+        SingleChannelElement *sce = &cpe->ch[ch];
+        coeffs[ch] = sce->coeffs;
+        sce->ics.predictor_present = 0;
+        sce->ics.ltp.present = 0;
+        memset(sce->ics.ltp.used, 0, sizeof(sce->ics.ltp.used));
+        memset(sce->ics.prediction_used, 0, sizeof(sce->ics.prediction_used));
+        memset(&sce->tns, 0, sizeof(TemporalNoiseShaping));
+        for (int w = 0; w < 128; w++)
+            if (sce->band_type[w] > RESERVED_BT)
+                sce->band_type[w] = 0;
+    }
+    s->psy.bitres.alloc = -1;
+    s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
+    s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
+    if (s->psy.bitres.alloc > 0) {
+        /* Lambda unused here on purpose, we need to take psy's unscaled allocation */
+        *target_bits += s->psy.bitres.alloc
+            * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
+        s->psy.bitres.alloc /= chans;
+    }
+}
+
+static void search_element_quantizers(AVCodecContext *avctx, AACEncContext *s,
+                                      int el, int start_ch,
+                                      const FFPsyWindowInfo *wi, int *modes)
+{
+    ChannelElement *cpe = &s->cpe[el];
+    int tag   = s->chan_map[el + 1];
+    int chans = tag == TYPE_CPE ? 2 : 1;
+
+    s->cur_type = tag;
+    for (int ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (int w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (int ch = 0; ch < chans; ch++) { /* TNS */
+        SingleChannelElement *sce = &cpe->ch[ch];
+        s->cur_channel = start_ch + ch;
+        if (s->options.tns && s->coder->search_for_tns)
+            s->coder->search_for_tns(s, sce);
+        if (s->options.tns && s->coder->apply_tns_filt)
+            s->coder->apply_tns_filt(s, sce);
+        if (sce->tns.present)
+            *modes |= ELEMENT_TNS;
+    }
+}
+
+static void search_element_pns(AVCodecContext *avctx, AACEncContext *s,
+                               int el, int start_ch)
+{
+    ChannelElement *cpe = &s->cpe[el];
+    int chans = s->chan_map[el + 1] == TYPE_CPE ? 2 : 1;
+
+    if (!s->options.pns || !s->coder->search_for_pns)
+        return;
+    for (int ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        s->coder->search_for_pns(s, avctx, &cpe->ch[ch]);
+    }
+}
+
+static void search_element_stereo(AVCodecContext *avctx, AACEncContext *s,
+                                  int el, int start_ch, int *modes)
+{
+    ChannelElement *cpe = &s->cpe[el];
+    SingleChannelElement *sce;
+    int chans = s->chan_map[el + 1] == TYPE_CPE ? 2 : 1;
+    int ch;
+
+    s->cur_channel = start_ch;
+    if (s->options.intensity_stereo) { /* Intensity Stereo */
+        if (s->coder->search_for_is)
+            s->coder->search_for_is(s, avctx, cpe);
+        if (cpe->is_mode) *modes |= ELEMENT_IS;
+        apply_intensity_stereo(cpe);
+    }
+    if (s->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->search_for_pred)
+                s->coder->search_for_pred(s, sce);
+            if (cpe->ch[ch].ics.predictor_present) *modes |= ELEMENT_PRED;
+        }
+        /* the common prediction compares the bands of both channels */
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_pred)
+            s->coder->adjust_common_pred(s, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->apply_main_pred)
+                s->coder->apply_main_pred(s, sce);
+        }
+        s->cur_channel = start_ch;
+    }
+    if (s->options.mid_side) { /* Mid/Side stereo */
+        if (s->options.mid_side == -1 && s->coder->search_for_ms)
+            s->coder->search_for_ms(s, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (s->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->coder->search_for_ltp)
+                s->coder->search_for_ltp(s, sce, cpe->common_window);
+            if (sce->ics.ltp.present) *modes |= ELEMENT_PRED;
+        }
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_ltp)
+            s->coder->adjust_common_ltp(s, cpe);
+    }
+}
+
+/* @return 1 if mid/side coding is used */
+static int put_element(AVCodecContext *avctx, AACEncContext *s, int el,
+                       int start_ch, int *chan_el_counter)
+{
+    ChannelElement *cpe = &s->cpe[el];
+    int tag   = s->chan_map[el + 1];
+    int chans = tag == TYPE_CPE ? 2 : 1;
+    int ms_mode = 0;
+
+    put_bits(&s->pb, 3, tag);
+    put_bits(&s->pb, 4, chan_el_counter[tag]++);
+    if (chans == 2) {
+        put_bits(&s->pb, 1, cpe->common_window);
+        if (cpe->common_window) {
+            put_ics_info(s, &cpe->ch[0].ics);
+            if (s->coder->encode_main_pred)
+                s->coder->encode_main_pred(s, &cpe->ch[0]);
+            if (s->coder->encode_ltp_info)
+                s->coder->encode_ltp_info(s, &cpe->ch[0], 1);
+            encode_ms_info(&s->pb, cpe);
+            if (cpe->ms_mode) ms_mode = 1;
+        }
+    }
+    for (int ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
+    }
+    return ms_mode;
+}
+
+/* The jobs work on the per-thread copies of the context, the elements being
+ * independent once analyzed by the psy model. */
+static int search_quantizers_job(AVCodecContext *avctx, void *arg,
+                                 int el, int threadnr)
+{
+    AACEncContext *s = avctx->priv_data;
+    AACEncContext *t = &s->thread_ctx[threadnr];
+    ElementJobs *jobs = arg;
+    int start_ch = jobs->start_chs[el];
+
+    t->psy.bitres.alloc = jobs->bitres_allocs[el];
+    search_element_quantizers(avctx, t, el, start_ch, jobs->windows + start_ch,
+                              &jobs->modes[el]);
+    return 0;
+}
+
+static int search_stereo_job(AVCodecContext *avctx, void *arg,
+                             int el, int threadnr)
+{
+    AACEncContext *s = avctx->priv_data;
+    ElementJobs *jobs = arg;
+
+    search_element_stereo(avctx, &s->thread_ctx[threadnr], el,
+                          jobs->start_chs[el], &jobs->modes[el]);
+    return 0;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -839,6 +1055,8 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    int start_chs[AAC_MAX_CHANNELS], bitres_allocs[AAC_MAX_CHANNELS];
+    int modes[AAC_MAX_CHANNELS];
 
     /* add current frame to queue */
     if (frame) {
@@ -862,6 +1080,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         tag      = s->chan_map[i+1];
         chans    = tag == TYPE_CPE ? 2 : 1;
         cpe      = &s->cpe[i];
+        start_chs[i] = start_ch;
         for (ch = 0; ch < chans; ch++) {
             int k;
             float clip_avoidance_factor;
@@ -959,134 +1178,47 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
         if ((avctx->frame_num & 0xFF)==1 && !(avctx->flags & AV_CODEC_FLAG_BITEXACT))
             put_bitstream_info(s, LIBAVCODEC_IDENT);
-        start_ch = 0;
         target_bits = 0;
         memset(chan_el_counter, 0, sizeof(chan_el_counter));
-        for (i = 0; i < s->chan_map[0]; i++) {
-            FFPsyWindowInfo* wi = windows + start_ch;
-            const float *coeffs[2];
-            tag      = s->chan_map[i+1];
-            chans    = tag == TYPE_CPE ? 2 : 1;
-            cpe      = &s->cpe[i];
-            cpe->common_window = 0;
-            memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
-            memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
-            for (ch = 0; ch < chans; ch++) {
-                sce = &cpe->ch[ch];
-                coeffs[ch] = sce->coeffs;
-                sce->ics.predictor_present = 0;
-                sce->ics.ltp.present = 0;
-                memset(sce->ics.ltp.used, 0, sizeof(sce->ics.ltp.used));
-                memset(sce->ics.prediction_used, 0, sizeof(sce->ics.prediction_used));
-                memset(&sce->tns, 0, sizeof(TemporalNoiseShaping));
-                for (w = 0; w < 128; w++)
-                    if (sce->band_type[w] > RESERVED_BT)
-                        sce->band_type[w] = 0;
-            }
-            s->psy.bitres.alloc = -1;
-            s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
-            s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
-            if (s->psy.bitres.alloc > 0) {
-                /* Lambda unused here on purpose, we need to take psy's unscaled allocation */
-                target_bits += s->psy.bitres.alloc
-                    * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
-                s->psy.bitres.alloc /= chans;
+        memset(modes, 0, sizeof(modes));
+        /* The coder of the first frame sets the cutoff used by the psy
+         * analysis of the next elements, which is the same from then on,
+         * so that all elements can be analyzed before being coded. */
+        if (avctx->active_thread_type & FF_THREAD_SLICE &&
+            avctx->frame_num > 1 && s->chan_map[0] > 1) {
+            ElementJobs jobs = { windows, start_chs, bitres_allocs, modes };
+
+            for (i = 0; i < s->chan_map[0]; i++) {
+                analyze_element(avctx, s, i, start_chs[i], windows + start_chs[i],
+                                &target_bits);
+                bitres_allocs[i] = s->psy.bitres.alloc;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+            for (i = 0; i < avctx->thread_count; i++) {
+                s->thread_ctx[i].psy    = s->psy;
+                s->thread_ctx[i].lambda = s->lambda;
             }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
-                    tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
-            }
-            if (chans == 2) {
-                put_bits(&s->pb, 1, cpe->common_window);
-                if (cpe->common_window) {
-                    put_ics_info(s, &cpe->ch[0].ics);
-                    if (s->coder->encode_main_pred)
-                        s->coder->encode_main_pred(s, &cpe->ch[0]);
-                    if (s->coder->encode_ltp_info)
-                        s->coder->encode_ltp_info(s, &cpe->ch[0], 1);
-                    encode_ms_info(&s->pb, cpe);
-                    if (cpe->ms_mode) ms_mode = 1;
-                }
-            }
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
+            avctx->execute2(avctx, search_quantizers_job, &jobs, NULL, s->chan_map[0]);
+            /* the noise of the PNS search is drawn in the order of the channels */
+            for (i = 0; i < s->chan_map[0]; i++)
+                search_element_pns(avctx, s, i, start_chs[i]);
+            avctx->execute2(avctx, search_stereo_job, &jobs, NULL, s->chan_map[0]);
+            for (i = 0; i < s->chan_map[0]; i++)
+                ms_mode |= put_element(avctx, s, i, start_chs[i], chan_el_counter);
+        } else {
+            for (i = 0; i < s->chan_map[0]; i++) {
+                const FFPsyWindowInfo *wi = windows + start_chs[i];
+
+                analyze_element(avctx, s, i, start_chs[i], wi, &target_bits);
+                search_element_quantizers(avctx, s, i, start_chs[i], wi, &modes[i]);
+                search_element_pns(avctx, s, i, start_chs[i]);
+                search_element_stereo(avctx, s, i, start_chs[i], &modes[i]);
+                ms_mode |= put_element(avctx, s, i, start_chs[i], chan_el_counter);
             }
-            start_ch += chans;
+        }
+        for (i = 0; i < s->chan_map[0]; i++) {
+            tns_mode  |= !!(modes[i] & ELEMENT_TNS);
+            is_mode   |= !!(modes[i] & ELEMENT_IS);
+            pred_mode |= !!(modes[i] & ELEMENT_PRED);
         }
 
         if (avctx->flags & AV_CODEC_FLAG_QSCALE) {
@@ -1191,6 +1323,11 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     av_tx_uninit(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    if (s->thread_ctx) {
+        for (int i = 0; i < avctx->thread_count; i++)
+            ff_lpc_end(&s->thread_ctx[i].lpc);
+        av_freep(&s->thread_ctx);
+    }
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -1384,6 +1521,22 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
 
     ff_af_queue_init(avctx, &s->afq);
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->thread_ctx = av_calloc(avctx->thread_count, sizeof(*s->thread_ctx));
+        if (!s->thread_ctx)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < avctx->thread_count; i++) {
+            AACEncContext *t = &s->thread_ctx[i];
+
+            memcpy(t, s, sizeof(*t));
+            memset(&t->lpc, 0, sizeof(t->lpc));
+            t->thread_ctx = NULL;
+            if ((ret = ff_lpc_init(&t->lpc, 2*avctx->frame_size, TNS_MAX_ORDER,
+                                   FF_LPC_TYPE_LEVINSON)) < 0)
+                return ret;
+        }
+    }
+
     return 0;
 }
 
@@ -1422,14 +1575,14 @@ const FFCodec ff_aac_encoder = {
     .p.type         = AVMEDIA_TYPE_AUDIO,
     .p.id           = AV_CODEC_ID_AAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+                      AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(AACEncContext),
     .init           = aac_encode_init,
     FF_CODEC_ENCODE_CB(aac_encode_frame),
     .close          = aac_encode_end,
     .defaults       = aac_encode_defaults,
     .p.supported_samplerates = ff_mpeg4audio_sample_rates,
-    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_SLICE_THREAD_POOL,
     .p.sample_fmts  = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
     .p.priv_class   = &aacenc_class,
@@ -253,6 +253,9 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    /* copies used by the slice threads, with their own scratch buffers */
+    struct AACEncContext *thread_ctx;
 } AACEncContext;
 
 void ff_quantize_band_cost_cache_init(struct AACEncContext *s);
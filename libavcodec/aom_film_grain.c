@@ -25,12 +25,14 @@
  * @author Niklas Haas <ffmpeg@haasn.xyz>
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/avassert.h"
 #include "libavutil/buffer.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
 
 #include "aom_film_grain.h"
+#include "avcodec.h"
 #include "get_bits.h"
 
 // Common/shared helpers (not dependent on BIT_DEPTH)
@@ -47,8 +49,8 @@ static inline int round2(const int x, const uint64_t shift) {
 }
 
 enum {
-    GRAIN_WIDTH      = 82,
-    GRAIN_HEIGHT     = 73,
+    GRAIN_WIDTH      = FF_AOM_GRAIN_WIDTH,
+    GRAIN_HEIGHT     = FF_AOM_GRAIN_HEIGHT,
     SUB_GRAIN_WIDTH  = 44,
     SUB_GRAIN_HEIGHT = 38,
     FG_BLOCK_SIZE    = 32,
@@ -56,6 +58,17 @@ enum {
 
 static const int16_t gaussian_sequence[2048];
 
+typedef struct AOMThreadData {
+    AVFrame *out;
+    const AVFrame *in;
+    const AVFilmGrainParams *params;
+    const AOMFilmGrainDSPContext *dsp;
+    const void *grain_lut;
+    const void *scaling;
+    int bit_depth;
+    int rows, nb_jobs;
+} AOMThreadData;
+
 #define BIT_DEPTH 16
 #include "aom_film_grain_template.c"
 #undef BIT_DEPTH
@@ -64,8 +77,23 @@ static const int16_t gaussian_sequence[2048];
 #include "aom_film_grain_template.c"
 #undef BIT_DEPTH
 
+av_cold void ff_aom_film_grain_dsp_init(AOMFilmGrainDSPContext *c, int bpc)
+{
+    if (bpc > 8) {
+        c->generate_grain_y  = generate_grain_y_16;
+        c->generate_grain_uv = generate_grain_uv_16;
+        c->fgy_32x32xn       = fgy_32x32xn_16;
+        c->fguv_32x32xn      = fguv_32x32xn_16;
+    } else {
+        c->generate_grain_y  = generate_grain_y_8;
+        c->generate_grain_uv = generate_grain_uv_8;
+        c->fgy_32x32xn       = fgy_32x32xn_8;
+        c->fguv_32x32xn      = fguv_32x32xn_8;
+    }
+}
 
-int ff_aom_apply_film_grain(AVFrame *out, const AVFrame *in,
+int ff_aom_apply_film_grain(AVCodecContext *avctx,
+                            AVFrame *out, const AVFrame *in,
                             const AVFilmGrainParams *params)
 {
     const AVFilmGrainAOMParams *const data = &params->codec.aom;
@@ -99,22 +127,22 @@ int ff_aom_apply_film_grain(AVFrame *out, const AVFrame *in,
     case AV_PIX_FMT_YUVJ420P:
     case AV_PIX_FMT_YUVJ422P:
     case AV_PIX_FMT_YUVJ444P:
-        return apply_film_grain_8(out, in, params);
+        return apply_film_grain_8(avctx, out, in, params);
     case AV_PIX_FMT_GRAY9:
     case AV_PIX_FMT_YUV420P9:
     case AV_PIX_FMT_YUV422P9:
     case AV_PIX_FMT_YUV444P9:
-        return apply_film_grain_16(out, in, params, 9);
+        return apply_film_grain_16(avctx, out, in, params, 9);
     case AV_PIX_FMT_GRAY10:
     case AV_PIX_FMT_YUV420P10:
     case AV_PIX_FMT_YUV422P10:
     case AV_PIX_FMT_YUV444P10:
-        return apply_film_grain_16(out, in, params, 10);
+        return apply_film_grain_16(avctx, out, in, params, 10);
     case AV_PIX_FMT_GRAY12:
     case AV_PIX_FMT_YUV420P12:
     case AV_PIX_FMT_YUV422P12:
     case AV_PIX_FMT_YUV444P12:
-        return apply_film_grain_16(out, in, params, 12);
+        return apply_film_grain_16(avctx, out, in, params, 12);
     }
 
     /* The AV1 spec only defines film grain synthesis for these formats */
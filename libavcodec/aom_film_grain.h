@@ -28,17 +28,56 @@
 #ifndef AVCODEC_AOM_FILM_GRAIN_H
 #define AVCODEC_AOM_FILM_GRAIN_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "libavutil/buffer.h"
 #include "libavutil/film_grain_params.h"
 
+struct AVCodecContext;
+
 typedef struct AVFilmGrainAFGS1Params {
     int enable;
     AVBufferRef *sets[8];
 } AVFilmGrainAFGS1Params;
 
+#define FF_AOM_GRAIN_WIDTH  82
+#define FF_AOM_GRAIN_HEIGHT 73
+
+// Grain synthesis functions. Samples are uint8_t for 8-bit content and
+// uint16_t otherwise; grain LUT entries are int8_t or int16_t respectively,
+// stored in rows of FF_AOM_GRAIN_WIDTH entries. `bitdepth` is only used by
+// the high bit depth functions.
+typedef struct AOMFilmGrainDSPContext {
+    // Generate the luma grain LUT of FF_AOM_GRAIN_HEIGHT rows.
+    void (*generate_grain_y)(void *buf, const AVFilmGrainParams *params,
+                             int bitdepth);
+    // Generate the grain LUT of chroma plane `uv`, correlated with `buf_y`.
+    void (*generate_grain_uv)(void *buf, const void *buf_y,
+                              const AVFilmGrainParams *params, int uv,
+                              int subx, int suby, int bitdepth);
+    // Apply luma grain to a row of 32x32 blocks, pw samples wide and bh high.
+    void (*fgy_32x32xn)(void *dst_row, const void *src_row, ptrdiff_t stride,
+                        const AVFilmGrainParams *params, size_t pw,
+                        const uint8_t *scaling, const void *grain_lut,
+                        int bh, int row_num, int bitdepth);
+    // Apply chroma grain to a row of (subsampled) 32x32 blocks.
+    void (*fguv_32x32xn)(void *dst_row, const void *src_row, ptrdiff_t stride,
+                         const AVFilmGrainParams *params, size_t pw,
+                         const uint8_t *scaling, const void *grain_lut,
+                         int bh, int row_num, const void *luma_row,
+                         ptrdiff_t luma_stride, int uv, int is_id,
+                         int sx, int sy, int bitdepth);
+} AOMFilmGrainDSPContext;
+
+void ff_aom_film_grain_dsp_init(AOMFilmGrainDSPContext *c, int bpc);
+
 // Synthesizes film grain on top of `in` and stores the result to `out`. `out`
 // must already have been allocated and set to the same size and format as `in`.
-int ff_aom_apply_film_grain(AVFrame *out, const AVFrame *in,
+// Rows of blocks are synthesized in parallel with avctx->execute2() when
+// slice threading is active.
+int ff_aom_apply_film_grain(struct AVCodecContext *avctx,
+                            AVFrame *out, const AVFrame *in,
                             const AVFilmGrainParams *params);
 
 // Parse AFGS1 parameter sets from an ITU-T T.35 payload. Returns 0 on success,
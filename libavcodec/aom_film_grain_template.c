@@ -430,6 +430,57 @@ FUNC(fguv_32x32xn_c)(pixel *const dst_row, const pixel *const src_row,
     }
 }
 
+// Type-erased entry points of AOMFilmGrainDSPContext
+static void FUNC(generate_grain_y)(void *buf, const AVFilmGrainParams *params,
+                                   const int bd)
+{
+#if BIT_DEPTH > 8
+    const int bitdepth = bd;
+#endif
+    FUNC(generate_grain_y_c)(buf, params HBD_CALL);
+}
+
+static void FUNC(generate_grain_uv)(void *buf, const void *buf_y,
+                                    const AVFilmGrainParams *params,
+                                    const int uv, const int subx, const int suby,
+                                    const int bd)
+{
+#if BIT_DEPTH > 8
+    const int bitdepth = bd;
+#endif
+    FUNC(generate_grain_uv_c)(buf, buf_y, params, uv, subx, suby HBD_CALL);
+}
+
+static void FUNC(fgy_32x32xn)(void *dst_row, const void *src_row,
+                              const ptrdiff_t stride,
+                              const AVFilmGrainParams *params, const size_t pw,
+                              const uint8_t *scaling, const void *grain_lut,
+                              const int bh, const int row_num, const int bd)
+{
+#if BIT_DEPTH > 8
+    const int bitdepth = bd;
+#endif
+    FUNC(fgy_32x32xn_c)(dst_row, src_row, stride, params, pw, scaling,
+                        grain_lut, bh, row_num HBD_CALL);
+}
+
+static void FUNC(fguv_32x32xn)(void *dst_row, const void *src_row,
+                               const ptrdiff_t stride,
+                               const AVFilmGrainParams *params, const size_t pw,
+                               const uint8_t *scaling, const void *grain_lut,
+                               const int bh, const int row_num,
+                               const void *luma_row, const ptrdiff_t luma_stride,
+                               const int uv, const int is_id,
+                               const int sx, const int sy, const int bd)
+{
+#if BIT_DEPTH > 8
+    const int bitdepth = bd;
+#endif
+    FUNC(fguv_32x32xn_c)(dst_row, src_row, stride, params, pw, scaling,
+                         grain_lut, bh, row_num, luma_row, luma_stride,
+                         uv, is_id, sx, sy HBD_CALL);
+}
+
 static void FUNC(generate_scaling)(const uint8_t points[][2], const int num,
                                    uint8_t scaling[SCALING_SIZE] HBD_DECL)
 {
@@ -484,11 +535,12 @@ static void FUNC(generate_scaling)(const uint8_t points[][2], const int num,
 
 static av_always_inline void
 FUNC(apply_grain_row)(AVFrame *out, const AVFrame *in,
+                      const AOMFilmGrainDSPContext *dsp,
                       const int ss_x, const int ss_y,
                       const uint8_t scaling[3][SCALING_SIZE],
                       const entry grain_lut[3][GRAIN_HEIGHT+1][GRAIN_WIDTH],
                       const AVFilmGrainParams *params,
-                      const int row HBD_DECL)
+                      const int row, const int bitdepth_arg)
 {
     // Synthesize grain for the affected planes
     const AVFilmGrainAOMParams *const data = &params->codec.aom;
@@ -502,9 +554,9 @@ FUNC(apply_grain_row)(AVFrame *out, const AVFrame *in,
     if (data->num_y_points) {
         const int bh = FFMIN(out->height - row * FG_BLOCK_SIZE, FG_BLOCK_SIZE);
         const ptrdiff_t off = row * FG_BLOCK_SIZE * out->linesize[0];
-        FUNC(fgy_32x32xn_c)((pixel *) ((char *) out->data[0] + off), luma_src,
-                            out->linesize[0], params, out->width, scaling[0],
-                            grain_lut[0], bh, row HBD_CALL);
+        dsp->fgy_32x32xn((pixel *) ((char *) out->data[0] + off), luma_src,
+                         out->linesize[0], params, out->width, scaling[0],
+                         grain_lut[0], bh, row, bitdepth_arg);
     }
 
     if (!data->num_uv_points[0] && !data->num_uv_points[1] &&
@@ -524,25 +576,44 @@ FUNC(apply_grain_row)(AVFrame *out, const AVFrame *in,
 
     if (data->chroma_scaling_from_luma) {
         for (int pl = 0; pl < 2; pl++)
-            FUNC(fguv_32x32xn_c)((pixel *) ((char *) out->data[1 + pl] + uv_off),
-                                 (const pixel *) ((const char *) in->data[1 + pl] + uv_off),
-                                 in->linesize[1], params, cpw, scaling[0],
-                                 grain_lut[1 + pl], bh, row, luma_src,
-                                 in->linesize[0], pl, is_id, ss_x, ss_y HBD_CALL);
+            dsp->fguv_32x32xn((pixel *) ((char *) out->data[1 + pl] + uv_off),
+                              (const pixel *) ((const char *) in->data[1 + pl] + uv_off),
+                              in->linesize[1], params, cpw, scaling[0],
+                              grain_lut[1 + pl], bh, row, luma_src,
+                              in->linesize[0], pl, is_id, ss_x, ss_y, bitdepth_arg);
     } else {
         for (int pl = 0; pl < 2; pl++) {
             if (data->num_uv_points[pl]) {
-                FUNC(fguv_32x32xn_c)((pixel *) ((char *) out->data[1 + pl] + uv_off),
-                                     (const pixel *) ((const char *) in->data[1 + pl] + uv_off),
-                                     in->linesize[1], params, cpw, scaling[1 + pl],
-                                     grain_lut[1 + pl], bh, row, luma_src,
-                                     in->linesize[0], pl, is_id, ss_x, ss_y HBD_CALL);
+                dsp->fguv_32x32xn((pixel *) ((char *) out->data[1 + pl] + uv_off),
+                                  (const pixel *) ((const char *) in->data[1 + pl] + uv_off),
+                                  in->linesize[1], params, cpw, scaling[1 + pl],
+                                  grain_lut[1 + pl], bh, row, luma_src,
+                                  in->linesize[0], pl, is_id, ss_x, ss_y, bitdepth_arg);
             }
         }
     }
 }
 
-static int FUNC(apply_film_grain)(AVFrame *out_frame, const AVFrame *in_frame,
+static int FUNC(apply_grain_rows)(AVCodecContext *avctx, void *arg,
+                                  int jobnr, int threadnr)
+{
+    const AOMThreadData *td = arg;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(td->out->format);
+    const int row_start = td->rows *  jobnr      / td->nb_jobs;
+    const int row_end   = td->rows * (jobnr + 1) / td->nb_jobs;
+
+    for (int row = row_start; row < row_end; row++) {
+        FUNC(apply_grain_row)(td->out, td->in, td->dsp,
+                              desc->log2_chroma_w, desc->log2_chroma_h,
+                              td->scaling, td->grain_lut, td->params,
+                              row, td->bit_depth);
+    }
+
+    return 0;
+}
+
+static int FUNC(apply_film_grain)(AVCodecContext *avctx,
+                                  AVFrame *out_frame, const AVFrame *in_frame,
                                   const AVFilmGrainParams *params HBD_DECL)
 {
     entry grain_lut[3][GRAIN_HEIGHT + 1][GRAIN_WIDTH];
@@ -552,13 +623,17 @@ static int FUNC(apply_film_grain)(AVFrame *out_frame, const AVFrame *in_frame,
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(out_frame->format);
     const int rows = AV_CEIL_RSHIFT(out_frame->height, 5); /* log2(FG_BLOCK_SIZE) */
     const int subx = desc->log2_chroma_w, suby = desc->log2_chroma_h;
+    AOMFilmGrainDSPContext dsp;
+    AOMThreadData td;
+
+    ff_aom_film_grain_dsp_init(&dsp, BIT_DEPTH);
 
     // Generate grain LUTs as needed
-    FUNC(generate_grain_y_c)(grain_lut[0], params HBD_CALL);
+    dsp.generate_grain_y(grain_lut[0], params, bitdepth);
     if (data->num_uv_points[0] || data->chroma_scaling_from_luma)
-        FUNC(generate_grain_uv_c)(grain_lut[1], grain_lut[0], params, 0, subx, suby HBD_CALL);
+        dsp.generate_grain_uv(grain_lut[1], grain_lut[0], params, 0, subx, suby, bitdepth);
     if (data->num_uv_points[1] || data->chroma_scaling_from_luma)
-        FUNC(generate_grain_uv_c)(grain_lut[2], grain_lut[0], params, 1, subx, suby HBD_CALL);
+        dsp.generate_grain_uv(grain_lut[2], grain_lut[0], params, 1, subx, suby, bitdepth);
 
     // Generate scaling LUTs as needed
     if (data->num_y_points || data->chroma_scaling_from_luma)
@@ -568,10 +643,23 @@ static int FUNC(apply_film_grain)(AVFrame *out_frame, const AVFrame *in_frame,
     if (data->num_uv_points[1])
         FUNC(generate_scaling)(data->uv_points[1], data->num_uv_points[1], scaling[2] HBD_CALL);
 
-    for (int row = 0; row < rows; row++) {
-        FUNC(apply_grain_row)(out_frame, in_frame, subx, suby, scaling, grain_lut,
-                              params, row HBD_CALL);
-    }
+    // The rows of blocks only share the (read-only) LUTs, so they can be
+    // synthesized in parallel
+    td = (AOMThreadData) {
+        .out       = out_frame,
+        .in        = in_frame,
+        .params    = params,
+        .dsp       = &dsp,
+        .grain_lut = grain_lut,
+        .scaling   = scaling,
+        .bit_depth = bitdepth,
+        .rows      = rows,
+        .nb_jobs   = 1,
+    };
+    if (avctx->active_thread_type & FF_THREAD_SLICE)
+        td.nb_jobs = FFMAX(FFMIN(avctx->thread_count, rows), 1);
+
+    avctx->execute2(avctx, FUNC(apply_grain_rows), &td, NULL, td.nb_jobs);
 
     return 0;
 }
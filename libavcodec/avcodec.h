@@ -2086,6 +2086,22 @@ typedef struct AVCodecContext {
      */
     AVFrameSideData  **decoded_side_data;
     int             nb_decoded_side_data;
+
+    /**
+     * A reference to a thread pool from av_thread_pool_alloc(). When set,
+     * slice threading runs its jobs on the threads of this pool, which may
+     * be shared with other contexts, instead of creating threads of its own.
+     * thread_count still limits the number of threads working on this
+     * context at once. Frame threading and codecs whose slice jobs depend
+     * on each other keep using threads of their own.
+     *
+     * Should be set before avcodec_open2() is called and must not be written
+     * to thereafter. Unreferenced by libavcodec in avcodec_free_context().
+     *
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    AVBufferRef *thread_pool;
 } AVCodecContext;
 
 /**
@@ -88,6 +88,13 @@
  * encoders do.
  */
 #define FF_CODEC_CAP_EOF_FLUSH              (1 << 10)
+/**
+ * The slice threading of the codec may run on AVCodecContext.thread_pool.
+ * Its jobs must not wait for each other, since a busy pool may run them one
+ * after the other on the calling thread, and may only use threadnr to pick
+ * per thread scratch data. Codecs without this flag keep private threads.
+ */
+#define FF_CODEC_CAP_SLICE_THREAD_POOL      (1 << 11)
 
 /**
  * FFCodec.codec_tags termination value
@@ -737,5 +737,6 @@ const FFCodec ff_dnxhd_decoder = {
     FF_CODEC_DECODE_CB(dnxhd_decode_frame),
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
                       AV_CODEC_CAP_SLICE_THREADS,
+    .caps_internal  = FF_CODEC_CAP_SLICE_THREAD_POOL,
     .p.profiles     = NULL_IF_CONFIG_SMALL(ff_dnxhd_profiles),
 };
@@ -700,5 +700,6 @@ const FFCodec ff_dvvideo_decoder = {
     .init           = dvvideo_decode_init,
     FF_CODEC_DECODE_CB(dvvideo_decode_frame),
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
+    .caps_internal  = FF_CODEC_CAP_SLICE_THREAD_POOL,
     .p.max_lowres   = 3,
 };
@@ -2365,6 +2365,7 @@ const FFCodec ff_exr_decoder = {
     FF_CODEC_DECODE_CB(decode_frame),
     .p.capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
                         AV_CODEC_CAP_SLICE_THREADS,
-    .caps_internal    = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
+    .caps_internal    = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM |
+                        FF_CODEC_CAP_SLICE_THREAD_POOL,
     .p.priv_class     = &exr_class,
 };
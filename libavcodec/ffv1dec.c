@@ -1102,5 +1102,6 @@ const FFCodec ff_ffv1_decoder = {
     .p.capabilities = AV_CODEC_CAP_DR1 |
                       AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP |
-                      FF_CODEC_CAP_USES_PROGRESSFRAMES,
+                      FF_CODEC_CAP_USES_PROGRESSFRAMES |
+                      FF_CODEC_CAP_SLICE_THREAD_POOL,
 };
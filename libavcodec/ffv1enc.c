@@ -1349,5 +1349,6 @@ const FFCodec ff_ffv1_encoder = {
     },
     .color_ranges   = AVCOL_RANGE_MPEG,
     .p.priv_class   = &ffv1_class,
-    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_EOF_FLUSH,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_EOF_FLUSH |
+                      FF_CODEC_CAP_SLICE_THREAD_POOL,
 };
@@ -121,6 +121,7 @@ typedef struct FlacEncodeContext {
     CompressionOptions options;
     AVCodecContext *avctx;
     LPCContext lpc_ctx;
+    LPCContext *thread_lpc_ctx; ///< one per slice thread
     struct AVMD5 *md5ctx;
     uint8_t *md5_buffer;
     unsigned int md5_buffer_size;
@@ -466,6 +467,22 @@ static av_cold int flac_encode_init(AVCodecContext *avctx)
 
     ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
                       s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    if (ret < 0)
+        return ret;
+
+    /* the channels are searched in parallel, each thread needing its own
+     * LPC buffers */
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->thread_lpc_ctx = av_calloc(avctx->thread_count, sizeof(*s->thread_lpc_ctx));
+        if (!s->thread_lpc_ctx)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < avctx->thread_count; i++) {
+            ret = ff_lpc_init(&s->thread_lpc_ctx[i], avctx->frame_size,
+                              s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+            if (ret < 0)
+                return ret;
+        }
+    }
 
     ff_bswapdsp_init(&s->bdsp);
     ff_flacencdsp_init(&s->flac_dsp);
@@ -950,7 +967,7 @@ static int lpc_encode_choose_datapath(FlacEncodeContext *s, int32_t bps,
     return subframe_count_exact(s, sub, 0);                 \
 }
 
-static int encode_residual_ch(FlacEncodeContext *s, int ch)
+static int encode_residual_ch(FlacEncodeContext *s, LPCContext *lpc_ctx, int ch)
 {
     int i, n;
     int min_order, max_order, opt_order, omethod;
@@ -1048,7 +1065,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         for (i = 0; i < n; i++)
             smp[i] = smp_33bps[i] >> 1;
 
-    opt_order = ff_lpc_calc_coefs(&s->lpc_ctx, smp, n, min_order, max_order,
+    opt_order = ff_lpc_calc_coefs(lpc_ctx, smp, n, min_order, max_order,
                                   s->options.lpc_coeff_precision, coefs, shift, s->options.lpc_type,
                                   s->options.lpc_passes, omethod,
                                   MIN_LPC_SHIFT, MAX_LPC_SHIFT, 0);
@@ -1206,6 +1223,16 @@ static int count_frame_header(FlacEncodeContext *s)
 }
 
 
+static int encode_residual_job(AVCodecContext *avctx, void *arg,
+                               int ch, int threadnr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int *counts = arg;
+
+    counts[ch] = encode_residual_ch(s, &s->thread_lpc_ctx[threadnr], ch);
+    return 0;
+}
+
 static int encode_frame(FlacEncodeContext *s)
 {
     int ch;
@@ -1213,8 +1240,16 @@ static int encode_frame(FlacEncodeContext *s)
 
     count = count_frame_header(s);
 
-    for (ch = 0; ch < s->channels; ch++)
-        count += encode_residual_ch(s, ch);
+    if (s->thread_lpc_ctx && s->channels > 1) {
+        int counts[FLAC_MAX_CHANNELS];
+
+        s->avctx->execute2(s->avctx, encode_residual_job, counts, NULL, s->channels);
+        for (ch = 0; ch < s->channels; ch++)
+            count += counts[ch];
+    } else {
+        for (ch = 0; ch < s->channels; ch++)
+            count += encode_residual_ch(s, &s->lpc_ctx, ch);
+    }
 
     count += (8 - (count & 7)) & 7; // byte alignment
     count += 16;                    // CRC-16
@@ -1706,6 +1741,11 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
     av_freep(&s->md5ctx);
     av_freep(&s->md5_buffer);
     ff_lpc_end(&s->lpc_ctx);
+    if (s->thread_lpc_ctx) {
+        for (int i = 0; i < avctx->thread_count; i++)
+            ff_lpc_end(&s->thread_lpc_ctx[i]);
+        av_freep(&s->thread_lpc_ctx);
+    }
     return 0;
 }
 
@@ -1755,7 +1795,8 @@ const FFCodec ff_flac_encoder = {
     .p.id           = AV_CODEC_ID_FLAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
                       AV_CODEC_CAP_SMALL_LAST_FRAME |
-                      AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
+                      AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(FlacEncodeContext),
     .init           = flac_encode_init,
     FF_CODEC_ENCODE_CB(flac_encode_frame),
@@ -1764,5 +1805,6 @@ const FFCodec ff_flac_encoder = {
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
     .p.priv_class   = &flac_encoder_class,
-    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_EOF_FLUSH,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_EOF_FLUSH |
+                      FF_CODEC_CAP_SLICE_THREAD_POOL,
 };
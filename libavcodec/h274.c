@@ -25,9 +25,11 @@
  * @author Niklas Haas <ffmpeg@haasn.xyz>
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
 
+#include "avcodec.h"
 #include "h274.h"
 
 static const int8_t Gaussian_LUT[2048+4];
@@ -111,7 +113,7 @@ static void init_slice(H274FilmGrainDatabase *database, uint8_t h, uint8_t v)
 }
 
 // Computes the average of an 8x8 block
-static uint16_t avg_8x8_c(const uint8_t *in, int in_stride)
+static uint16_t avg_8x8_c(const uint8_t *in, ptrdiff_t in_stride)
 {
     uint16_t avg[8] = {0}; // summing over an array vectorizes better
 
@@ -126,8 +128,8 @@ static uint16_t avg_8x8_c(const uint8_t *in, int in_stride)
 }
 
 // Synthesize an 8x8 block of film grain by copying the pattern from `db`
-static void synth_grain_8x8_c(int8_t *out, const int out_stride,
-                              const int16_t scale, const uint8_t shift,
+static void synth_grain_8x8_c(int8_t *out, ptrdiff_t out_stride,
+                              int16_t scale, uint8_t shift,
                               const int8_t *db)
 {
     for (int y = 0; y < 8; y++) {
@@ -140,7 +142,7 @@ static void synth_grain_8x8_c(int8_t *out, const int out_stride,
 }
 
 // Deblock vertical edges of an 8x8 block, mixing with the previous block
-static void deblock_8x8_c(int8_t *out, const int out_stride)
+static void deblock_8x8_c(int8_t *out, ptrdiff_t out_stride)
 {
     for (int y = 0; y < 8; y++) {
         const int8_t l1 = out[-2], l0 = out[-1];
@@ -151,17 +153,34 @@ static void deblock_8x8_c(int8_t *out, const int out_stride)
     }
 }
 
+// Saturating 8-bit sum of a+b
+static void add_8x8_clip_c(uint8_t *out, const uint8_t *a, const int8_t *b,
+                           int n)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = av_clip_uint8(a[i] + b[i]);
+}
+
+av_cold void ff_h274dsp_init(H274DSPContext *c)
+{
+    c->avg_8x8         = avg_8x8_c;
+    c->synth_grain_8x8 = synth_grain_8x8_c;
+    c->deblock_8x8     = deblock_8x8_c;
+    c->add_grain_clip  = add_8x8_clip_c;
+}
+
 // Generates a single 8x8 block of grain, optionally also applying the
 // deblocking step (note that this implies writing to the previous block).
 static av_always_inline void generate(int8_t *out, int out_stride,
                                       const uint8_t *in, int in_stride,
-                                      H274FilmGrainDatabase *database,
+                                      const H274FilmGrainDatabase *database,
+                                      const H274DSPContext *dsp,
                                       const AVFilmGrainH274Params *h274,
                                       int c, int invert, int deblock,
                                       int y_offset, int x_offset)
 {
     const uint8_t shift = h274->log2_scale_factor + 6;
-    const uint16_t avg = avg_8x8_c(in, in_stride);
+    const uint16_t avg = dsp->avg_8x8(in, in_stride);
     int16_t scale;
     uint8_t h, v;
     int8_t s = -1;
@@ -191,34 +210,94 @@ static av_always_inline void generate(int8_t *out, int out_stride,
         return;
     }
 
+    // The patterns have all been generated by ff_h274_apply_film_grain()
     h = av_clip(h274->comp_model_value[c][s][1], 2, 14) - 2;
     v = av_clip(h274->comp_model_value[c][s][2], 2, 14) - 2;
-    init_slice(database, h, v);
+    av_assert2(database->residency[h] & (1 << v));
 
     scale = h274->comp_model_value[c][s][0];
     if (invert)
         scale = -scale;
 
-    synth_grain_8x8_c(out, out_stride, scale, shift,
-                      &database->db[h][v][y_offset][x_offset]);
+    dsp->synth_grain_8x8(out, out_stride, scale, shift,
+                         &database->db[h][v][y_offset][x_offset]);
 
     if (deblock)
-        deblock_8x8_c(out, out_stride);
+        dsp->deblock_8x8(out, out_stride);
 }
 
-// Saturating 8-bit sum of a+b
-static void add_8x8_clip_c(uint8_t *out, const uint8_t *a, const int8_t *b,
-                           int n)
+typedef struct H274ThreadData {
+    const H274FilmGrainDatabase *database;
+    const H274DSPContext *dsp;
+    const AVFilmGrainH274Params *h274;
+    uint8_t *out;
+    const uint8_t *in;
+    int out_stride, in_stride;
+    int width, height;
+    int c, nb_jobs;
+    uint32_t seed;
+} H274ThreadData;
+
+// Synthesizes and applies the grain of a range of 16-line bands of a plane.
+// The bands are independent, except for the PRNG state, which is advanced
+// once per 16x16 block in raster order and simply skipped ahead here.
+static int apply_grain_bands(AVCodecContext *avctx, void *arg,
+                             int jobnr, int threadnr)
 {
-    for (int i = 0; i < n; i++)
-        out[i] = av_clip_uint8(a[i] + b[i]);
+    const H274ThreadData *td = arg;
+    const int bands = (td->height + 15) >> 4;
+    const int blocks = (td->width + 15) >> 4;
+    const int band_start = bands *  jobnr      / td->nb_jobs;
+    const int band_end   = bands * (jobnr + 1) / td->nb_jobs;
+    const int y_start = band_start << 4;
+    const int y_end   = FFMIN(band_end << 4, td->height);
+    int8_t * const grain = (int8_t *) td->out; // re-use output buffer for grain
+    const int grain_stride = td->out_stride;
+    uint32_t seed = td->seed;
+
+    for (int i = 0; i < band_start * blocks; i++)
+        prng_shift(&seed);
+
+    // Film grain synthesis is done in 8x8 blocks, but the PRNG state is
+    // only advanced in 16x16 blocks, so use a nested loop
+    for (int y = y_start; y < y_end; y += 16) {
+        for (int x = 0; x < td->width; x += 16) {
+            uint16_t x_offset = (seed >> 16) % 52;
+            uint16_t y_offset = (seed & 0xFFFF) % 56;
+            const int invert = (seed & 0x1);
+            x_offset &= 0xFFFC;
+            y_offset &= 0xFFF8;
+            prng_shift(&seed);
+
+            for (int yy = 0; yy < 16 && y+yy < td->height; yy += 8) {
+                for (int xx = 0; xx < 16 && x+xx < td->width; xx += 8) {
+                    generate(grain + (y+yy) * grain_stride + (x+xx), grain_stride,
+                             td->in + (y+yy) * td->in_stride + (x+xx), td->in_stride,
+                             td->database, td->dsp, td->h274, td->c, invert,
+                             (x+xx) > 0, y_offset + yy, x_offset + xx);
+                }
+            }
+        }
+    }
+
+    // Final output blend pass, done after grain synthesis is complete
+    // because deblocking depends on previous grain values
+    for (int y = y_start; y < y_end; y++) {
+        td->dsp->add_grain_clip(td->out + y * td->out_stride,
+                                td->in + y * td->in_stride,
+                                grain + y * grain_stride, td->width);
+    }
+
+    return 0;
 }
 
-int ff_h274_apply_film_grain(AVFrame *out_frame, const AVFrame *in_frame,
+int ff_h274_apply_film_grain(AVCodecContext *avctx,
+                             AVFrame *out_frame, const AVFrame *in_frame,
                              H274FilmGrainDatabase *database,
                              const AVFilmGrainParams *params)
 {
     AVFilmGrainH274Params h274 = params->codec.h274;
+    H274DSPContext dsp;
     av_assert1(params->type == AV_FILM_GRAIN_PARAMS_H274);
     if (h274.model_id != 0)
         return AVERROR_PATCHWELCOME;
@@ -227,21 +306,29 @@ int ff_h274_apply_film_grain(AVFrame *out_frame, const AVFrame *in_frame,
     if (in_frame->format != AV_PIX_FMT_YUV420P)
         return AVERROR_PATCHWELCOME;
 
+    ff_h274dsp_init(&dsp);
+
     for (int c = 0; c < 3; c++) {
         static const uint8_t color_offset[3] = { 0, 85, 170 };
-        uint32_t seed = Seed_LUT[(params->seed + color_offset[c]) % 256];
         const int width = c > 0 ? AV_CEIL_RSHIFT(out_frame->width, 1) : out_frame->width;
         const int height = c > 0 ? AV_CEIL_RSHIFT(out_frame->height, 1) : out_frame->height;
-
-        uint8_t * const out = out_frame->data[c];
-        const int out_stride = out_frame->linesize[c];
-        int8_t * const grain = out_frame->data[c]; // re-use output buffer for grain
-        const int grain_stride = out_stride;
-        const uint8_t * const in = in_frame->data[c];
-        const int in_stride = in_frame->linesize[c];
+        H274ThreadData td = {
+            .database   = database,
+            .dsp        = &dsp,
+            .h274       = &h274,
+            .out        = out_frame->data[c],
+            .out_stride = out_frame->linesize[c],
+            .in         = in_frame->data[c],
+            .in_stride  = in_frame->linesize[c],
+            .width      = width,
+            .height     = height,
+            .c          = c,
+            .nb_jobs    = 1,
+            .seed       = Seed_LUT[(params->seed + color_offset[c]) % 256],
+        };
 
         if (!h274.component_model_present[c]) {
-            av_image_copy_plane(out, out_stride, in, in_stride,
+            av_image_copy_plane(td.out, td.out_stride, td.in, td.in_stride,
                                 width * sizeof(uint8_t), height);
             continue;
         }
@@ -255,34 +342,18 @@ int ff_h274_apply_film_grain(AVFrame *out_frame, const AVFrame *in_frame,
             }
         }
 
-        // Film grain synthesis is done in 8x8 blocks, but the PRNG state is
-        // only advanced in 16x16 blocks, so use a nested loop
-        for (int y = 0; y < height; y += 16) {
-            for (int x = 0; x < width; x += 16) {
-                uint16_t x_offset = (seed >> 16) % 52;
-                uint16_t y_offset = (seed & 0xFFFF) % 56;
-                const int invert = (seed & 0x1);
-                x_offset &= 0xFFFC;
-                y_offset &= 0xFFF8;
-                prng_shift(&seed);
-
-                for (int yy = 0; yy < 16 && y+yy < height; yy += 8) {
-                    for (int xx = 0; xx < 16 && x+xx < width; xx += 8) {
-                        generate(grain + (y+yy) * grain_stride + (x+xx), grain_stride,
-                                 in + (y+yy) * in_stride + (x+xx), in_stride,
-                                 database, &h274, c, invert, (x+xx) > 0,
-                                 y_offset + yy, x_offset + xx);
-                    }
-                }
-            }
+        // Generate the patterns of all intensity intervals up front, so that
+        // the database is only read while the bands are synthesized
+        for (int i = 0; i < h274.num_intensity_intervals[c]; i++) {
+            const uint8_t h = av_clip(h274.comp_model_value[c][i][1], 2, 14) - 2;
+            const uint8_t v = av_clip(h274.comp_model_value[c][i][2], 2, 14) - 2;
+            init_slice(database, h, v);
         }
 
-        // Final output blend pass, done after grain synthesis is complete
-        // because deblocking depends on previous grain values
-        for (int y = 0; y < height; y++) {
-            add_8x8_clip_c(out + y * out_stride, in + y * in_stride,
-                           grain + y * grain_stride, width);
-        }
+        if (avctx->active_thread_type & FF_THREAD_SLICE)
+            td.nb_jobs = FFMIN(avctx->thread_count, (height + 15) >> 4);
+
+        avctx->execute2(avctx, apply_grain_bands, &td, NULL, td.nb_jobs);
     }
 
     return 0;
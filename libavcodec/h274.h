@@ -28,8 +28,13 @@
 #ifndef AVCODEC_H274_H
 #define AVCODEC_H274_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "libavutil/film_grain_params.h"
 
+struct AVCodecContext;
+
 // Must be initialized to {0} prior to first usage
 typedef struct H274FilmGrainDatabase {
     // Database of film grain patterns, lazily computed as-needed
@@ -40,6 +45,34 @@ typedef struct H274FilmGrainDatabase {
     int16_t slice_tmp[64][64];
 } H274FilmGrainDatabase;
 
+typedef struct H274DSPContext {
+    /**
+     * Compute the average of an 8x8 block of samples.
+     */
+    uint16_t (*avg_8x8)(const uint8_t *in, ptrdiff_t in_stride);
+
+    /**
+     * Synthesize an 8x8 block of grain as (scale * db[x]) >> shift, where
+     * db points into a 64x64 pattern of the database.
+     */
+    void (*synth_grain_8x8)(int8_t *out, ptrdiff_t out_stride,
+                            int16_t scale, uint8_t shift, const int8_t *db);
+
+    /**
+     * Deblock the vertical edge between an 8x8 block of grain and the block
+     * to its left, modifying the two columns on either side of the edge.
+     */
+    void (*deblock_8x8)(int8_t *out, ptrdiff_t out_stride);
+
+    /**
+     * Add n grain values to a line of samples, with unsigned 8-bit saturation.
+     */
+    void (*add_grain_clip)(uint8_t *out, const uint8_t *in,
+                           const int8_t *grain, int n);
+} H274DSPContext;
+
+void ff_h274dsp_init(H274DSPContext *c);
+
 /**
  * Check whether ff_h274_apply_film_grain() supports the given parameter combination.
  *
@@ -53,14 +86,16 @@ static inline int ff_h274_film_grain_params_supported(int model_id, enum AVPixel
 
 // Synthesizes film grain on top of `in` and stores the result to `out`. `out`
 // must already have been allocated and set to the same size and format as
-// `in`.
+// `in`. Bands of each plane are synthesized in parallel with
+// avctx->execute2() when slice threading is active.
 //
 // Returns a negative error code on error, such as invalid params.
 // If ff_h274_film_grain_params_supported() indicated that the parameters
 // are supported, no error will be returned if the arguments given to
 // ff_h274_film_grain_params_supported() coincide with actual values
 // from the frames and params.
-int ff_h274_apply_film_grain(AVFrame *out, const AVFrame *in,
+int ff_h274_apply_film_grain(struct AVCodecContext *avctx,
+                             AVFrame *out, const AVFrame *in,
                              H274FilmGrainDatabase *db,
                              const AVFilmGrainParams *params);
 
@@ -3416,11 +3416,11 @@ static int hevc_frame_end(HEVCContext *s, HEVCLayerContext *l)
             av_assert0(0);
             return AVERROR_BUG;
         case AV_FILM_GRAIN_PARAMS_H274:
-            ret = ff_h274_apply_film_grain(out->frame_grain, out->f,
+            ret = ff_h274_apply_film_grain(s->avctx, out->frame_grain, out->f,
                                            &s->h274db, fgp);
             break;
         case AV_FILM_GRAIN_PARAMS_AV1:
-            ret = ff_aom_apply_film_grain(out->frame_grain, out->f, fgp);
+            ret = ff_aom_apply_film_grain(s->avctx, out->frame_grain, out->f, fgp);
             break;
         }
         av_assert1(ret >= 0);
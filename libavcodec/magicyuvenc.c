@@ -697,5 +697,5 @@ const FFCodec ff_magicyuv_encoder = {
                           AV_PIX_FMT_NONE
                       },
     .color_ranges     = AVCOL_RANGE_MPEG, /* FIXME: implement tagging */
-    .caps_internal    = FF_CODEC_CAP_INIT_CLEANUP,
+    .caps_internal    = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_SLICE_THREAD_POOL,
 };
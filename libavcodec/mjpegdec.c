@@ -813,10 +813,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -825,46 +826,47 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
-                        int dc_index, int ac_index, uint16_t *quant_matrix)
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb, int *last_dc,
+                        int16_t *block, int component,
+                        int dc_index, int ac_index, const uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = val * (unsigned)quant_matrix[0] + last_dc[component];
+    last_dc[component] = val;
     block[0] = av_clip_int16(val);
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -874,7 +876,7 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[i];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
@@ -885,7 +887,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, &s->gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
@@ -1179,7 +1181,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int nb_components, int p
                 topleft[i] = top[i];
                 top[i]     = buffer[mb_x][i];
 
-                dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                 if(dc == 0xFFFFF)
                     return -1;
 
@@ -1313,7 +1315,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for(j=0; j<n; j++) {
                         int pred, dc;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1384,7 +1386,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1453,6 +1455,153 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+#define MAX_SCAN_SLICES 128
+
+typedef struct ScanSlices {
+    int nb_components;
+    int chroma_width, chroma_height;
+    int start;                  ///< byte offset of the scan data
+    const int *rst_offsets;     ///< offsets of the markers ending the intervals
+    int nb_intervals;
+    int nb_slices;
+    int end_bits;               ///< bit position after the last interval
+} ScanSlices;
+
+static int decode_restart_interval(MJpegDecodeContext *s, const ScanSlices *sl,
+                                   GetBitContext *gb, int16_t *block,
+                                   int mb, int mb_end)
+{
+    int bytes_per_pixel = 1 + (s->bits > 8);
+    int last_dc[MAX_COMPONENTS];
+
+    for (int i = 0; i < sl->nb_components; i++)
+        last_dc[i] = 4 << s->bits;
+
+    for (; mb < mb_end; mb++) {
+        int mb_x = mb % s->mb_width;
+        int mb_y = mb / s->mb_width;
+
+        if (get_bits_left(gb) < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "overread %d\n", -get_bits_left(gb));
+            return AVERROR_INVALIDDATA;
+        }
+        for (int i = 0; i < sl->nb_components; i++) {
+            int c = s->comp_index[i];
+            int h = s->h_scount[i];
+            int v = s->v_scount[i];
+            int linesize = s->linesize[c];
+
+            for (int j = 0; j < s->nb_blocks[i]; j++) {
+                int x = j % h, y = j / h;
+                int block_offset = ((linesize * (v * mb_y + y) * 8) +
+                                    (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres;
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += linesize >> 1;
+
+                s->bdsp.clear_block(block);
+                if (decode_block(s, gb, last_dc, block, i,
+                                 s->dc_index[i], s->ac_index[i],
+                                 s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+                if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? sl->chroma_width  : s->width)
+                    && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? sl->chroma_height : s->height)
+                    && linesize) {
+                    uint8_t *ptr = s->picture_ptr->data[c] + block_offset;
+                    s->idsp.idct_put(ptr, linesize, block);
+                    if (s->bits & 7)
+                        shift_output(s, ptr, linesize);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int decode_scan_slice(AVCodecContext *avctx, void *arg,
+                             int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    ScanSlices *sl = arg;
+    int nb_mbs = s->mb_width * s->mb_height;
+    int first  = sl->nb_intervals *  jobnr      / sl->nb_slices;
+    int last   = sl->nb_intervals * (jobnr + 1) / sl->nb_slices;
+    LOCAL_ALIGNED_32(int16_t, block, [64]);
+    int ret = 0;
+
+    for (int n = first; n < last; n++) {
+        int start = n ? sl->rst_offsets[n - 1] + 2 : sl->start;
+        int end   = n < sl->nb_intervals - 1 ? sl->rst_offsets[n]
+                                              : s->gb.size_in_bits >> 3;
+        int mb    = n * s->restart_interval;
+        GetBitContext gb;
+        int err;
+
+        init_get_bits8(&gb, s->gb.buffer + start, end - start);
+        /* an error only loses the rest of its interval */
+        err = decode_restart_interval(s, sl, &gb, block, mb,
+                                      FFMIN(mb + s->restart_interval, nb_mbs));
+        if (err < 0 && ret >= 0)
+            ret = err;
+        if (n == sl->nb_intervals - 1)
+            sl->end_bits = start * 8 + get_bits_count(&gb);
+    }
+    return ret;
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel, each one
+ * starting at the RSTn marker found while unescaping the scan.
+ *
+ * @return 1 if the markers do not match the restart interval, in which case
+ *         nothing was decoded, 0 or a negative error code otherwise
+ */
+static int mjpeg_decode_scan_slices(MJpegDecodeContext *s, int nb_components,
+                                    int chroma_width, int chroma_height)
+{
+    ScanSlices sl = {
+        .nb_components = nb_components,
+        .chroma_width  = chroma_width,
+        .chroma_height = chroma_height,
+        .start         = get_bits_count(&s->gb) >> 3,
+    };
+    int ret[MAX_SCAN_SLICES];
+    int nb_mbs = s->mb_width * s->mb_height;
+    int first = 0;
+
+    sl.nb_intervals = (nb_mbs + s->restart_interval - 1) / s->restart_interval;
+    if (sl.nb_intervals < 2 || get_bits_count(&s->gb) & 7)
+        return 1;
+
+    /* the markers of a previous field come first */
+    while (first < s->nb_rst_offsets && s->rst_offsets[first] < sl.start)
+        first++;
+    if (s->nb_rst_offsets - first < sl.nb_intervals - 1)
+        return 1;
+    sl.rst_offsets = s->rst_offsets + first;
+    for (int i = 0; i < sl.nb_intervals - 1; i++)
+        if (s->gb.buffer[sl.rst_offsets[i] + 1] != RST0 + (i & 7))
+            return 1;
+
+    sl.nb_slices = FFMIN3(sl.nb_intervals, 4 * s->avctx->thread_count, MAX_SCAN_SLICES);
+    s->avctx->execute2(s->avctx, decode_scan_slice, &sl, ret, sl.nb_slices);
+
+    /* continue after the scan like the single threaded decoder */
+    skip_bits_long(&s->gb, sl.end_bits - get_bits_count(&s->gb));
+    if (!(nb_mbs % s->restart_interval)) {
+        s->restart_count = 1;
+        handle_rstn(s, nb_components);
+    }
+
+    for (int i = 0; i < sl.nb_slices; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
@@ -1488,6 +1637,14 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         s->coefs_finished[c] |= 1;
     }
 
+    if (s->restart_interval && !s->progressive && !mb_bitmask &&
+        s->avctx->active_thread_type & FF_THREAD_SLICE) {
+        int ret = mjpeg_decode_scan_slices(s, nb_components,
+                                           chroma_width, chroma_height);
+        if (ret <= 0)
+            return ret;
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -1529,7 +1686,7 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
 
                         } else {
                             s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
+                            if (decode_block(s, &s->gb, s->last_dc, s->block, i,
                                              s->dc_index[i], s->ac_index[i],
                                              s->quant_matrixes[s->quant_sindex[i]]) < 0) {
                                 av_log(s->avctx, AV_LOG_ERROR,
@@ -2250,6 +2407,10 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         const uint8_t *src = *buf_ptr;
         const uint8_t *ptr = src;
         uint8_t *dst = s->buffer;
+        /* the restart intervals are decoded in parallel from these */
+        int record_rst = s->avctx->active_thread_type & FF_THREAD_SLICE;
+
+        s->nb_rst_offsets = 0;
 
         #define copy_data_segment(skip) do {       \
             ptrdiff_t length = (ptr - src) - (skip);  \
@@ -2288,6 +2449,14 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (record_rst) {
+                        /* the 0xFF of the marker is at ptr - 2 in the input */
+                        int *offsets = av_fast_realloc(s->rst_offsets, &s->rst_offsets_size,
+                                                       (s->nb_rst_offsets + 1) * sizeof(*offsets));
+                        if (!offsets)
+                            return AVERROR(ENOMEM);
+                        s->rst_offsets = offsets;
+                        offsets[s->nb_rst_offsets++] = (dst - s->buffer) + (ptr - 2 - src);
                     }
                 }
             }
@@ -2949,6 +3118,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    av_freep(&s->rst_offsets);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -3006,7 +3176,7 @@ const FFCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     FF_CODEC_DECODE_CB(ff_mjpeg_decode_frame),
     .flush          = decode_flush,
-    .p.capabilities = AV_CODEC_CAP_DR1,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .p.max_lowres   = 3,
     .p.priv_class   = &mjpegdec_class,
     .p.profiles     = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
@@ -123,6 +123,9 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *rst_offsets;           ///< offsets of the RSTn markers in the unescaped scan, for slice threading
+    int nb_rst_offsets;
+    unsigned int rst_offsets_size;
 
     int buggy_avid;
     int cs_itu601;
@@ -20,6 +20,7 @@
  */
 
 #include <float.h>
+#include <stddef.h>
 
 #include "libavutil/mem.h"
 #include "enc_psy.h"
@@ -28,8 +29,8 @@
 #include "tab.h"
 #include "libavfilter/window_func.h"
 
-static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, OpusRangeCoder *rc, int band,
-                           float *bits, float lambda)
+static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, const CeltFrame *orig,
+                           OpusRangeCoder *rc, int band, float *bits, float lambda)
 {
     int i, b = 0;
     uint32_t cm[2] = { (1 << f->blocks) - 1, (1 << f->blocks) - 1 };
@@ -37,9 +38,9 @@ static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, OpusRangeCoder *rc, int b
     float buf[176 * 2], lowband_scratch[176], norm1[176], norm2[176];
     float dist, cost, err_x = 0.0f, err_y = 0.0f;
     float *X = buf;
-    float *X_orig = f->block[0].coeffs + (ff_celt_freq_bands[band] << f->size);
+    const float *X_orig = orig->block[0].coeffs + (ff_celt_freq_bands[band] << f->size);
     float *Y = (f->channels == 2) ? &buf[176] : NULL;
-    float *Y_orig = f->block[1].coeffs + (ff_celt_freq_bands[band] << f->size);
+    const float *Y_orig = orig->block[1].coeffs + (ff_celt_freq_bands[band] << f->size);
     OPUS_RC_CHECKPOINT_SPAWN(rc);
 
     memcpy(X, X_orig, band_size*sizeof(float));
@@ -364,7 +365,8 @@ static void celt_gauge_psy_weight(OpusPsyContext *s, OpusPsyStep **start,
     f_out->framebits = FFALIGN(f_out->framebits, 8);
 }
 
-static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
+static int bands_dist(OpusPsyContext *s, CeltFrame *f, const CeltFrame *orig,
+                      float *total_dist)
 {
     int i, tdist = 0.0f;
     OpusRangeCoder dump;
@@ -374,7 +376,7 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
 
     for (i = 0; i < CELT_MAX_BANDS; i++) {
         float bits = 0.0f;
-        float dist = pvq_band_cost(f->pvq, f, &dump, i, &bits, s->lambda);
+        float dist = pvq_band_cost(f->pvq, f, orig, &dump, i, &bits, s->lambda);
         tdist += dist;
     }
 
@@ -383,26 +385,152 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
     return 0;
 }
 
+typedef struct PsyDistThreadData {
+    OpusPsyContext *s;
+    const CeltFrame *f;
+    const int *intensity_stereo;
+    const int *dual_stereo;
+    uint32_t *seed;     /* noise seed each candidate starts from */
+    uint32_t *end_seed; /* and the one it leaves behind */
+    float *dist;
+    int first;          /* candidate of job 0 */
+} PsyDistThreadData;
+
+/* Each candidate is measured on a copy of the frame owned by its thread,
+ * with the PVQ context of the thread. */
+static int bands_dist_job(AVCodecContext *avctx, void *arg,
+                          int jobnr, int threadnr)
+{
+    const PsyDistThreadData *td = arg;
+    OpusPsyContext *s = td->s;
+    CeltFrame *f = &s->thread_frame[threadnr];
+    const int idx = td->first + jobnr;
+
+    *f = *td->f;
+    f->pvq              = s->thread_pvq[threadnr];
+    f->intensity_stereo = td->intensity_stereo[idx];
+    f->dual_stereo      = td->dual_stereo[idx];
+    f->seed             = td->seed[idx];
+
+    bands_dist(s, f, td->f, &td->dist[idx]);
+    td->end_seed[idx] = f->seed;
+
+    return 0;
+}
+
+/* Advance a noise seed by n steps of celt_rng(), one bit of n at a time,
+ * with the multiplier and increment of 1, 2, 4... steps. */
+static uint32_t seed_skip(uint32_t seed, uint32_t n)
+{
+    uint32_t mul = 1664525, add = 1013904223;
+
+    for (; n; n >>= 1) {
+        if (n & 1)
+            seed = mul * seed + add;
+        add *= mul + 1;
+        mul *= mul;
+    }
+    return seed;
+}
+
+/* Number of celt_rng() steps from one seed to another. The generator has a
+ * full period of 2^32, and advancing by 2^k steps leaves the low k bits
+ * unchanged, so the steps are found from the lowest bit up. */
+static uint32_t seed_steps(uint32_t from, uint32_t to)
+{
+    uint32_t mul = 1664525, add = 1013904223, n = 0;
+
+    for (uint32_t bit = 1; from != to; bit <<= 1) {
+        if ((from ^ to) & bit) {
+            from = mul * from + add;
+            n   |= bit;
+        }
+        add *= mul + 1;
+        mul *= mul;
+    }
+    return n;
+}
+
+/*
+ * Measure the distortion of each candidate. The noise fill of a candidate
+ * continues from the seed its predecessor left behind, as when they were
+ * searched one after another, and the frame is left with the seed of the
+ * last one.
+ *
+ * With threads, all candidates are first measured from the frame's seed.
+ * The number of noise samples a candidate draws does not depend on their
+ * values, so this gives the seed each candidate really starts from, and all
+ * but the first are measured again from it. Should a candidate draw a
+ * different number of samples the second time, the ones after it are
+ * measured serially.
+ */
+static void bands_dist_candidates(OpusPsyContext *s, CeltFrame *f,
+                                  const int *intensity_stereo,
+                                  const int *dual_stereo,
+                                  float *dist, int nb_candidates)
+{
+    uint32_t seed[CELT_MAX_BANDS + 1], end_seed[CELT_MAX_BANDS + 1];
+    PsyDistThreadData td = {
+        .s                = s,
+        .f                = f,
+        .intensity_stereo = intensity_stereo,
+        .dual_stereo      = dual_stereo,
+        .seed             = seed,
+        .end_seed         = end_seed,
+        .dist             = dist,
+    };
+    int i = 1;
+
+    seed[0] = f->seed;
+
+    /* Measuring twice only pays off with three threads or more */
+    if (s->nb_threads > 2 && nb_candidates > 1) {
+        for (i = 1; i < nb_candidates; i++)
+            seed[i] = f->seed;
+        s->avctx->execute2(s->avctx, bands_dist_job, &td, NULL, nb_candidates);
+
+        for (i = 1; i < nb_candidates; i++)
+            seed[i] = seed_skip(seed[i - 1], seed_steps(f->seed, end_seed[i - 1]));
+        td.first = 1;
+        s->avctx->execute2(s->avctx, bands_dist_job, &td, NULL, nb_candidates - 1);
+        td.first = 0;
+
+        for (i = 1; i < nb_candidates; i++)
+            if (end_seed[i - 1] != seed[i])
+                break;
+    } else {
+        bands_dist_job(s->avctx, &td, 0, 0);
+    }
+
+    for (; i < nb_candidates; i++) {
+        seed[i] = end_seed[i - 1];
+        bands_dist_job(s->avctx, &td, i, 0);
+    }
+
+    f->seed = end_seed[nb_candidates - 1];
+}
+
 static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 {
-    float td1, td2;
+    int intensity_stereo[2], dual_stereo[2] = { 0, 1 };
+    float td[2];
     f->dual_stereo = 0;
 
     if (s->avctx->ch_layout.nb_channels < 2)
         return;
 
-    bands_dist(s, f, &td1);
-    f->dual_stereo = 1;
-    bands_dist(s, f, &td2);
+    intensity_stereo[0] = intensity_stereo[1] = f->intensity_stereo;
+    bands_dist_candidates(s, f, intensity_stereo, dual_stereo, td, 2);
 
-    f->dual_stereo = td2 < td1;
-    s->dual_stereo_used += td2 < td1;
+    f->dual_stereo = td[1] < td[0];
+    s->dual_stereo_used += td[1] < td[0];
 }
 
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
-    int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    int i, n = 0, best_band = CELT_MAX_BANDS - 1;
+    int intensity_stereo[CELT_MAX_BANDS + 1], dual_stereo[CELT_MAX_BANDS + 1];
+    float dist[CELT_MAX_BANDS + 1], best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
     float end_band = 0;
 
@@ -410,11 +538,16 @@ static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
         return;
 
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
-        if (best_dist > dist) {
-            best_dist = dist;
-            best_band = i;
+        intensity_stereo[n] = i;
+        dual_stereo[n++]    = f->dual_stereo;
+    }
+
+    bands_dist_candidates(s, f, intensity_stereo, dual_stereo, dist, n);
+
+    for (i = 0; i < n; i++) {
+        if (best_dist > dist[i]) {
+            best_dist = dist[i];
+            best_band = intensity_stereo[i];
         }
     }
 
@@ -539,6 +672,19 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
         goto fail;
     }
 
+    /* Frame copies and PVQ contexts for the stereo searches */
+    s->nb_threads = avctx->active_thread_type & FF_THREAD_SLICE ? avctx->thread_count : 1;
+    s->thread_frame = av_calloc(s->nb_threads, sizeof(*s->thread_frame));
+    s->thread_pvq   = av_calloc(s->nb_threads, sizeof(*s->thread_pvq));
+    if (!s->thread_frame || !s->thread_pvq) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < s->nb_threads; i++) {
+        if ((ret = ff_celt_pvq_init(&s->thread_pvq[i], 1)) < 0)
+            goto fail;
+    }
+
     for (ch = 0; ch < s->avctx->ch_layout.nb_channels; ch++) {
         for (i = 0; i < CELT_MAX_BANDS; i++) {
             bessel_init(&s->bfilter_hi[ch][i], 1.0f, 19.0f, 100.0f, 1);
@@ -576,6 +722,13 @@ fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    if (s->thread_pvq) {
+        for (i = 0; i < s->nb_threads; i++)
+            ff_celt_pvq_uninit(&s->thread_pvq[i]);
+        av_freep(&s->thread_pvq);
+    }
+    av_freep(&s->thread_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -599,6 +752,13 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    if (s->thread_pvq) {
+        for (i = 0; i < s->nb_threads; i++)
+            ff_celt_pvq_uninit(&s->thread_pvq[i]);
+        av_freep(&s->thread_pvq);
+    }
+    av_freep(&s->thread_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
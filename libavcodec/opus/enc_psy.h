@@ -69,6 +69,11 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Per thread frame copies and PVQ contexts for the distortion searches */
+    CeltFrame *thread_frame;
+    struct CeltPVQ **thread_pvq;
+    int nb_threads;
+
     /* Stats */
     float avg_is_band;
     int64_t dual_stereo_used;
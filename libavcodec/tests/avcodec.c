@@ -95,6 +95,11 @@ int main(void){
             !(codec->capabilities & AV_CODEC_CAP_SLICE_THREADS))
             ERR("Codec %s wants mainfunction despite not being "
                 "slice-threading capable");
+        if (codec2->caps_internal  & FF_CODEC_CAP_SLICE_THREAD_POOL &&
+            (!(codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) ||
+             codec2->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF))
+            ERR("Codec %s allows a thread pool for slice threading it "
+                "does not have or that uses a main function\n");
         if (codec2->caps_internal  & FF_CODEC_CAP_AUTO_THREADS &&
             !(codec->capabilities & (AV_CODEC_CAP_FRAME_THREADS |
                                      AV_CODEC_CAP_SLICE_THREADS |
@@ -0,0 +1,245 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Synthesizes both film grain models on fixed frames, once with a serial
+ * codec context and once with a slice threaded one, and prints the MD5 of
+ * the output, which must be the same for both.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/film_grain_params.h"
+#include "libavutil/frame.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/lfg.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavcodec/aom_film_grain.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/h274.h"
+
+#define WIDTH  426
+#define HEIGHT 242
+
+static AVFrame *alloc_frame(enum AVPixelFormat format)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+    frame->format = format;
+    frame->width  = WIDTH;
+    frame->height = HEIGHT;
+    if (av_frame_get_buffer(frame, 0) < 0)
+        av_frame_free(&frame);
+    return frame;
+}
+
+static void fill_frame(AVFrame *frame, AVLFG *lfg)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    const int depth = desc->comp[0].depth;
+
+    for (int p = 0; p < 3; p++) {
+        const int w = AV_CEIL_RSHIFT(frame->width,  p ? desc->log2_chroma_w : 0);
+        const int h = AV_CEIL_RSHIFT(frame->height, p ? desc->log2_chroma_h : 0);
+        for (int y = 0; y < h; y++) {
+            uint8_t *row = frame->data[p] + y * frame->linesize[p];
+            for (int x = 0; x < w; x++) {
+                // a gradient with some noise, to cover all intensity intervals
+                const int v = (x + y) * ((1 << depth) - 1) / (w + h) +
+                              (av_lfg_get(lfg) & 7);
+                if (depth > 8)
+                    AV_WN16(row + 2 * x, FFMIN(v, (1 << depth) - 1));
+                else
+                    row[x] = FFMIN(v, 255);
+            }
+        }
+    }
+}
+
+static void hash_frame(const AVFrame *frame, uint8_t md5[16])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    const int bytes = desc->comp[0].depth > 8 ? 2 : 1;
+    struct AVMD5 *ctx = av_md5_alloc();
+
+    av_md5_init(ctx);
+    for (int p = 0; p < 3; p++) {
+        const int w = AV_CEIL_RSHIFT(frame->width,  p ? desc->log2_chroma_w : 0);
+        const int h = AV_CEIL_RSHIFT(frame->height, p ? desc->log2_chroma_h : 0);
+        for (int y = 0; y < h; y++)
+            av_md5_update(ctx, frame->data[p] + y * frame->linesize[p], w * bytes);
+    }
+    av_md5_final(ctx, md5);
+    av_free(ctx);
+}
+
+static void init_h274_params(AVFilmGrainParams *fgp)
+{
+    AVFilmGrainH274Params *h274 = &fgp->codec.h274;
+
+    memset(fgp, 0, sizeof(*fgp));
+    fgp->type = AV_FILM_GRAIN_PARAMS_H274;
+    fgp->seed = 0x1234;
+    fgp->bit_depth_luma = fgp->bit_depth_chroma = 8;
+
+    h274->model_id          = 0;
+    h274->blending_mode_id  = 0;
+    h274->log2_scale_factor = 5;
+    for (int c = 0; c < 3; c++) {
+        h274->component_model_present[c] = 1;
+        h274->num_intensity_intervals[c] = 3;
+        h274->num_model_values[c]        = 3;
+        for (int i = 0; i < 3; i++) {
+            h274->intensity_interval_lower_bound[c][i] = 85 * i;
+            h274->intensity_interval_upper_bound[c][i] = 85 * i + 84;
+            h274->comp_model_value[c][i][0] = 40 + 30 * i - 10 * c;
+            h274->comp_model_value[c][i][1] = 4 + 3 * i;
+            h274->comp_model_value[c][i][2] = 12 - 3 * i + c;
+        }
+    }
+}
+
+static void init_aom_params(AVFilmGrainParams *fgp, int bit_depth)
+{
+    AVFilmGrainAOMParams *aom = &fgp->codec.aom;
+
+    memset(fgp, 0, sizeof(*fgp));
+    fgp->type = AV_FILM_GRAIN_PARAMS_AV1;
+    fgp->seed = 0x5678;
+    fgp->bit_depth_luma = fgp->bit_depth_chroma = bit_depth;
+
+    aom->num_y_points  = 3;
+    aom->y_points[0][0] =   0; aom->y_points[0][1] = 20;
+    aom->y_points[1][0] = 128; aom->y_points[1][1] = 60;
+    aom->y_points[2][0] = 255; aom->y_points[2][1] = 40;
+    for (int uv = 0; uv < 2; uv++) {
+        aom->num_uv_points[uv] = 2;
+        aom->uv_points[uv][0][0] =   0; aom->uv_points[uv][0][1] = 30 + 10 * uv;
+        aom->uv_points[uv][1][0] = 255; aom->uv_points[uv][1][1] = 50;
+        aom->uv_mult[uv]      = -64 + 32 * uv;
+        aom->uv_mult_luma[uv] =  64;
+        aom->uv_offset[uv]    =  16 * uv;
+    }
+    aom->scaling_shift  = 10;
+    aom->ar_coeff_lag   = 2;
+    aom->ar_coeff_shift = 7;
+    for (int i = 0; i < 12; i++)
+        aom->ar_coeffs_y[i] = (i & 1 ? 1 : -1) * (4 + i);
+    for (int uv = 0; uv < 2; uv++)
+        for (int i = 0; i < 13; i++)
+            aom->ar_coeffs_uv[uv][i] = (i & 1 ? -1 : 1) * (2 + i + uv);
+    aom->overlap_flag       = 1;
+    aom->limit_output_range = 1;
+}
+
+static int apply(AVCodecContext *avctx, AVFrame *out, const AVFrame *in,
+                 H274FilmGrainDatabase *db, const AVFilmGrainParams *fgp)
+{
+    if (fgp->type == AV_FILM_GRAIN_PARAMS_H274)
+        return ff_h274_apply_film_grain(avctx, out, in, db, fgp);
+    return ff_aom_apply_film_grain(avctx, out, in, fgp);
+}
+
+static int test(AVCodecContext *const avctx[2], const char *name,
+                enum AVPixelFormat format, const AVFilmGrainParams *fgp)
+{
+    H274FilmGrainDatabase *db = av_mallocz(sizeof(*db));
+    AVFrame *in  = alloc_frame(format);
+    AVFrame *out = alloc_frame(format);
+    uint8_t md5[2][16];
+    AVLFG lfg;
+    int ret = AVERROR(ENOMEM);
+
+    if (!db || !in || !out)
+        goto end;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+    fill_frame(in, &lfg);
+
+    for (int i = 0; i < 2; i++) {
+        ret = apply(avctx[i], out, in, db, fgp);
+        if (ret < 0) {
+            fprintf(stderr, "%s: error applying film grain\n", name);
+            goto end;
+        }
+        hash_frame(out, md5[i]);
+    }
+
+    printf("%-12s ", name);
+    for (int i = 0; i < 16; i++)
+        printf("%02x", md5[0][i]);
+    printf("\n");
+
+    if (memcmp(md5[0], md5[1], sizeof(md5[0]))) {
+        fprintf(stderr, "%s: slice threaded output differs\n", name);
+        ret = AVERROR_BUG;
+    }
+
+end:
+    av_frame_free(&in);
+    av_frame_free(&out);
+    av_free(db);
+    return ret;
+}
+
+int main(void)
+{
+    const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_HEVC);
+    AVCodecContext *avctx[2] = { NULL };
+    AVFilmGrainParams fgp;
+    int ret = 1;
+
+    // the contexts only provide execute2(), serial and slice threaded
+    for (int i = 0; i < 2; i++) {
+        avctx[i] = avcodec_alloc_context3(codec);
+        if (!avctx[i])
+            goto end;
+        avctx[i]->thread_count = i ? 4 : 1;
+        avctx[i]->thread_type  = FF_THREAD_SLICE;
+        if (avcodec_open2(avctx[i], codec, NULL) < 0)
+            goto end;
+    }
+    if (!(avctx[1]->active_thread_type & FF_THREAD_SLICE)) {
+        fprintf(stderr, "slice threading is not available\n");
+        goto end;
+    }
+
+    init_h274_params(&fgp);
+    if (test(avctx, "h274", AV_PIX_FMT_YUV420P, &fgp) < 0)
+        goto end;
+
+    init_aom_params(&fgp, 8);
+    if (test(avctx, "aom-420p", AV_PIX_FMT_YUV420P, &fgp) < 0 ||
+        test(avctx, "aom-444p", AV_PIX_FMT_YUV444P, &fgp) < 0)
+        goto end;
+
+    init_aom_params(&fgp, 10);
+    if (test(avctx, "aom-420p10", AV_PIX_FMT_YUV420P10, &fgp) < 0)
+        goto end;
+
+    ret = 0;
+end:
+    for (int i = 0; i < 2; i++)
+        avcodec_free_context(&avctx[i]);
+    return ret;
+}
@@ -241,5 +241,6 @@ const FFCodec ff_v210_decoder = {
     .p.capabilities = AV_CODEC_CAP_DR1 |
                       AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal  = FF_CODEC_CAP_SLICE_THREAD_POOL,
     .p.priv_class   = &v210dec_class,
 };
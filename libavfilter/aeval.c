@@ -72,6 +72,8 @@ typedef struct EvalContext {
     uint64_t n;
     double var_values[VAR_VARS_NB];
     double *channel_values;
+    double *n_values, *t_values; ///< n and t of each sample of the frame
+    int nb_values;
 } EvalContext;
 
 static double val(void *priv, double ch)
@@ -218,9 +220,26 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
     av_freep(&eval->expr);
     av_freep(&eval->channel_values);
+    av_freep(&eval->n_values);
+    av_freep(&eval->t_values);
     av_channel_layout_uninit(&eval->chlayout);
 }
 
+static int alloc_sample_values(EvalContext *eval, int nb_samples)
+{
+    if (nb_samples <= eval->nb_values)
+        return 0;
+
+    eval->n_values = av_realloc_f(eval->n_values, nb_samples, sizeof(*eval->n_values));
+    eval->t_values = av_realloc_f(eval->t_values, nb_samples, sizeof(*eval->t_values));
+    if (!eval->n_values || !eval->t_values) {
+        eval->nb_values = 0;
+        return AVERROR(ENOMEM);
+    }
+    eval->nb_values = nb_samples;
+    return 0;
+}
+
 static int config_props(AVFilterLink *outlink)
 {
     EvalContext *eval = outlink->src->priv;
@@ -268,7 +287,8 @@ static int activate(AVFilterContext *ctx)
     AVFilterLink *outlink = ctx->outputs[0];
     EvalContext *eval = outlink->src->priv;
     AVFrame *samplesref;
-    int i, j;
+    const double *const_arrays[VAR_VARS_NB] = { NULL };
+    int i, j, ret;
     int64_t t = av_rescale(eval->n, AV_TIME_BASE, eval->sample_rate);
     int nb_samples;
 
@@ -293,16 +313,27 @@ static int activate(AVFilterContext *ctx)
     if (!samplesref)
         return AVERROR(ENOMEM);
 
-    /* evaluate expression for each single sample and for each channel */
-    for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = eval->var_values[VAR_N] * (double)1/eval->sample_rate;
-
-        for (j = 0; j < eval->nb_channels; j++) {
-            *((double *) samplesref->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, NULL);
+    if ((ret = alloc_sample_values(eval, nb_samples)) < 0) {
+        av_frame_free(&samplesref);
+        return ret;
+    }
+    for (i = 0; i < nb_samples; i++) {
+        eval->n_values[i] = eval->n + i;
+        eval->t_values[i] = eval->n_values[i] * (double)1/eval->sample_rate;
+    }
+    const_arrays[VAR_N] = eval->n_values;
+    const_arrays[VAR_T] = eval->t_values;
+
+    /* evaluate expression for all the samples of each channel */
+    for (j = 0; j < eval->nb_channels; j++) {
+        ret = av_expr_eval_batch(eval->expr[j], (double *)samplesref->extended_data[j],
+                                 nb_samples, eval->var_values, const_arrays, NULL);
+        if (ret < 0) {
+            av_frame_free(&samplesref);
+            return ret;
         }
     }
+    eval->n += nb_samples;
 
     samplesref->pts = eval->pts;
     samplesref->sample_rate = eval->sample_rate;
@@ -412,9 +443,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     EvalContext *eval     = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     int nb_samples        = in->nb_samples;
+    const double *const_arrays[VAR_VARS_NB] = { NULL };
     AVFrame *out;
     double t0;
-    int i, j;
+    int i, j, k, ret;
 
     out = ff_get_audio_buffer(outlink, nb_samples);
     if (!out) {
@@ -425,23 +457,50 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     t0 = TS2T(in->pts, inlink->time_base);
 
-    /* evaluate expression for each single sample and for each channel */
-    for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = t0 + i * (double)1/inlink->sample_rate;
+    if ((ret = alloc_sample_values(eval, nb_samples)) < 0)
+        goto fail;
+    for (i = 0; i < nb_samples; i++) {
+        eval->n_values[i] = eval->n + i;
+        eval->t_values[i] = t0 + i * (double)1/inlink->sample_rate;
+    }
+    const_arrays[VAR_N] = eval->n_values;
+    const_arrays[VAR_T] = eval->t_values;
+
+    for (j = 0; j < outlink->ch_layout.nb_channels; j++) {
+        double *dst = (double *)out->extended_data[j];
+        unsigned nb_val = 0;
 
-        for (j = 0; j < inlink->ch_layout.nb_channels; j++)
-            eval->channel_values[j] = *((double *) in->extended_data[j] + i);
+        eval->var_values[VAR_CH] = j;
+        av_expr_count_func(eval->expr[j], &nb_val, 1, 1);
 
-        for (j = 0; j < outlink->ch_layout.nb_channels; j++) {
-            eval->var_values[VAR_CH] = j;
-            *((double *) out->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, eval);
+        /* without val() the channel only depends on n and t */
+        if (!nb_val) {
+            ret = av_expr_eval_batch(eval->expr[j], dst, nb_samples,
+                                     eval->var_values, const_arrays, eval);
+            if (ret < 0)
+                goto fail;
+            continue;
+        }
+
+        /* val() reads the input of the current sample, evaluate one by one */
+        for (i = 0; i < nb_samples; i++) {
+            eval->var_values[VAR_N] = eval->n_values[i];
+            eval->var_values[VAR_T] = eval->t_values[i];
+
+            for (k = 0; k < inlink->ch_layout.nb_channels; k++)
+                eval->channel_values[k] = *((double *) in->extended_data[k] + i);
+
+            dst[i] = av_expr_eval(eval->expr[j], eval->var_values, eval);
         }
     }
+    eval->n += nb_samples;
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
+fail:
+    av_frame_free(&in);
+    av_frame_free(&out);
+    return ret;
 }
 
 #if CONFIG_AEVAL_FILTER
@@ -43,12 +43,10 @@ AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples)
     return ff_get_audio_buffer(link->dst->outputs[0], nb_samples);
 }
 
-AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+static AVFrame *pool_get_audio_buffer(AVFilterLink *link, int nb_samples,
+                                      int channels, int align)
 {
-    AVFrame *frame = NULL;
     FilterLinkInternal *const li = ff_link_internal(link);
-    int channels = link->ch_layout.nb_channels;
-    int align = av_cpu_max_align();
 
     if (!li->frame_pool) {
         li->frame_pool = ff_frame_pool_audio_init(av_buffer_allocz, channels,
@@ -78,7 +76,19 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
         }
     }
 
-    frame = ff_frame_pool_get(li->frame_pool);
+    return ff_frame_pool_get(li->frame_pool);
+}
+
+AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+{
+    AVFrame *frame = NULL;
+    FilterLinkInternal *const li = ff_link_internal(link);
+    int channels = link->ch_layout.nb_channels;
+    int align = av_cpu_max_align();
+
+    ff_graph_pool_lock(li->l.graph);
+    frame = pool_get_audio_buffer(link, nb_samples, channels, align);
+    ff_graph_pool_unlock(li->l.graph);
     if (!frame)
         return NULL;
 
@@ -236,10 +236,39 @@ static void update_link_current_pts(FilterLinkInternal *li, int64_t pts)
         ff_avfilter_graph_update_heap(li->l.graph, li);
 }
 
-void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
+/**
+ * Acquire the graph lock for a link function called by a filter from a
+ * callback running without it, see FFFilterContext.unlocked.
+ *
+ * @return whether filter_unlock() must release the lock again
+ */
+static int filter_lock(AVFilterContext *ctx)
+{
+    if (!fffilterctx(ctx)->unlocked)
+        return 0;
+    ff_filter_lock_graph(ctx);
+    return 1;
+}
+
+static void filter_unlock(AVFilterContext *ctx, int locked)
+{
+    if (locked)
+        ff_filter_unlock_graph(ctx);
+}
+
+static void filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
     FFFilterContext *ctxi = fffilterctx(filter);
     ctxi->ready = FFMAX(ctxi->ready, priority);
+    if (filter->graph && fffiltergraph(filter->graph)->pipeline)
+        ff_graph_pipeline_wake(fffiltergraph(filter->graph));
+}
+
+void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
+{
+    int locked = filter_lock(filter);
+    filter_set_ready(filter, priority);
+    filter_unlock(filter, locked);
 }
 
 /**
@@ -257,7 +286,7 @@ static void filter_unblock(AVFilterContext *filter)
 }
 
 
-void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
+static void link_set_in_status(AVFilterLink *link, int status, int64_t pts)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
 
@@ -269,7 +298,14 @@ void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
     li->frame_wanted_out = 0;
     li->frame_blocked_in = 0;
     filter_unblock(link->dst);
-    ff_filter_set_ready(link->dst, 200);
+    filter_set_ready(link->dst, 200);
+}
+
+void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
+{
+    int locked = filter_lock(link->src);
+    link_set_in_status(link, status, pts);
+    filter_unlock(link->src, locked);
 }
 
 /**
@@ -286,7 +322,7 @@ static void link_set_out_status(AVFilterLink *link, int status, int64_t pts)
     if (pts != AV_NOPTS_VALUE)
         update_link_current_pts(li, pts);
     filter_unblock(link->dst);
-    ff_filter_set_ready(link->src, 200);
+    filter_set_ready(link->src, 200);
 }
 
 int avfilter_insert_filter(AVFilterLink *link, AVFilterContext *filt,
@@ -472,7 +508,7 @@ void ff_tlog_link(void *ctx, AVFilterLink *link, int end)
 }
 #endif
 
-int ff_request_frame(AVFilterLink *link)
+static int request_frame(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     FFFilterContext * const ctxi_dst = fffilterctx(link->dst);
@@ -496,10 +532,25 @@ int ff_request_frame(AVFilterLink *link)
         }
     }
     li->frame_wanted_out = 1;
-    ff_filter_set_ready(link->src, 100);
+    filter_set_ready(link->src, 100);
     return 0;
 }
 
+int ff_request_frame(AVFilterLink *link)
+{
+    AVFilterContext *dst = link->dst;
+    int ret;
+
+    /* called from a callback running without the graph lock */
+    if (fffilterctx(dst)->unlocked) {
+        ff_filter_lock_graph(dst);
+        ret = request_frame(link);
+        ff_filter_unlock_graph(dst);
+        return ret;
+    }
+    return request_frame(link);
+}
+
 static int64_t guess_status_pts(AVFilterContext *ctx, int status, AVRational link_time_base)
 {
     unsigned i;
@@ -530,13 +581,15 @@ static int request_frame_to_filter(AVFilterLink *link)
     FF_TPRINTF_START(NULL, request_frame_to_filter); ff_tlog_link(NULL, link, 1);
     /* Assume the filter is blocked, let the method clear it if not */
     li->frame_blocked_in = 1;
-    if (link->srcpad->request_frame)
+    if (link->srcpad->request_frame) {
+        ff_filter_unlock_graph(link->src);
         ret = link->srcpad->request_frame(link);
-    else if (link->src->inputs[0])
+        ff_filter_lock_graph(link->src);
+    } else if (link->src->inputs[0])
         ret = ff_request_frame(link->src->inputs[0]);
     if (ret < 0) {
         if (ret != AVERROR(EAGAIN) && ret != li->status_in)
-            ff_avfilter_link_set_in_status(link, ret, guess_status_pts(link->src, ret, link->time_base));
+            link_set_in_status(link, ret, guess_status_pts(link->src, ret, link->time_base));
         if (ret == AVERROR_EOF)
             ret = 0;
     }
@@ -845,6 +898,17 @@ int ff_filter_get_nb_threads(AVFilterContext *ctx)
     return ctx->graph->nb_threads;
 }
 
+#define JOBS_PER_THREAD 4
+
+int ff_filter_get_nb_jobs(AVFilterContext *ctx, int nb_units)
+{
+    int nb_threads = ff_filter_get_nb_threads(ctx);
+
+    if (nb_threads <= 1)
+        return FFMIN(nb_units, 1);
+    return FFMIN(nb_units, nb_threads * JOBS_PER_THREAD);
+}
+
 int ff_filter_opt_parse(void *logctx, const AVClass *priv_class,
                         AVDictionary **options, const char *args)
 {
@@ -1050,7 +1114,9 @@ static int filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     if (dstctx->is_disabled &&
         (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
         filter_frame = default_filter_frame;
+    ff_filter_unlock_graph(dstctx);
     ret = filter_frame(link, frame);
+    ff_filter_lock_graph(dstctx);
     l->frame_count_out++;
     return ret;
 
@@ -1059,7 +1125,7 @@ fail:
     return ret;
 }
 
-int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
+static int queue_frame(AVFilterLink *link, AVFrame *frame)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     int ret;
@@ -1105,7 +1171,7 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
         av_frame_free(&frame);
         return ret;
     }
-    ff_filter_set_ready(link->dst, 300);
+    filter_set_ready(link->dst, 300);
     return 0;
 
 error:
@@ -1113,6 +1179,21 @@ error:
     return AVERROR_PATCHWELCOME;
 }
 
+int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    AVFilterContext *src = link->src;
+    int ret;
+
+    /* called from a callback running without the graph lock */
+    if (fffilterctx(src)->unlocked) {
+        ff_filter_lock_graph(src);
+        ret = queue_frame(link, frame);
+        ff_filter_unlock_graph(src);
+        return ret;
+    }
+    return queue_frame(link, frame);
+}
+
 static int samples_ready(FilterLinkInternal *link, unsigned min)
 {
     return ff_framequeue_queued_frames(&link->fifo) &&
@@ -1209,7 +1290,7 @@ static int filter_frame_to_filter(AVFilterLink *link)
     } else {
         /* Run once again, to see if several frames were available, or if
            the input status has also changed, or any other reason. */
-        ff_filter_set_ready(dst, 300);
+        filter_set_ready(dst, 300);
     }
     return ret;
 }
@@ -1245,7 +1326,7 @@ static int forward_status_change(AVFilterContext *filter, FilterLinkInternal *li
             out = 0;
         }
     }
-    ff_filter_set_ready(filter, 200);
+    filter_set_ready(filter, 200);
     return 0;
 }
 
@@ -1428,14 +1509,21 @@ int ff_filter_activate(AVFilterContext *filter)
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
     ctxi->ready = 0;
-    ret = filter->filter->activate ? filter->filter->activate(filter) :
-          filter_activate_default(filter);
+    if (!filter->filter->activate) {
+        ret = filter_activate_default(filter);
+    } else if (!(filter->filter->flags_internal & FF_FILTER_FLAG_CONCURRENT_ACTIVATE)) {
+        ret = filter->filter->activate(filter);
+    } else {
+        ff_filter_unlock_graph(filter);
+        ret = filter->filter->activate(filter);
+        ff_filter_lock_graph(filter);
+    }
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
 }
 
-int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
+static int inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     *rpts = li->l.current_pts;
@@ -1451,32 +1539,52 @@ int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts
     return 1;
 }
 
+int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
+{
+    int locked = filter_lock(link->dst);
+    int ret = inlink_acknowledge_status(link, rstatus, rpts);
+    filter_unlock(link->dst, locked);
+    return ret;
+}
+
 size_t ff_inlink_queued_frames(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_frames(&li->fifo);
+    int locked = filter_lock(link->dst);
+    size_t ret = ff_framequeue_queued_frames(&li->fifo);
+    filter_unlock(link->dst, locked);
+    return ret;
 }
 
 int ff_inlink_check_available_frame(AVFilterLink *link)
 {
-    FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_frames(&li->fifo) > 0;
+    return ff_inlink_queued_frames(link) > 0;
 }
 
 int ff_inlink_queued_samples(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_samples(&li->fifo);
+    int locked = filter_lock(link->dst);
+    int ret = ff_framequeue_queued_samples(&li->fifo);
+    filter_unlock(link->dst, locked);
+    return ret;
 }
 
-int ff_inlink_check_available_samples(AVFilterLink *link, unsigned min)
+static int inlink_check_available_samples(FilterLinkInternal *li, unsigned min)
 {
-    FilterLinkInternal * const li = ff_link_internal(link);
     uint64_t samples = ff_framequeue_queued_samples(&li->fifo);
     av_assert1(min);
     return samples >= min || (li->status_in && samples);
 }
 
+int ff_inlink_check_available_samples(AVFilterLink *link, unsigned min)
+{
+    int locked = filter_lock(link->dst);
+    int ret = inlink_check_available_samples(ff_link_internal(link), min);
+    filter_unlock(link->dst, locked);
+    return ret;
+}
+
 static void consume_update(FilterLinkInternal *li, const AVFrame *frame)
 {
     AVFilterLink *const link = &li->l.pub;
@@ -1488,51 +1596,71 @@ static void consume_update(FilterLinkInternal *li, const AVFrame *frame)
     li->l.sample_count_out += frame->nb_samples;
 }
 
-int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
+static int inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
+                                  AVFrame **rframe)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     AVFrame *frame;
+    int ret;
 
+    av_assert1(min);
     *rframe = NULL;
-    if (!ff_inlink_check_available_frame(link))
+    if (!inlink_check_available_samples(li, min))
         return 0;
-
-    if (li->fifo.samples_skipped) {
-        frame = ff_framequeue_peek(&li->fifo, 0);
-        return ff_inlink_consume_samples(link, frame->nb_samples, frame->nb_samples, rframe);
-    }
-
-    frame = ff_framequeue_take(&li->fifo);
+    if (li->status_in)
+        min = FFMIN(min, ff_framequeue_queued_samples(&li->fifo));
+    ret = take_samples(li, min, max, &frame);
+    if (ret < 0)
+        return ret;
     consume_update(li, frame);
     *rframe = frame;
     return 1;
 }
 
-int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
-                            AVFrame **rframe)
+static int inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     AVFrame *frame;
-    int ret;
 
-    av_assert1(min);
     *rframe = NULL;
-    if (!ff_inlink_check_available_samples(link, min))
+    if (!ff_framequeue_queued_frames(&li->fifo))
         return 0;
-    if (li->status_in)
-        min = FFMIN(min, ff_framequeue_queued_samples(&li->fifo));
-    ret = take_samples(li, min, max, &frame);
-    if (ret < 0)
-        return ret;
+
+    if (li->fifo.samples_skipped) {
+        frame = ff_framequeue_peek(&li->fifo, 0);
+        return inlink_consume_samples(link, frame->nb_samples, frame->nb_samples, rframe);
+    }
+
+    frame = ff_framequeue_take(&li->fifo);
     consume_update(li, frame);
     *rframe = frame;
     return 1;
 }
 
+int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
+{
+    int locked = filter_lock(link->dst);
+    int ret = inlink_consume_frame(link, rframe);
+    filter_unlock(link->dst, locked);
+    return ret;
+}
+
+int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
+                            AVFrame **rframe)
+{
+    int locked = filter_lock(link->dst);
+    int ret = inlink_consume_samples(link, min, max, rframe);
+    filter_unlock(link->dst, locked);
+    return ret;
+}
+
 AVFrame *ff_inlink_peek_frame(AVFilterLink *link, size_t idx)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_peek(&li->fifo, idx);
+    int locked = filter_lock(link->dst);
+    AVFrame *frame = ff_framequeue_peek(&li->fifo, idx);
+    filter_unlock(link->dst, locked);
+    return frame;
 }
 
 int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
@@ -1575,7 +1703,7 @@ int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
     return 0;
 }
 
-int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
+static void inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
 {
     FFFilterContext *ctxi = fffilterctx(link->dst);
     AVFilterCommand *cmd  = ctxi->command_queue;
@@ -1588,19 +1716,28 @@ int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
         command_queue_pop(link->dst);
         cmd = ctxi->command_queue;
     }
+}
+
+int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
+{
+    int locked = filter_lock(link->dst);
+    inlink_process_commands(link, frame);
+    filter_unlock(link->dst, locked);
     return 0;
 }
 
 void ff_inlink_request_frame(AVFilterLink *link)
 {
     av_unused FilterLinkInternal *li = ff_link_internal(link);
+    int locked = filter_lock(link->dst);
     av_assert1(!li->status_in);
     av_assert1(!li->status_out);
     li->frame_wanted_out = 1;
-    ff_filter_set_ready(link->src, 100);
+    filter_set_ready(link->src, 100);
+    filter_unlock(link->dst, locked);
 }
 
-void ff_inlink_set_status(AVFilterLink *link, int status)
+static void inlink_set_status(AVFilterLink *link, int status)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
     if (li->status_out)
@@ -1616,18 +1753,32 @@ void ff_inlink_set_status(AVFilterLink *link, int status)
         li->status_in = status;
 }
 
+void ff_inlink_set_status(AVFilterLink *link, int status)
+{
+    int locked = filter_lock(link->dst);
+    inlink_set_status(link, status);
+    filter_unlock(link->dst, locked);
+}
+
 int ff_outlink_get_status(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return li->status_in;
+    int locked = filter_lock(link->src);
+    int ret = li->status_in;
+    filter_unlock(link->src, locked);
+    return ret;
 }
 
 int ff_inoutlink_check_flow(AVFilterLink *inlink, AVFilterLink *outlink)
 {
-    FilterLinkInternal * const li_in = ff_link_internal(inlink);
-    return ff_outlink_frame_wanted(outlink) ||
-           ff_inlink_check_available_frame(inlink) ||
-           li_in->status_out;
+    FilterLinkInternal * const li_in  = ff_link_internal(inlink);
+    FilterLinkInternal * const li_out = ff_link_internal(outlink);
+    int locked = filter_lock(inlink->dst);
+    int ret = li_out->frame_wanted_out ||
+              ff_framequeue_queued_frames(&li_in->fifo) ||
+              li_in->status_out;
+    filter_unlock(inlink->dst, locked);
+    return ret;
 }
 
 
@@ -1661,7 +1812,10 @@ int ff_filter_init_hw_frames(AVFilterContext *avctx, AVFilterLink *link,
 int ff_outlink_frame_wanted(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return li->frame_wanted_out;
+    int locked = filter_lock(link->src);
+    int ret = li->frame_wanted_out;
+    filter_unlock(link->src, locked);
+    return ret;
 }
 
 int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -453,6 +453,18 @@ unsigned avfilter_filter_pad_count(const AVFilter *filter, int is_output);
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Run different filters of a graph concurrently, so that successive frames
+ * are processed by successive filters of a chain at the same time.
+ *
+ * Only meaningful in AVFilterGraph.thread_type, and must be set before
+ * avfilter_graph_config() is called. When enabled, the public buffersrc,
+ * buffersink and command APIs of the graph must still be called from a
+ * single thread at a time. The threads allowed by AVFilterGraph.nb_threads
+ * are shared between the pipeline and slice threading.
+ */
+#define AVFILTER_THREAD_PIPELINE (1 << 1)
+
 /** An instance of a filter */
 struct AVFilterContext {
     const AVClass *av_class;        ///< needed for av_log() and filters common options
@@ -828,6 +840,20 @@ typedef struct AVFilterGraph {
     avfilter_execute_func *execute;
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
+
+    /**
+     * A reference to a thread pool from av_thread_pool_alloc(). When set,
+     * slice threaded filters run their jobs on the threads of this pool,
+     * which may be shared with other graphs and codecs, instead of threads
+     * created for this graph. nb_threads still limits the number of threads
+     * working on one filter at once. The pool is also used by the scalers
+     * of the scale filters in this graph.
+     *
+     * Must be set before the first filter is added to the graph. The graph
+     * takes ownership of the reference and unreferences it in
+     * avfilter_graph_free().
+     */
+    AVBufferRef *thread_pool;
 } AVFilterGraph;
 
 /**
@@ -110,6 +110,18 @@ typedef struct FFFilterContext {
      */
     unsigned ready;
 
+    /**
+     * Pipelined graph threading: set while the filter is being activated,
+     * so that no other thread activates it at the same time.
+     */
+    unsigned busy;
+
+    /**
+     * Pipelined graph threading: set while a callback of the filter runs
+     * without holding the graph lock.
+     */
+    unsigned unlocked;
+
     ///< parsed expression
     struct AVExpr *enable;
     ///< variable values for the enable expression
@@ -145,6 +157,12 @@ typedef struct FFFilterGraph {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Pipelined threading state, NULL unless AVFILTER_THREAD_PIPELINE is
+     * in use. See pthread.c.
+     */
+    struct PipelineContext *pipeline;
 } FFFilterGraph;
 
 static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
@@ -192,6 +210,59 @@ int ff_graph_thread_init(FFFilterGraph *graph);
 
 void ff_graph_thread_free(FFFilterGraph *graph);
 
+/**
+ * Start the pipelined scheduler worker threads if AVFILTER_THREAD_PIPELINE
+ * is enabled for the graph and supported by all its filters. Must be called
+ * once the graph is fully configured.
+ */
+int ff_graph_pipeline_init(FFFilterGraph *graph);
+
+void ff_graph_pipeline_free(FFFilterGraph *graph);
+
+/**
+ * Run one round of processing on a graph with pipelined threading.
+ * Must be called with the graph lock held.
+ */
+int ff_graph_pipeline_run_once(FFFilterGraph *graph);
+
+/**
+ * Notify the pipelined scheduler that a filter became ready.
+ * Must be called with the graph lock held.
+ */
+void ff_graph_pipeline_wake(FFFilterGraph *graph);
+
+/**
+ * Wait until no filter of the graph is being activated and prevent further
+ * activations by the worker threads until ff_graph_pipeline_resume().
+ * Must be called with the graph lock held.
+ */
+void ff_graph_pipeline_pause(FFFilterGraph *graph);
+void ff_graph_pipeline_resume(FFFilterGraph *graph);
+
+/**
+ * Acquire/release the graph lock on behalf of the caller of the public API.
+ * Calls may be nested. No-ops unless pipelined threading is active.
+ */
+void ff_graph_lock(AVFilterGraph *graph);
+void ff_graph_unlock(AVFilterGraph *graph);
+
+/**
+ * Release the graph lock while a callback of the filter runs, and acquire it
+ * again afterwards. Link functions called from within the callback on behalf
+ * of the filter reacquire the lock temporarily, see FFFilterContext.unlocked.
+ * No-ops unless pipelined threading is active.
+ */
+void ff_filter_unlock_graph(AVFilterContext *ctx);
+void ff_filter_lock_graph(AVFilterContext *ctx);
+
+/**
+ * Serialize access to the link frame pools, which may be reached from
+ * several filters through pass-through get_buffer callbacks.
+ * No-ops unless pipelined threading is active.
+ */
+void ff_graph_pool_lock(AVFilterGraph *graph);
+void ff_graph_pool_unlock(AVFilterGraph *graph);
+
 /**
  * Negotiate the media format, dimensions, etc of all inputs to a filter.
  *
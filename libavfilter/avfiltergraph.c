@@ -48,7 +48,8 @@
 static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, .unit = "thread_type" },
-        { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "slice",    NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE    }, .flags = F|V|A, .unit = "thread_type" },
+        { "pipeline", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_PIPELINE }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, F|V|A, .unit = "threads"},
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = F|V|A, .unit = "threads"},
@@ -78,6 +79,57 @@ int ff_graph_thread_init(FFFilterGraph *graph)
     graph->p.nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_pipeline_init(FFFilterGraph *graph)
+{
+    graph->p.thread_type &= ~AVFILTER_THREAD_PIPELINE;
+    return 0;
+}
+
+void ff_graph_pipeline_free(FFFilterGraph *graph)
+{
+}
+
+int ff_graph_pipeline_run_once(FFFilterGraph *graph)
+{
+    return AVERROR_BUG;
+}
+
+void ff_graph_pipeline_wake(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_pause(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_resume(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_lock(AVFilterGraph *graph)
+{
+}
+
+void ff_graph_unlock(AVFilterGraph *graph)
+{
+}
+
+void ff_filter_unlock_graph(AVFilterContext *ctx)
+{
+}
+
+void ff_filter_lock_graph(AVFilterContext *ctx)
+{
+}
+
+void ff_graph_pool_lock(AVFilterGraph *graph)
+{
+}
+
+void ff_graph_pool_unlock(AVFilterGraph *graph)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -122,10 +174,13 @@ void avfilter_graph_free(AVFilterGraph **graphp)
     if (!graph)
         return;
 
+    ff_graph_pipeline_free(graphi);
+
     while (graph->nb_filters)
         avfilter_free(graph->filters[0]);
 
     ff_graph_thread_free(graphi);
+    av_buffer_unref(&graph->thread_pool);
 
     av_freep(&graphi->sink_links);
 
@@ -1305,19 +1360,18 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_pipeline_init(fffiltergraph(graphctx))) < 0)
+        return ret;
 
     return 0;
 }
 
-int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
+static int graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
     int i, r = AVERROR(ENOSYS);
 
-    if (!graph)
-        return r;
-
     if ((flags & AVFILTER_CMD_FLAG_ONE) && !(flags & AVFILTER_CMD_FLAG_FAST)) {
-        r = avfilter_graph_send_command(graph, target, cmd, arg, res, res_len, flags | AVFILTER_CMD_FLAG_FAST);
+        r = graph_send_command(graph, target, cmd, arg, res, res_len, flags | AVFILTER_CMD_FLAG_FAST);
         if (r != AVERROR(ENOSYS))
             return r;
     }
@@ -1339,12 +1393,31 @@ int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const
     return r;
 }
 
-int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
-    int i;
+    FFFilterGraph *graphi;
+    int r;
 
-    if(!graph)
-        return 0;
+    if (!graph)
+        return AVERROR(ENOSYS);
+
+    graphi = fffiltergraph(graph);
+    if (!graphi->pipeline)
+        return graph_send_command(graph, target, cmd, arg, res, res_len, flags);
+
+    /* the target filters must not be running while their state changes */
+    ff_graph_lock(graph);
+    ff_graph_pipeline_pause(graphi);
+    r = graph_send_command(graph, target, cmd, arg, res, res_len, flags);
+    ff_graph_pipeline_resume(graphi);
+    ff_graph_unlock(graph);
+
+    return r;
+}
+
+static int graph_queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+{
+    int i;
 
     for (i = 0; i < graph->nb_filters; i++) {
         AVFilterContext *filter = graph->filters[i];
@@ -1371,6 +1444,20 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
     return 0;
 }
 
+int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+{
+    int ret;
+
+    if(!graph)
+        return 0;
+
+    ff_graph_lock(graph);
+    ret = graph_queue_command(graph, target, command, arg, flags, ts);
+    ff_graph_unlock(graph);
+
+    return ret;
+}
+
 static void heap_bubble_up(FFFilterGraph *graph,
                            FilterLinkInternal *li, int index)
 {
@@ -1422,7 +1509,7 @@ void ff_avfilter_graph_update_heap(AVFilterGraph *graph, FilterLinkInternal *li)
     heap_bubble_down(graphi, li, li->age_index);
 }
 
-int avfilter_graph_request_oldest(AVFilterGraph *graph)
+static int graph_request_oldest(AVFilterGraph *graph)
 {
     FFFilterGraph *graphi = fffiltergraph(graph);
     FilterLinkInternal *oldesti = graphi->sink_links[0];
@@ -1469,12 +1556,26 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+int avfilter_graph_request_oldest(AVFilterGraph *graph)
+{
+    int ret;
+
+    ff_graph_lock(graph);
+    ret = graph_request_oldest(graph);
+    ff_graph_unlock(graph);
+
+    return ret;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
+    FFFilterGraph *graphi = fffiltergraph(graph);
     FFFilterContext *ctxi;
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (graphi->pipeline)
+        return ff_graph_pipeline_run_once(graphi);
     ctxi = fffilterctx(graph->filters[0]);
     for (i = 1; i < graph->nb_filters; i++) {
         FFFilterContext *ctxi_other = fffilterctx(graph->filters[i]);
@@ -141,14 +141,26 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
 
 int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
-    return get_frame_internal(ctx, frame, flags,
-                              ff_filter_link(ctx->inputs[0])->min_samples);
+    int ret;
+
+    ff_graph_lock(ctx->graph);
+    ret = get_frame_internal(ctx, frame, flags,
+                             ff_filter_link(ctx->inputs[0])->min_samples);
+    ff_graph_unlock(ctx->graph);
+
+    return ret;
 }
 
 int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
                                                   AVFrame *frame, int nb_samples)
 {
-    return get_frame_internal(ctx, frame, 0, nb_samples);
+    int ret;
+
+    ff_graph_lock(ctx->graph);
+    ret = get_frame_internal(ctx, frame, 0, nb_samples);
+    ff_graph_unlock(ctx->graph);
+
+    return ret;
 }
 
 static av_cold int common_init(AVFilterContext *ctx)
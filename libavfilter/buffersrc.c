@@ -189,7 +189,16 @@ static int push_frame(AVFilterGraph *graph)
     return 0;
 }
 
-int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+static int buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    s->eof = 1;
+    ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
+    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
+}
+
+static int add_frame(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
     BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
@@ -198,7 +207,7 @@ int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFra
     s->nb_failed_requests = 0;
 
     if (!frame)
-        return av_buffersrc_close(ctx, s->last_pts, flags);
+        return buffersrc_close(ctx, s->last_pts, flags);
     if (s->eof)
         return AVERROR_EOF;
 
@@ -274,13 +283,26 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return 0;
 }
 
+int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+{
+    int ret;
+
+    ff_graph_lock(ctx->graph);
+    ret = add_frame(ctx, frame, flags);
+    ff_graph_unlock(ctx->graph);
+
+    return ret;
+}
+
 int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
-    BufferSourceContext *s = ctx->priv;
+    int ret;
 
-    s->eof = 1;
-    ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
-    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
+    ff_graph_lock(ctx->graph);
+    ret = buffersrc_close(ctx, pts, flags);
+    ff_graph_unlock(ctx->graph);
+
+    return ret;
 }
 
 static av_cold int init_video(AVFilterContext *ctx)
@@ -318,7 +340,13 @@ static av_cold int init_video(AVFilterContext *ctx)
 
 unsigned av_buffersrc_get_nb_failed_requests(AVFilterContext *buffer_src)
 {
-    return ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    unsigned ret;
+
+    ff_graph_lock(buffer_src->graph);
+    ret = ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    ff_graph_unlock(buffer_src->graph);
+
+    return ret;
 }
 
 #define OFFSET(x) offsetof(BufferSourceContext, x)
@@ -563,6 +591,7 @@ const AVFilter ff_vsrc_buffer = {
     .name      = "buffer",
     .description = NULL_IF_CONFIG_SMALL("Buffer video frames, and make them accessible to the filterchain."),
     .priv_size = sizeof(BufferSourceContext),
+    .flags_internal = FF_FILTER_FLAG_EXTERNAL_SOURCE,
     .activate  = activate,
     .init      = init_video,
     .uninit    = uninit,
@@ -585,6 +614,7 @@ const AVFilter ff_asrc_abuffer = {
     .name          = "abuffer",
     .description   = NULL_IF_CONFIG_SMALL("Buffer audio frames, and make them accessible to the filterchain."),
     .priv_size     = sizeof(BufferSourceContext),
+    .flags_internal = FF_FILTER_FLAG_EXTERNAL_SOURCE,
     .activate  = activate,
     .init      = init_audio,
     .uninit    = uninit,
@@ -21,6 +21,7 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/csp.h"
@@ -92,6 +93,15 @@ int ff_fill_ayuv_map(uint8_t *ayuv_map, enum AVPixelFormat pix_fmt)
     return fill_map(desc, ayuv_map);
 }
 
+static void blend_row8_c(uint8_t *dst, const uint8_t *mask, int w,
+                         unsigned src, unsigned alpha)
+{
+    for (int x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+    }
+}
+
 int ff_draw_init2(FFDrawContext *draw, enum AVPixelFormat format, enum AVColorSpace csp,
                   enum AVColorRange range, unsigned flags)
 {
@@ -160,6 +170,10 @@ int ff_draw_init2(FFDrawContext *draw, enum AVPixelFormat format, enum AVColorSp
     memcpy(draw->pixelstep, pixelstep, sizeof(draw->pixelstep));
     draw->hsub[1] = draw->hsub[2] = draw->hsub_max = desc->log2_chroma_w;
     draw->vsub[1] = draw->vsub[2] = draw->vsub_max = desc->log2_chroma_h;
+    draw->blend_row8 = blend_row8_c;
+#if ARCH_X86
+    ff_draw_init_x86(draw);
+#endif
     return 0;
 }
 
@@ -607,7 +621,19 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                 p += dst_linesize[plane];
                 m += top * mask_linesize;
             }
-            if (depth <= 8) {
+            if (depth <= 8 && l2depth == 3 && draw->pixelstep[plane] == 1 &&
+                !draw->hsub[plane] && !draw->vsub[plane]) {
+                const int w16 = w_sub & ~15;
+                for (y = 0; y < h_sub; y++) {
+                    if (w16)
+                        draw->blend_row8(p, m + xm0, w16,
+                                         color->comp[plane].u8[index], alpha);
+                    blend_row8_c(p + w16, m + xm0 + w16, w_sub - w16,
+                                 color->comp[plane].u8[index], alpha);
+                    p += dst_linesize[plane];
+                    m += mask_linesize;
+                }
+            } else if (depth <= 8) {
                 for (y = 0; y < h_sub; y++) {
                     blend_line_hv(p, draw->pixelstep[plane],
                                   color->comp[plane].u8[index], alpha,
@@ -46,6 +46,15 @@ typedef struct FFDrawContext {
     unsigned flags;
     enum AVColorSpace csp;
     double rgb2yuv[3][3];
+
+    /**
+     * Blend an 8-bit mask onto a line of 8-bit samples without subsampling
+     * and with a pixelstep of 1:
+     * dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24, a = mask[x] * alpha
+     * w must be a multiple of 16.
+     */
+    void (*blend_row8)(uint8_t *dst, const uint8_t *mask, int w,
+                       unsigned src, unsigned alpha);
 } FFDrawContext;
 
 typedef struct FFDrawColor {
@@ -164,4 +173,6 @@ int ff_draw_round_to_sub(FFDrawContext *draw, int sub_dir, int round_dir,
  */
 AVFilterFormats *ff_draw_supported_pixel_formats(unsigned flags);
 
+void ff_draw_init_x86(FFDrawContext *draw);
+
 #endif /* AVFILTER_DRAWUTILS_H */
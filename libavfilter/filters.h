@@ -205,6 +205,28 @@ static inline FilterLink* ff_filter_link(AVFilterLink *link)
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter is a source whose frames are supplied by the caller through the
+ * public API (buffersrc); used by the pipelined graph scheduler to decide
+ * when to return control to the caller so that it can supply more input.
+ */
+#define FF_FILTER_FLAG_EXTERNAL_SOURCE (1 << 1)
+
+/**
+ * The filter sends commands to other filters of its graph while processing
+ * frames; pipelined graph threading is disabled when such a filter is present.
+ */
+#define FF_FILTER_FLAG_GRAPH_COMMANDS (1 << 2)
+
+/**
+ * The activate callback of the filter only reaches its links through the
+ * ff_inlink_*(), ff_outlink_*() and ff_filter_frame() functions, and no
+ * state shared with other filters or with the caller of the graph, so that
+ * with pipelined graph threading it can run without the graph lock,
+ * concurrently with other filters.
+ */
+#define FF_FILTER_FLAG_CONCURRENT_ACTIVATE (1 << 3)
+
 /**
  * Find the index of a link.
  *
@@ -532,6 +554,14 @@ int ff_filter_process_command(AVFilterContext *ctx, const char *cmd,
  */
 int ff_filter_get_nb_threads(AVFilterContext *ctx) av_pure;
 
+/**
+ * Get the number of jobs to split nb_units (e.g. rows) of work into, for
+ * work whose cost varies strongly between the units. Using several jobs
+ * per thread lets the slice threads even out the load.
+ * This number is always same or less than nb_units.
+ */
+int ff_filter_get_nb_jobs(AVFilterContext *ctx, int nb_units) av_pure;
+
 /**
  * Send a frame of data to the next filter.
  *
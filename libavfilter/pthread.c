@@ -23,13 +23,48 @@
 
 #include <stddef.h>
 
+#include "libavutil/cpu.h"
 #include "libavutil/error.h"
+#include "libavutil/log.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
 
 #include "avfilter.h"
 #include "avfilter_internal.h"
+#include "filters.h"
+#include "framequeue.h"
+
+/**
+ * Number of frames queued on an output link above which the pipelined
+ * scheduler stops activating the link source, unless nothing else can run.
+ */
+#define PIPELINE_MAX_QUEUED 2
+
+typedef struct PipelineContext {
+    /**
+     * Protects all link and scheduling state of the graph: link FIFOs and
+     * statuses, FFFilterContext.ready/busy, and the fields below.
+     */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    pthread_mutex_t pool_lock;
+    pthread_mutex_t execute_lock;
+
+    pthread_t      *workers;
+    int             nb_workers;
+
+    int             nb_busy;
+    unsigned        generation;
+    int             error;
+    int             quit;
+    int             paused;
+
+    /* nesting level of ff_graph_lock(), only accessed by the caller thread */
+    int             caller_depth;
+} PipelineContext;
 
 typedef struct ThreadContext {
     AVFilterGraph *graph;
@@ -58,22 +93,53 @@ static void slice_thread_uninit(ThreadContext *c)
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
                           void *arg, int *ret, int nb_jobs)
 {
-    ThreadContext *c = fffiltergraph(ctx->graph)->thread;
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+    ThreadContext *c = graphi->thread;
 
     if (nb_jobs <= 0)
         return 0;
+
+    /* all threads of the graph are used by the pipeline */
+    if (!c->thread) {
+        for (int i = 0; i < nb_jobs; i++) {
+            int r = func(ctx, arg, i, nb_jobs);
+            if (ret)
+                ret[i] = r;
+        }
+        return 0;
+    }
+
+    /* the slice thread pool is shared by all filters of the graph */
+    if (graphi->pipeline)
+        pthread_mutex_lock(&graphi->pipeline->execute_lock);
+
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+
+    if (graphi->pipeline)
+        pthread_mutex_unlock(&graphi->pipeline->execute_lock);
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
-    nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
+    if (c->graph->thread_pool)
+        nb_threads = avpriv_slicethread_create_shared(&c->thread, c, worker_func,
+                                                      nb_threads, c->graph->thread_pool);
+    else
+        nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
+    if (nb_threads > 1) {
+        /* filter jobs never wait for each other */
+        int ret = avpriv_slicethread_enable_work_stealing(c->thread);
+        if (ret < 0) {
+            avpriv_slicethread_free(&c->thread);
+            return ret;
+        }
+    }
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
     return FFMAX(nb_threads, 1);
@@ -82,6 +148,7 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
 int ff_graph_thread_init(FFFilterGraph *graphi)
 {
     AVFilterGraph *graph = &graphi->p;
+    ThreadContext *c;
     int ret;
 
     if (graph->nb_threads == 1) {
@@ -89,11 +156,12 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
         return 0;
     }
 
-    graphi->thread = av_mallocz(sizeof(ThreadContext));
-    if (!graphi->thread)
+    graphi->thread = c = av_mallocz(sizeof(ThreadContext));
+    if (!c)
         return AVERROR(ENOMEM);
+    c->graph = graph;
 
-    ret = thread_init_internal(graphi->thread, graph->nb_threads);
+    ret = thread_init_internal(c, graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graphi->thread);
         graph->thread_type = 0;
@@ -113,3 +181,346 @@ void ff_graph_thread_free(FFFilterGraph *graph)
         slice_thread_uninit(graph->thread);
     av_freep(&graph->thread);
 }
+
+static int outputs_congested(const AVFilterContext *ctx)
+{
+    for (unsigned i = 0; i < ctx->nb_outputs; i++) {
+        FilterLinkInternal * const li = ff_link_internal(ctx->outputs[i]);
+        if (ff_framequeue_queued_frames(&li->fifo) >= PIPELINE_MAX_QUEUED)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Select the most urgent filter that is ready and not already being
+ * activated by another thread. With throttle set, filters whose outputs
+ * already hold enough queued frames are skipped.
+ */
+static FFFilterContext *pick_filter(AVFilterGraph *graph, int throttle)
+{
+    FFFilterContext *best = NULL;
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        FFFilterContext *ctxi = fffilterctx(graph->filters[i]);
+
+        if (!ctxi->ready || ctxi->busy || (best && ctxi->ready <= best->ready))
+            continue;
+        if (throttle && outputs_congested(&ctxi->p))
+            continue;
+        best = ctxi;
+    }
+    return best;
+}
+
+/**
+ * @return 1 if the graph waits for input from the caller, i.e. a frame was
+ *         requested from a caller-fed source and none of them still has a
+ *         frame waiting to be processed
+ */
+static int input_wanted(AVFilterGraph *graph)
+{
+    int wanted = 0;
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *ctx = graph->filters[i];
+        FilterLinkInternal *li;
+
+        if (!(ctx->filter->flags_internal & FF_FILTER_FLAG_EXTERNAL_SOURCE) ||
+            !ctx->nb_outputs)
+            continue;
+        li = ff_link_internal(ctx->outputs[0]);
+        if (li->status_in)
+            continue;
+        if (ff_framequeue_queued_frames(&li->fifo))
+            return 0;
+        wanted |= li->frame_wanted_out;
+    }
+    return wanted;
+}
+
+static int activate_filter(PipelineContext *p, FFFilterContext *ctxi)
+{
+    int ret;
+
+    ctxi->busy = 1;
+    p->nb_busy++;
+
+    ret = ff_filter_activate(&ctxi->p);
+
+    ctxi->busy = 0;
+    p->nb_busy--;
+    p->generation++;
+    pthread_cond_broadcast(&p->cond);
+
+    return ret;
+}
+
+static void *attribute_align_arg pipeline_worker(void *arg)
+{
+    FFFilterGraph *graphi = arg;
+    PipelineContext *p = graphi->pipeline;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        FFFilterContext *ctxi = p->error < 0 || p->paused ? NULL :
+                                pick_filter(&graphi->p, 1);
+        int ret;
+
+        if (!ctxi) {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+
+        ret = activate_filter(p, ctxi);
+        if (ret < 0 && p->error >= 0)
+            p->error = ret;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+int ff_graph_pipeline_run_once(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+    PipelineContext *p = graphi->pipeline;
+    FFFilterContext *ctxi;
+    unsigned generation;
+
+    if (p->error < 0) {
+        int ret = p->error;
+        p->error = 0;
+        return ret;
+    }
+
+    /* The calling thread takes part in the processing; throttling is only
+     * applied while other activations are in flight, which guarantees that
+     * the graph can always make progress. */
+    ctxi = pick_filter(graph, p->nb_busy > 0);
+    if (ctxi)
+        return activate_filter(p, ctxi);
+
+    if (!p->nb_busy)
+        return AVERROR(EAGAIN);
+
+    /* Let the caller supply the next frame while earlier ones are still
+     * being processed, as long as a worker is available to take it and the
+     * graph asked for it. Otherwise wait for the work in flight, which may
+     * produce output for the sinks, instead of returning to the caller with
+     * frames still being processed. */
+    if (p->nb_busy < p->nb_workers && input_wanted(graph))
+        return AVERROR(EAGAIN);
+
+    generation = p->generation;
+    while (generation == p->generation)
+        pthread_cond_wait(&p->cond, &p->lock);
+
+    return 0;
+}
+
+void ff_graph_pipeline_wake(FFFilterGraph *graphi)
+{
+    pthread_cond_broadcast(&graphi->pipeline->cond);
+}
+
+void ff_graph_pipeline_pause(FFFilterGraph *graphi)
+{
+    PipelineContext *p = graphi->pipeline;
+
+    p->paused++;
+    while (p->nb_busy)
+        pthread_cond_wait(&p->cond, &p->lock);
+}
+
+void ff_graph_pipeline_resume(FFFilterGraph *graphi)
+{
+    PipelineContext *p = graphi->pipeline;
+
+    if (!--p->paused)
+        pthread_cond_broadcast(&p->cond);
+}
+
+void ff_graph_lock(AVFilterGraph *graph)
+{
+    PipelineContext *p = fffiltergraph(graph)->pipeline;
+
+    if (p && !p->caller_depth++)
+        pthread_mutex_lock(&p->lock);
+}
+
+void ff_graph_unlock(AVFilterGraph *graph)
+{
+    PipelineContext *p = fffiltergraph(graph)->pipeline;
+
+    if (p && !--p->caller_depth)
+        pthread_mutex_unlock(&p->lock);
+}
+
+void ff_filter_unlock_graph(AVFilterContext *ctx)
+{
+    PipelineContext *p = fffiltergraph(ctx->graph)->pipeline;
+
+    if (!p)
+        return;
+    fffilterctx(ctx)->unlocked = 1;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void ff_filter_lock_graph(AVFilterContext *ctx)
+{
+    PipelineContext *p = fffiltergraph(ctx->graph)->pipeline;
+
+    if (!p)
+        return;
+    pthread_mutex_lock(&p->lock);
+    fffilterctx(ctx)->unlocked = 0;
+}
+
+void ff_graph_pool_lock(AVFilterGraph *graph)
+{
+    PipelineContext *p = graph ? fffiltergraph(graph)->pipeline : NULL;
+
+    if (p)
+        pthread_mutex_lock(&p->pool_lock);
+}
+
+void ff_graph_pool_unlock(AVFilterGraph *graph)
+{
+    PipelineContext *p = graph ? fffiltergraph(graph)->pipeline : NULL;
+
+    if (p)
+        pthread_mutex_unlock(&p->pool_lock);
+}
+
+static const char *pipeline_unsupported(AVFilterGraph *graph)
+{
+    if (graph->execute)
+        return "a custom execute callback is set";
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        const AVFilter *filter = graph->filters[i]->filter;
+
+        if (filter->flags_internal & FF_FILTER_FLAG_GRAPH_COMMANDS)
+            return filter->name;
+        /* legacy sinks are driven through avfilter_graph_request_oldest() */
+        if (!graph->filters[i]->nb_outputs && !filter->activate)
+            return filter->name;
+    }
+    return NULL;
+}
+
+int ff_graph_pipeline_init(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+    PipelineContext *p;
+    const char *unsupported;
+    int nb_threads, ret;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_PIPELINE) || graphi->pipeline)
+        return 0;
+
+    unsupported = pipeline_unsupported(graph);
+    if (unsupported) {
+        av_log(graph, AV_LOG_VERBOSE, "Pipelined threading disabled: %s\n",
+               unsupported);
+        graph->thread_type &= ~AVFILTER_THREAD_PIPELINE;
+        return 0;
+    }
+
+    nb_threads = graph->nb_threads > 0 ? graph->nb_threads : av_cpu_count();
+    nb_threads = FFMIN(nb_threads, graph->nb_filters);
+    if (nb_threads <= 1) {
+        graph->thread_type &= ~AVFILTER_THREAD_PIPELINE;
+        return 0;
+    }
+
+    /* The pipeline threads and the slice threads share the threads of the
+     * graph: only one slice execute runs at a time, on behalf of one of the
+     * pipeline threads, so that keeping the others for slices does not
+     * exceed nb_threads. */
+    if (graphi->thread) {
+        ThreadContext *c = graphi->thread;
+
+        slice_thread_uninit(c);
+        ret = thread_init_internal(c, graph->nb_threads - nb_threads + 1);
+        if (ret < 0)
+            return ret;
+        graph->nb_threads = ret;
+    }
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->workers = av_calloc(nb_threads - 1, sizeof(*p->workers));
+    if (!p->workers) {
+        av_free(p);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&p->lock, NULL))) {
+        av_freep(&p->workers);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_mutex_init(&p->pool_lock, NULL))) {
+        pthread_mutex_destroy(&p->lock);
+        av_freep(&p->workers);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_mutex_init(&p->execute_lock, NULL))) {
+        pthread_mutex_destroy(&p->pool_lock);
+        pthread_mutex_destroy(&p->lock);
+        av_freep(&p->workers);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&p->cond, NULL))) {
+        pthread_mutex_destroy(&p->execute_lock);
+        pthread_mutex_destroy(&p->pool_lock);
+        pthread_mutex_destroy(&p->lock);
+        av_freep(&p->workers);
+        av_free(p);
+        return AVERROR(ret);
+    }
+
+    graphi->pipeline = p;
+
+    for (int i = 0; i < nb_threads - 1; i++) {
+        ret = pthread_create(&p->workers[i], NULL, pipeline_worker, graphi);
+        if (ret) {
+            ff_graph_pipeline_free(graphi);
+            return AVERROR(ret);
+        }
+        p->nb_workers++;
+    }
+
+    av_log(graph, AV_LOG_VERBOSE, "Using %d threads for pipelined filtering "
+           "and %d for slices\n", nb_threads, graph->nb_threads);
+
+    return 0;
+}
+
+void ff_graph_pipeline_free(FFFilterGraph *graphi)
+{
+    PipelineContext *p = graphi->pipeline;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 0; i < p->nb_workers; i++)
+        pthread_join(p->workers[i], NULL);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->execute_lock);
+    pthread_mutex_destroy(&p->pool_lock);
+    pthread_mutex_destroy(&p->lock);
+    av_freep(&p->workers);
+    av_freep(&graphi->pipeline);
+}
@@ -141,6 +141,7 @@ const AVFilter ff_vf_split = {
     FILTER_INPUTS(ff_video_default_filterpad),
     .outputs     = NULL,
     .flags       = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_METADATA_ONLY,
+    .flags_internal = FF_FILTER_FLAG_CONCURRENT_ACTIVATE,
 };
 
 const AVFilter ff_af_asplit = {
@@ -153,4 +154,5 @@ const AVFilter ff_af_asplit = {
     FILTER_INPUTS(ff_audio_default_filterpad),
     .outputs     = NULL,
     .flags       = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_METADATA_ONLY,
+    .flags_internal = FF_FILTER_FLAG_CONCURRENT_ACTIVATE,
 };
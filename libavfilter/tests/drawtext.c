@@ -0,0 +1,237 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Draws text that changes from frame to frame, in its content, position,
+ * size or through commands, and checks that every frame drawn by one filter
+ * instance, which reuses its cached text layer, is the same as the frame
+ * drawn by a new instance that renders the text from scratch.
+ *
+ * The output depends on the font, so only the number of frames checked is
+ * printed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define WIDTH  160
+#define HEIGHT 96
+#define FRAMES 12
+
+typedef struct Command {
+    int frame;          ///< the frame before which the command is sent
+    const char *cmd;
+    const char *arg;
+} Command;
+
+typedef struct TestCase {
+    const char *name;
+    const char *format; ///< the format the text is drawn on, if not yuv420p
+    const char *opts;   ///< the options of drawtext
+    Command cmds[3];
+} TestCase;
+
+static const TestCase tests[] = {
+    { "static",   NULL,   "text=FFmpeg:x=12:y=20:box=1:boxborderw=4:borderw=1" },
+    { "counter",  NULL,   "text=%{n}:x=8:y=8:fontsize=24:borderw=1:shadowx=2:shadowy=2" },
+    { "expr",     NULL,   "text=%{eif\\:n*n\\:d}:x=(w-tw)/2:y=(h-th)/2:box=1" },
+    { "moving",   NULL,   "text=moving:x=n*9-20:y=10+mod(n,4)*17:box=1:shadowx=-2" },
+    { "fontsize", NULL,   "text=size:x=4:y=4:fontsize=14+4*mod(n,3):borderw=2" },
+    { "alpha",    NULL,   "text=fade %{n}:x=10:y=30:alpha=1-n/16:box=1" },
+    { "command",  NULL,   "text=cmd:x=10:y=10:fontsize=20",
+      { { 3, "borderw", "3" }, { 6, "text", "changed" }, { 9, "shadowx", "4" } } },
+    { "gbrp",     "gbrp", "text=planes %{n}:x=n*5:y=40:fontsize=30:borderw=1" },
+};
+
+static AVFrame *make_frame(int n)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width  = WIDTH;
+    frame->height = HEIGHT;
+    frame->pts    = n;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+    for (int p = 0; p < 3; p++) {
+        const int w = p ? WIDTH  / 2 : WIDTH;
+        const int h = p ? HEIGHT / 2 : HEIGHT;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                frame->data[p][y * frame->linesize[p] + x] = x * 3 + y * 5 + p * 60 + n * 7;
+    }
+    return frame;
+}
+
+static void hash_frame(const AVFrame *frame, uint8_t md5[16])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    struct AVMD5 *ctx = av_md5_alloc();
+
+    av_md5_init(ctx);
+    for (int p = 0; p < 4 && frame->data[p]; p++) {
+        const int w = av_image_get_linesize(frame->format, frame->width, p);
+        const int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                       : frame->height;
+        for (int y = 0; y < h; y++)
+            av_md5_update(ctx, frame->data[p] + y * frame->linesize[p], w);
+    }
+    av_md5_final(ctx, md5);
+    av_free(ctx);
+}
+
+/**
+ * Draw the frames first to last with one filter instance, sending the
+ * commands of the test on the way, or only the frame first with a new
+ * instance that starts with the options set by the commands so far.
+ * The MD5 of each output frame is stored in md5.
+ */
+static int run(const TestCase *test, int first, int last, int nb_threads,
+               uint8_t md5[][16])
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *src = NULL, *sink = NULL, *format = NULL, *drawtext = NULL;
+    AVFrame *frame = NULL;
+    char args[512];
+    int ret = AVERROR(ENOMEM), nb_out = 0;
+
+    if (!graph)
+        goto end;
+    graph->nb_threads = nb_threads;
+
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=yuv420p:time_base=1/10",
+             WIDTH, HEIGHT);
+    ret = avfilter_graph_create_filter(&src, avfilter_get_by_name("buffer"),
+                                       "in", args, NULL, graph);
+    if (ret < 0)
+        goto end;
+    ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"),
+                                       "out", NULL, NULL, graph);
+    if (ret < 0)
+        goto end;
+    if (test->format) {
+        ret = avfilter_graph_create_filter(&format, avfilter_get_by_name("format"),
+                                           "format", test->format, NULL, graph);
+        if (ret < 0)
+            goto end;
+    }
+
+    snprintf(args, sizeof(args), "%s:start_number=%d", test->opts, first);
+    for (int i = 0; i < FF_ARRAY_ELEMS(test->cmds) && test->cmds[i].cmd; i++)
+        if (first == last && test->cmds[i].frame <= first)
+            av_strlcatf(args, sizeof(args), ":%s=%s", test->cmds[i].cmd, test->cmds[i].arg);
+    ret = avfilter_graph_create_filter(&drawtext, avfilter_get_by_name("drawtext"),
+                                       "drawtext", args, NULL, graph);
+    if (ret < 0)
+        goto end;
+
+    if ((ret = avfilter_link(src, 0, format ? format : drawtext, 0)) < 0 ||
+        (format && (ret = avfilter_link(format, 0, drawtext, 0)) < 0) ||
+        (ret = avfilter_link(drawtext, 0, sink, 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    for (int n = first; n <= last + 1; n++) {
+        if (n <= last) {
+            for (int i = 0; i < FF_ARRAY_ELEMS(test->cmds) && test->cmds[i].cmd; i++) {
+                if (first == last || test->cmds[i].frame != n)
+                    continue;
+                ret = avfilter_graph_send_command(graph, "drawtext", test->cmds[i].cmd,
+                                                  test->cmds[i].arg, NULL, 0, 0);
+                if (ret < 0)
+                    goto end;
+            }
+            ret = AVERROR(ENOMEM);
+            if (!(frame = make_frame(n)))
+                goto end;
+        }
+        ret = av_buffersrc_add_frame(src, frame);
+        av_frame_free(&frame);
+        if (ret < 0)
+            goto end;
+
+        if (!(frame = av_frame_alloc())) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+            if (nb_out > last - first) {
+                ret = AVERROR_BUG;
+                goto end;
+            }
+            hash_frame(frame, md5[nb_out++]);
+            av_frame_unref(frame);
+        }
+        av_frame_free(&frame);
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = nb_out == last - first + 1 ? 0 : AVERROR_BUG;
+
+end:
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    if (ret < 0)
+        fprintf(stderr, "%s: %s\n", test->name, av_err2str(ret));
+    return ret;
+}
+
+static int test(const TestCase *test)
+{
+    uint8_t md5[FRAMES][16], ref[16];
+
+    if (run(test, 0, FRAMES - 1, 4, md5) < 0)
+        return 1;
+
+    for (int n = 0; n < FRAMES; n++) {
+        if (run(test, n, n, 1, &ref) < 0)
+            return 1;
+        if (memcmp(md5[n], ref, sizeof(ref))) {
+            fprintf(stderr, "%s: frame %d differs from the one drawn from scratch\n",
+                    test->name, n);
+            return 1;
+        }
+    }
+
+    printf("%-10s %d frames\n", test->name, FRAMES);
+    return 0;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+        ret |= test(&tests[i]);
+
+    return ret;
+}
@@ -0,0 +1,235 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Feeds frames carrying cropping in their crop_* fields through the scale
+ * filter, once scaling and once with an identity conversion, and checks
+ * that the output is the same as for frames cropped beforehand.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define WIDTH  64
+#define HEIGHT 48
+#define FRAMES 3
+
+static AVFrame *make_frame(int n)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+    frame->format          = AV_PIX_FMT_YUV420P;
+    frame->width           = WIDTH;
+    frame->height          = HEIGHT;
+    frame->pts             = n;
+    frame->color_range     = AVCOL_RANGE_MPEG;
+    frame->colorspace      = AVCOL_SPC_BT709;
+    frame->chroma_location = AVCHROMA_LOC_CENTER;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+    for (int p = 0; p < 3; p++) {
+        const int w = p ? WIDTH  / 2 : WIDTH;
+        const int h = p ? HEIGHT / 2 : HEIGHT;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                frame->data[p][y * frame->linesize[p] + x] = x * 7 + y * 13 + p * 50 + n * 3;
+    }
+    return frame;
+}
+
+/* the same frame, either with the cropping in its fields or copied out */
+static AVFrame *make_cropped_frame(int n, int copy)
+{
+    AVFrame *frame = make_frame(n), *out;
+
+    if (!frame)
+        return NULL;
+    frame->crop_left   = 8;
+    frame->crop_right  = 12;
+    frame->crop_top    = 4;
+    frame->crop_bottom = 10;
+    if (!copy)
+        return frame;
+
+    if (av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED) < 0 ||
+        !(out = av_frame_alloc())) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+    out->format = frame->format;
+    out->width  = frame->width;
+    out->height = frame->height;
+    if (av_frame_get_buffer(out, 0) < 0 ||
+        av_frame_copy(out, frame) < 0 ||
+        av_frame_copy_props(out, frame) < 0)
+        av_frame_free(&out);
+    av_frame_free(&frame);
+    return out;
+}
+
+static void hash_frame(const AVFrame *frame, uint8_t md5[16])
+{
+    struct AVMD5 *ctx = av_md5_alloc();
+
+    av_md5_init(ctx);
+    for (int p = 0; p < 3; p++) {
+        const int w = p ? AV_CEIL_RSHIFT(frame->width,  1) : frame->width;
+        const int h = p ? AV_CEIL_RSHIFT(frame->height, 1) : frame->height;
+        for (int y = 0; y < h; y++)
+            av_md5_update(ctx, frame->data[p] + y * frame->linesize[p], w);
+    }
+    av_md5_final(ctx, md5);
+    av_free(ctx);
+}
+
+/**
+ * Run FRAMES frames through the filters, and store the MD5 of each output
+ * frame in md5. The properties of the last output frame are printed.
+ */
+static int run(const char *name, const char *filters, int copy,
+               uint8_t md5[FRAMES][16])
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *src = NULL, *sink = NULL;
+    AVFilterInOut *inputs = NULL, *outputs = NULL;
+    AVFrame *frame = NULL;
+    char args[256];
+    int ret = AVERROR(ENOMEM), nb_out = 0;
+
+    if (!graph)
+        goto end;
+    graph->nb_threads = 1;
+
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=yuv420p:time_base=1/25:"
+             "colorspace=bt709:range=tv", WIDTH, HEIGHT);
+    ret = avfilter_graph_create_filter(&src, avfilter_get_by_name("buffer"),
+                                       "in", args, NULL, graph);
+    if (ret < 0)
+        goto end;
+    ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"),
+                                       "out", NULL, NULL, graph);
+    if (ret < 0)
+        goto end;
+
+    ret = AVERROR(ENOMEM);
+    if (!(outputs = avfilter_inout_alloc()) || !(inputs = avfilter_inout_alloc()))
+        goto end;
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = src;
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = sink;
+    if (!outputs->name || !inputs->name)
+        goto end;
+
+    if ((ret = avfilter_graph_parse_ptr(graph, filters, &inputs, &outputs, NULL)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    for (int n = 0; n <= FRAMES; n++) {
+        if (n < FRAMES) {
+            ret = AVERROR(ENOMEM);
+            if (!(frame = make_cropped_frame(n, copy)))
+                goto end;
+        }
+        ret = av_buffersrc_add_frame(src, frame);
+        av_frame_free(&frame);
+        if (ret < 0)
+            goto end;
+
+        if (!(frame = av_frame_alloc())) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+            if (nb_out == FRAMES) {
+                ret = AVERROR_BUG;
+                goto end;
+            }
+            hash_frame(frame, md5[nb_out++]);
+            if (nb_out == FRAMES && !copy)
+                printf("%-10s %dx%d crop %"SIZE_SPECIFIER",%"SIZE_SPECIFIER",%"SIZE_SPECIFIER",%"SIZE_SPECIFIER
+                       " range %s space %s chroma_loc %s\n", name,
+                       frame->width, frame->height,
+                       frame->crop_top, frame->crop_bottom,
+                       frame->crop_left, frame->crop_right,
+                       av_color_range_name(frame->color_range),
+                       av_color_space_name(frame->colorspace),
+                       av_chroma_location_name(frame->chroma_location));
+            av_frame_unref(frame);
+        }
+        av_frame_free(&frame);
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = nb_out == FRAMES ? 0 : AVERROR_BUG;
+
+end:
+    av_frame_free(&frame);
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    avfilter_graph_free(&graph);
+    if (ret < 0)
+        fprintf(stderr, "%s: %s\n", name, av_err2str(ret));
+    return ret;
+}
+
+static int test(const char *name, const char *filters)
+{
+    uint8_t md5[2][FRAMES][16];
+
+    if (run(name, filters, 0, md5[0]) < 0 ||
+        run(name, filters, 1, md5[1]) < 0)
+        return 1;
+
+    for (int n = 0; n < FRAMES; n++) {
+        printf("%-10s %d ", name, n);
+        for (int i = 0; i < 16; i++)
+            printf("%02x", md5[0][n][i]);
+        printf("\n");
+    }
+
+    if (memcmp(md5[0], md5[1], sizeof(md5[0]))) {
+        fprintf(stderr, "%s: output differs from the one of cropped frames\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    ret |= test("scale",    "scale=32:24:flags=bicubic+bitexact");
+    ret |= test("identity", "scale=iw:ih:eval=frame:in_chroma_loc=left:out_chroma_loc=left");
+    ret |= test("format",   "scale=iw:ih:eval=frame:out_range=pc:flags=bitexact");
+
+    return ret;
+}
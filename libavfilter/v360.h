@@ -173,7 +173,7 @@ typedef struct V360Context {
     int elements;
     int mask_size;
     int max_value;
-    int nb_threads;
+    int nb_slices;
 
     SliceXYRemap *slice_remap;
     unsigned map[AV_VIDEO_MAX_PLANES];
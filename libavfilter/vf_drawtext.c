@@ -221,6 +221,14 @@ typedef struct Glyph {
     FT_BBox bbox;
 } Glyph;
 
+/** Position of a glyph in the cached text layer */
+typedef struct LayerGlyph {
+    uint32_t code;                  ///< the glyph code point
+    int idx;                        ///< the subpixel index of the glyph bitmap
+    int x;                          ///< the x position of the glyph in the layer
+    int y;                          ///< the y position of the glyph in the layer
+} LayerGlyph;
+
 /** Global text metrics */
 typedef struct TextMetrics {
     int offset_top64;               ///< ascender amount of the first line (in 26.6 units)
@@ -327,8 +335,39 @@ typedef struct DrawTextContext {
     int tab_count;                  ///< the number of tab characters
     int blank_advance64;            ///< the size of the space character
     int tab_warning_printed;        ///< ensure the tab warning to be printed only once
+
+    /**
+     * The rendered text is cached as a layer covering the box, made of
+     * three masks: shadow, border and glyphs. It is only rendered again
+     * when the glyphs or their position in the layer change.
+     */
+    uint8_t *layer;                 ///< the masks of the text layer
+    unsigned int layer_size;        ///< allocated size of layer
+    int layer_valid;                ///< tells if the text layer can be reused
+    int layer_x;                    ///< x position of the text layer in the frame
+    int layer_y;                    ///< y position of the text layer in the frame
+    int layer_w;                    ///< width of the text layer
+    int layer_h;                    ///< height of the text layer
+    int layer_rect[3][4];           ///< non-empty area of each mask (x0, y0, x1, y1)
+    unsigned int layer_fontsize;    ///< the font size the layer was rendered with
+    int layer_borderw;              ///< the border width the layer was rendered with
+    int layer_shadowx;              ///< the shadow x offset the layer was rendered with
+    int layer_shadowy;              ///< the shadow y offset the layer was rendered with
+    LayerGlyph *layer_glyphs;       ///< the glyphs rendered in the text layer
+    unsigned int layer_glyphs_size; ///< allocated size of layer_glyphs
+    int layer_nb_glyphs;            ///< the number of glyphs in the text layer
+    LayerGlyph *next_glyphs;        ///< the glyphs to be drawn in the current frame
+    unsigned int next_glyphs_size;  ///< allocated size of next_glyphs
 } DrawTextContext;
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    FFDrawColor *boxcolor;
+    FFDrawColor *shadowcolor;
+    FFDrawColor *bordercolor;
+    FFDrawColor *fontcolor;
+} ThreadData;
+
 #define OFFSET(x) offsetof(DrawTextContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
@@ -1141,6 +1180,12 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_bprint_finalize(&s->expanded_text, NULL);
     av_bprint_finalize(&s->expanded_fontcolor, NULL);
+
+    av_freep(&s->layer);
+    av_freep(&s->layer_glyphs);
+    av_freep(&s->next_glyphs);
+    s->layer_size = s->layer_glyphs_size = s->next_glyphs_size = 0;
+    s->layer_valid = 0;
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -1156,6 +1201,8 @@ static int config_input(AVFilterLink *inlink)
     ff_draw_color(&s->dc, &s->bordercolor, s->bordercolor.rgba);
     ff_draw_color(&s->dc, &s->boxcolor,    s->boxcolor.rgba);
 
+    s->layer_valid = 0;
+
     s->var_values[VAR_w]    = s->var_values[VAR_W] = s->var_values[VAR_MAIN_W] = inlink->w;
     s->var_values[VAR_h]    = s->var_values[VAR_H] = s->var_values[VAR_MAIN_H] = inlink->h;
     s->var_values[VAR_SAR]  = inlink->sample_aspect_ratio.num ? av_q2d(inlink->sample_aspect_ratio) : 1;
@@ -1270,20 +1317,13 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       FFDrawColor *color,
-                       TextMetrics *metrics,
-                       int x, int y, int borderw)
+// Computes the position of the glyphs in the text layer
+static int layout_layer(DrawTextContext *s, TextMetrics *metrics)
 {
-    int g, l, x1, y1, w1, h1, idx;
-    int dx = 0, dy = 0, pdx = 0;
-    GlyphInfo *info;
-    Glyph dummy = { 0 }, *glyph;
-    FT_Bitmap bitmap;
-    FT_BitmapGlyph b_glyph;
+    int g, l, n = 0, nb_glyphs = 0;
     uint8_t j_left = 0, j_right = 0, j_top = 0, j_bottom = 0;
     int line_w, offset_y = 0;
-    int clip_x = 0, clip_y = 0;
+    LayerGlyph *lg;
 
     j_left = !!(s->text_align & TA_LEFT);
     j_right = !!(s->text_align & TA_RIGHT);
@@ -1301,60 +1341,225 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
         av_log(s, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
     }
 
-    clip_x = FFMIN(metrics->rect_x + s->box_width + s->bb_right, frame->width);
-    clip_y = FFMIN(metrics->rect_y + s->box_height + s->bb_bottom, frame->height);
+    for (l = 0; l < s->line_count; ++l)
+        nb_glyphs += s->lines[l].hb_data.glyph_count;
+
+    lg = av_fast_realloc(s->next_glyphs, &s->next_glyphs_size,
+                         FFMAX(nb_glyphs, 1) * sizeof(*lg));
+    if (!lg)
+        return AVERROR(ENOMEM);
+    s->next_glyphs = lg;
 
     for (l = 0; l < s->line_count; ++l) {
         TextLine *line = &s->lines[l];
+        int offset_x = 0;
+
         line_w = POS_CEIL(line->width64, 64);
+        if (j_left && j_right) {
+            offset_x = (s->box_width - line_w) / 2;
+        } else if (j_right) {
+            offset_x = s->box_width - line_w;
+        }
+
         for (g = 0; g < line->hb_data.glyph_count; ++g) {
-            info = &line->glyphs[g];
-            dummy.fontsize = s->fontsize;
-            dummy.code = info->code;
-            glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-            if (!glyph) {
-                return AVERROR(EINVAL);
-            }
+            GlyphInfo *info = &line->glyphs[g];
 
-            idx = get_subpixel_idx(info->shift_x64, info->shift_y64);
-            b_glyph = borderw ? glyph->border_bglyph[idx] : glyph->bglyph[idx];
-            bitmap = b_glyph->bitmap;
-            x1 = x + info->x + b_glyph->left;
-            y1 = y + info->y - b_glyph->top + offset_y;
-            w1 = bitmap.width;
-            h1 = bitmap.rows;
-
-            if (j_left && j_right) {
-                x1 += (s->box_width - line_w) / 2;
-            } else if (j_right) {
-                x1 += s->box_width - line_w;
-            }
+            lg[n].code = info->code;
+            lg[n].idx = get_subpixel_idx(info->shift_x64, info->shift_y64);
+            lg[n].x = info->x + offset_x - s->layer_x;
+            lg[n].y = info->y + offset_y - s->layer_y;
+            n++;
+        }
+    }
 
-            // Offset of the glyph's bitmap in the visible region
-            dx = dy = 0;
-            if (x1 < metrics->rect_x - s->bb_left) {
-                dx = metrics->rect_x - s->bb_left - x1;
-                x1 = metrics->rect_x - s->bb_left;
-            }
-            if (y1 < metrics->rect_y - s->bb_top) {
-                dy = metrics->rect_y - s->bb_top - y1;
-                y1 = metrics->rect_y - s->bb_top;
-            }
+    return n;
+}
 
-            // check if the glyph is empty or out of the clipping region
-            if (dx >= w1 || dy >= h1 || x1 >= clip_x || y1 >= clip_y) {
-                continue;
-            }
+// Renders the glyphs into one mask of the text layer
+static int render_mask(DrawTextContext *s, uint8_t *mask, int *rect,
+                       int x, int y, int borderw)
+{
+    const int w = s->layer_w, h = s->layer_h;
+    Glyph dummy = { 0 }, *glyph;
+
+    rect[0] = w;
+    rect[1] = h;
+    rect[2] = rect[3] = 0;
+
+    for (int g = 0; g < s->layer_nb_glyphs; g++) {
+        const LayerGlyph *lg = &s->layer_glyphs[g];
+        FT_BitmapGlyph b_glyph;
+        FT_Bitmap bitmap;
+        int x1, y1, w1, h1, dx = 0, dy = 0;
+        const uint8_t *src;
+        uint8_t *dst;
+
+        dummy.fontsize = s->fontsize;
+        dummy.code = lg->code;
+        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+        if (!glyph) {
+            return AVERROR(EINVAL);
+        }
+
+        b_glyph = borderw ? glyph->border_bglyph[lg->idx] : glyph->bglyph[lg->idx];
+        bitmap = b_glyph->bitmap;
+        x1 = x + lg->x + b_glyph->left;
+        y1 = y + lg->y - b_glyph->top;
+        w1 = bitmap.width;
+        h1 = bitmap.rows;
+
+        // Offset of the glyph's bitmap in the visible region
+        if (x1 < 0) {
+            dx = -x1;
+            x1 = 0;
+        }
+        if (y1 < 0) {
+            dy = -y1;
+            y1 = 0;
+        }
 
-            pdx = dx + dy * bitmap.pitch;
-            w1 = FFMIN(clip_x - x1, w1 - dx);
-            h1 = FFMIN(clip_y - y1, h1 - dy);
+        // check if the glyph is empty or out of the clipping region
+        if (dx >= w1 || dy >= h1 || x1 >= w || y1 >= h) {
+            continue;
+        }
 
-            ff_blend_mask(&s->dc, color, frame->data, frame->linesize, clip_x, clip_y,
-                bitmap.buffer + pdx, bitmap.pitch, w1, h1, 3, 0, x1, y1);
+        w1 = FFMIN(w - x1, w1 - dx);
+        h1 = FFMIN(h - y1, h1 - dy);
+
+        src = bitmap.buffer + dx + dy * bitmap.pitch;
+        dst = mask + x1 + y1 * w;
+        // Glyphs may overlap, combine them as if they were blended in turn
+        for (int j = 0; j < h1; j++) {
+            for (int i = 0; i < w1; i++)
+                dst[i] = dst[i] + src[i] - (dst[i] * src[i] + 127) / 255;
+            src += bitmap.pitch;
+            dst += w;
         }
+
+        rect[0] = FFMIN(rect[0], x1);
+        rect[1] = FFMIN(rect[1], y1);
+        rect[2] = FFMAX(rect[2], x1 + w1);
+        rect[3] = FFMAX(rect[3], y1 + h1);
+    }
+
+    return 0;
+}
+
+// Updates the text layer, which is only rendered again if the text changed
+static int update_layer(DrawTextContext *s, TextMetrics *metrics)
+{
+    const int w = s->box_width + s->bb_left + s->bb_right;
+    const int h = s->box_height + s->bb_top + s->bb_bottom;
+    int nb_glyphs, ret;
+    size_t mask_size;
+
+    s->layer_x = metrics->rect_x - s->bb_left;
+    s->layer_y = metrics->rect_y - s->bb_top;
+
+    if ((nb_glyphs = layout_layer(s, metrics)) < 0)
+        return nb_glyphs;
+
+    if (s->layer_valid &&
+        s->layer_w == w && s->layer_h == h &&
+        s->layer_fontsize == s->fontsize && s->layer_borderw == s->borderw &&
+        s->layer_shadowx == s->shadowx && s->layer_shadowy == s->shadowy &&
+        s->layer_nb_glyphs == nb_glyphs &&
+        !memcmp(s->layer_glyphs, s->next_glyphs, nb_glyphs * sizeof(*s->layer_glyphs)))
+        return 0;
+
+    FFSWAP(LayerGlyph *, s->layer_glyphs, s->next_glyphs);
+    FFSWAP(unsigned int, s->layer_glyphs_size, s->next_glyphs_size);
+    s->layer_nb_glyphs = nb_glyphs;
+    s->layer_w = w;
+    s->layer_h = h;
+    s->layer_fontsize = s->fontsize;
+    s->layer_borderw = s->borderw;
+    s->layer_shadowx = s->shadowx;
+    s->layer_shadowy = s->shadowy;
+    s->layer_valid = 0;
+    memset(s->layer_rect, 0, sizeof(s->layer_rect));
+
+    if (w <= 0 || h <= 0) {
+        s->layer_valid = 1;
+        return 0;
     }
 
+    mask_size = (size_t)w * h;
+    av_fast_malloc(&s->layer, &s->layer_size, 3 * mask_size);
+    if (!s->layer)
+        return AVERROR(ENOMEM);
+    memset(s->layer, 0, 3 * mask_size);
+
+    if (s->shadowx || s->shadowy) {
+        if ((ret = render_mask(s, s->layer, s->layer_rect[0],
+                               s->shadowx, s->shadowy, s->borderw)) < 0)
+            return ret;
+    }
+    if (s->borderw) {
+        if ((ret = render_mask(s, s->layer + mask_size, s->layer_rect[1],
+                               0, 0, s->borderw)) < 0)
+            return ret;
+    }
+    if ((ret = render_mask(s, s->layer + 2 * mask_size, s->layer_rect[2],
+                           0, 0, 0)) < 0)
+        return ret;
+
+    s->layer_valid = 1;
+    return 0;
+}
+
+// Blends the part of a mask of the text layer that lies in rows [y0, y1)
+static void blend_layer_mask(DrawTextContext *s, AVFrame *frame,
+                             FFDrawColor *color, int plane, int y0, int y1)
+{
+    const int *rect = s->layer_rect[plane];
+    const uint8_t *mask = s->layer + (size_t)plane * s->layer_w * s->layer_h;
+    const int top    = FFMAX(s->layer_y + rect[1], y0);
+    const int bottom = FFMIN(s->layer_y + rect[3], y1);
+
+    if (rect[2] <= rect[0] || bottom <= top)
+        return;
+
+    mask += (top - s->layer_y) * s->layer_w + rect[0];
+    ff_blend_mask(&s->dc, color, frame->data, frame->linesize,
+                  frame->width, bottom, mask, s->layer_w,
+                  rect[2] - rect[0], bottom - top, 3, 0,
+                  s->layer_x + rect[0], top);
+}
+
+static int draw_layer_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int align = (1 << s->dc.vsub_max) - 1;
+    const int start = FFMAX(s->layer_y, 0) & ~align;
+    const int end   = FFMIN(s->layer_y + s->layer_h, frame->height);
+    // Slices start on chroma rows so that none is blended by two jobs
+    const int y0 = start + (((end - start) *  jobnr     / nb_jobs) & ~align);
+    const int y1 = jobnr == nb_jobs - 1 ? end :
+                   start + (((end - start) * (jobnr + 1) / nb_jobs) & ~align);
+    int top, bottom;
+
+    if (y1 <= y0)
+        return 0;
+
+    if (s->draw_box) {
+        top    = FFMAX(s->layer_y, y0);
+        bottom = FFMIN(s->layer_y + s->layer_h, y1);
+        ff_blend_rectangle(&s->dc, td->boxcolor,
+            frame->data, frame->linesize, frame->width, y1,
+            s->layer_x, top, s->layer_w, bottom - top);
+    }
+
+    if (s->shadowx || s->shadowy)
+        blend_layer_mask(s, frame, td->shadowcolor, 0, y0, y1);
+
+    if (s->borderw)
+        blend_layer_mask(s, frame, td->bordercolor, 1, y0, y1);
+
+    blend_layer_mask(s, frame, td->fontcolor, 2, y0, y1);
+
     return 0;
 }
 
@@ -1573,7 +1778,6 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
 
     int width = frame->width;
     int height = frame->height;
-    int rec_x = 0, rec_y = 0, rec_width = 0, rec_height = 0;
     int is_outside = 0;
     int last_tab_idx = 0;
 
@@ -1787,34 +1991,23 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
                     metrics.rect_y + s->box_height + s->bb_bottom <= 0;
 
     if (!is_outside) {
-        /* draw box */
-        if (s->draw_box) {
-            rec_x = metrics.rect_x - s->bb_left;
-            rec_y = metrics.rect_y - s->bb_top;
-            rec_width = s->box_width + s->bb_right + s->bb_left;
-            rec_height = s->box_height + s->bb_bottom + s->bb_top;
-            ff_blend_rectangle(&s->dc, &boxcolor,
-                frame->data, frame->linesize, width, height,
-                rec_x, rec_y, rec_width, rec_height);
-        }
-
-        if (s->shadowx || s->shadowy) {
-            if ((ret = draw_glyphs(s, frame, &shadowcolor, &metrics,
-                    s->shadowx, s->shadowy, s->borderw)) < 0) {
-                return ret;
-            }
-        }
-
-        if (s->borderw) {
-            if ((ret = draw_glyphs(s, frame, &bordercolor, &metrics,
-                    0, 0, s->borderw)) < 0) {
-                return ret;
-            }
+        ThreadData td = {
+            .frame       = frame,
+            .boxcolor    = &boxcolor,
+            .shadowcolor = &shadowcolor,
+            .bordercolor = &bordercolor,
+            .fontcolor   = &fontcolor,
+        };
+        int rows;
+
+        if ((ret = update_layer(s, &metrics)) < 0) {
+            return ret;
         }
 
-        if ((ret = draw_glyphs(s, frame, &fontcolor, &metrics, 0,
-                0, 0)) < 0) {
-            return ret;
+        rows = FFMIN(s->layer_y + s->layer_h, height) - FFMAX(s->layer_y, 0);
+        if (rows > 0 && s->layer_w > 0) {
+            int nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx), rows >> s->dc.vsub_max);
+            ff_filter_execute(ctx, draw_layer_slice, &td, NULL, FFMAX(nb_jobs, 1));
         }
     }
 
@@ -1920,5 +2113,6 @@ const AVFilter ff_vf_drawtext = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC2(query_formats),
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
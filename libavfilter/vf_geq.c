@@ -66,6 +66,9 @@ typedef struct GEQContext {
 
     double *pixel_sums[NB_PLANES];
     int needs_sum[NB_PLANES];
+
+    double *x_values;           ///< X of each column, 0 .. w-1
+    double *row_values[MAX_NB_THREADS]; ///< results of one row for each thread
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -380,6 +383,7 @@ static int geq_config_props(AVFilterLink *inlink)
 {
     GEQContext *geq = inlink->dst->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    const int nb_threads = FFMIN(MAX_NB_THREADS, ff_filter_get_nb_threads(inlink->dst));
 
     av_assert0(desc);
 
@@ -387,6 +391,20 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->vsub = desc->log2_chroma_h;
     geq->bps = desc->comp[0].depth;
     geq->planes = desc->nb_components;
+
+    av_freep(&geq->x_values);
+    geq->x_values = av_malloc_array(inlink->w, sizeof(*geq->x_values));
+    if (!geq->x_values)
+        return AVERROR(ENOMEM);
+    for (int x = 0; x < inlink->w; x++)
+        geq->x_values[x] = x;
+
+    for (int i = 0; i < nb_threads; i++) {
+        av_freep(&geq->row_values[i]);
+        geq->row_values[i] = av_malloc_array(inlink->w, sizeof(*geq->row_values[i]));
+        if (!geq->row_values[i])
+            return AVERROR(ENOMEM);
+    }
     return 0;
 }
 
@@ -407,8 +425,12 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    AVExpr *e = geq->e[plane][jobnr];
+    double *row = geq->row_values[jobnr];
+    int x, y, ret;
 
+    /* X varies along the row, everything else is constant per row */
+    const double *const_arrays[VAR_VARS_NB] = { [VAR_X] = geq->x_values };
     double values[VAR_VARS_NB];
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
@@ -417,36 +439,24 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     values[VAR_SH] = geq->values[VAR_SH];
     values[VAR_T] = geq->values[VAR_T];
 
-    if (geq->bps == 8) {
-        uint8_t *ptr = geq->dst + linesize * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr += linesize;
-        }
-    } else if (geq->bps <= 16) {
-        uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr16 += linesize/2;
-        }
-    } else {
-        float *ptr32 = geq->dst32 + (linesize/4) * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr32[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr32 += linesize/4;
+    for (y = slice_start; y < slice_end; y++) {
+        values[VAR_Y] = y;
+        ret = av_expr_eval_batch(e, row, width, values, const_arrays, geq);
+        if (ret < 0)
+            return ret;
+
+        if (geq->bps == 8) {
+            uint8_t *ptr = geq->dst + linesize * y;
+            for (x = 0; x < width; x++)
+                ptr[x] = row[x];
+        } else if (geq->bps <= 16) {
+            uint16_t *ptr16 = geq->dst16 + (linesize/2) * y;
+            for (x = 0; x < width; x++)
+                ptr16[x] = row[x];
+        } else {
+            float *ptr32 = geq->dst32 + (linesize/4) * y;
+            for (x = 0; x < width; x++)
+                ptr32[x] = row[x];
         }
     }
 
@@ -461,6 +471,7 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
     const int nb_threads = FFMIN(MAX_NB_THREADS, ff_filter_get_nb_threads(ctx));
     GEQContext *geq = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    int rets[MAX_NB_THREADS];
     AVFrame *out;
 
     geq->values[VAR_N] = inl->frame_count_out,
@@ -498,7 +509,14 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
             calculate_sums(geq, plane, width, height);
 
         ff_filter_execute(ctx, slice_geq_filter, &td,
-                          NULL, FFMIN(height, nb_threads));
+                          rets, FFMIN(height, nb_threads));
+        for (int i = 0; i < FFMIN(height, nb_threads); i++) {
+            if (rets[i] < 0) {
+                av_frame_free(&out);
+                av_frame_free(&geq->picref);
+                return rets[i];
+            }
+        }
     }
 
     av_frame_free(&geq->picref);
@@ -515,6 +533,9 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
             av_expr_free(geq->e[i][j]);
     for (i = 0; i < NB_PLANES; i++)
         av_freep(&geq->pixel_sums);
+    av_freep(&geq->x_values);
+    for (i = 0; i < MAX_NB_THREADS; i++)
+        av_freep(&geq->row_values[i]);
 }
 
 static const AVFilterPad geq_inputs[] = {
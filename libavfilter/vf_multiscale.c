@@ -0,0 +1,527 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * scale one input to several output sizes in a single pass
+ *
+ * The input is unpacked and converted to the output pixel format, color
+ * matrix and range at most once, and every output is then scaled either
+ * from that shared intermediate or, in cascade mode, from the smallest
+ * already produced rendition that is at least as large.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#include "avfilter.h"
+#include "filters.h"
+#include "formats.h"
+#include "framepool.h"
+#include "video.h"
+
+/* index of the input in MultiScaleContext.src */
+#define SRC_INPUT -1
+
+typedef struct MultiScaleContext {
+    const AVClass *class;
+
+    char *sizes_str;
+    enum AVPixelFormat format;
+    int cascade;
+    char *flags_str;
+
+    int nb_sizes;
+    int *w, *h;
+
+    /**
+     * Source of each output: SRC_INPUT for the (converted) input, or the
+     * index of a previous output to scale from.
+     */
+    int *src;
+
+    /**
+     * Converts the input to the output pixel format and color properties
+     * at the input size. NULL when the input can be used as is, or when at
+     * most one output is scaled from the input, which then does the
+     * conversion itself.
+     */
+    struct SwsContext *convert;
+    FFFramePool *pool;
+
+    /* per-output scalers, NULL for outputs identical to their source */
+    struct SwsContext **sws;
+
+    AVFrame **frames;
+    int *needed;
+} MultiScaleContext;
+
+static const int sws_colorspaces[] = {
+    AVCOL_SPC_UNSPECIFIED,
+    AVCOL_SPC_RGB,
+    AVCOL_SPC_BT709,
+    AVCOL_SPC_BT470BG,
+    AVCOL_SPC_SMPTE170M,
+    AVCOL_SPC_FCC,
+    AVCOL_SPC_SMPTE240M,
+    AVCOL_SPC_BT2020_NCL,
+    -1
+};
+
+static int config_output(AVFilterLink *outlink);
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+    char *sizes, *p, *saveptr = NULL;
+    int ret;
+
+    if (!s->sizes_str || !*s->sizes_str) {
+        av_log(ctx, AV_LOG_ERROR, "No output sizes specified.\n");
+        return AVERROR(EINVAL);
+    }
+
+    sizes = av_strdup(s->sizes_str);
+    if (!sizes)
+        return AVERROR(ENOMEM);
+
+    for (p = av_strtok(sizes, "|", &saveptr); p; p = av_strtok(NULL, "|", &saveptr)) {
+        int w, h;
+
+        ret = av_parse_video_size(&w, &h, p);
+        if (ret < 0) {
+            av_log(ctx, AV_LOG_ERROR, "Invalid output size '%s'.\n", p);
+            goto fail;
+        }
+
+        ret = av_reallocp_array(&s->w, s->nb_sizes + 1, sizeof(*s->w));
+        if (ret < 0)
+            goto fail;
+        ret = av_reallocp_array(&s->h, s->nb_sizes + 1, sizeof(*s->h));
+        if (ret < 0)
+            goto fail;
+        s->w[s->nb_sizes] = w;
+        s->h[s->nb_sizes] = h;
+        s->nb_sizes++;
+    }
+    av_freep(&sizes);
+
+    if (!s->nb_sizes) {
+        av_log(ctx, AV_LOG_ERROR, "No output sizes specified.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->src    = av_calloc(s->nb_sizes, sizeof(*s->src));
+    s->sws    = av_calloc(s->nb_sizes, sizeof(*s->sws));
+    s->frames = av_calloc(s->nb_sizes, sizeof(*s->frames));
+    s->needed = av_calloc(s->nb_sizes, sizeof(*s->needed));
+    if (!s->src || !s->sws || !s->frames || !s->needed)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < s->nb_sizes; i++) {
+        AVFilterPad pad = { 0 };
+
+        /* pick the smallest previous output that is at least as large */
+        s->src[i] = SRC_INPUT;
+        for (int j = 0; s->cascade && j < i; j++) {
+            if (s->w[j] < s->w[i] || s->h[j] < s->h[i])
+                continue;
+            if (s->src[i] == SRC_INPUT ||
+                (int64_t)s->w[j] * s->h[j] <
+                (int64_t)s->w[s->src[i]] * s->h[s->src[i]])
+                s->src[i] = j;
+        }
+
+        pad.type         = AVMEDIA_TYPE_VIDEO;
+        pad.config_props = config_output;
+        pad.name         = av_asprintf("output%d", i);
+        if (!pad.name)
+            return AVERROR(ENOMEM);
+
+        if ((ret = ff_append_outpad_free_name(ctx, &pad)) < 0)
+            return ret;
+    }
+
+    return 0;
+
+fail:
+    av_freep(&sizes);
+    return ret;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+
+    sws_freeContext(s->convert);
+    ff_frame_pool_uninit(&s->pool);
+    for (int i = 0; s->sws && i < s->nb_sizes; i++)
+        sws_freeContext(s->sws[i]);
+    for (int i = 0; s->frames && i < s->nb_sizes; i++)
+        av_frame_free(&s->frames[i]);
+
+    av_freep(&s->w);
+    av_freep(&s->h);
+    av_freep(&s->src);
+    av_freep(&s->sws);
+    av_freep(&s->frames);
+    av_freep(&s->needed);
+}
+
+static int query_formats(const AVFilterContext *ctx,
+                         AVFilterFormatsConfig **cfg_in,
+                         AVFilterFormatsConfig **cfg_out)
+{
+    const MultiScaleContext *s = ctx->priv;
+    AVFilterFormats *formats = NULL;
+    const AVPixFmtDescriptor *desc = NULL;
+    int ret;
+
+    while ((desc = av_pix_fmt_desc_next(desc))) {
+        enum AVPixelFormat pix_fmt = av_pix_fmt_desc_get_id(desc);
+        if ((sws_isSupportedInput(pix_fmt) ||
+             sws_isSupportedEndiannessConversion(pix_fmt)) &&
+            (ret = ff_add_format(&formats, pix_fmt)) < 0)
+            return ret;
+    }
+    if ((ret = ff_formats_ref(formats, &cfg_in[0]->formats)) < 0)
+        return ret;
+
+    if ((ret = ff_formats_ref(ff_make_format_list(sws_colorspaces),
+                              &cfg_in[0]->color_spaces)) < 0)
+        return ret;
+    if ((ret = ff_formats_ref(ff_all_color_ranges(),
+                              &cfg_in[0]->color_ranges)) < 0)
+        return ret;
+
+    /* All outputs share the same format, matrix and range, so the input
+     * only ever needs to be converted once. */
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        if ((ret = ff_formats_ref(ff_make_formats_list_singleton(s->format),
+                                  &cfg_out[i]->formats)) < 0)
+            return ret;
+
+    formats = ff_make_format_list(sws_colorspaces);
+    if (!formats)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        if ((ret = ff_formats_ref(formats, &cfg_out[i]->color_spaces)) < 0)
+            return ret;
+
+    formats = ff_all_color_ranges();
+    if (!formats)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        if ((ret = ff_formats_ref(formats, &cfg_out[i]->color_ranges)) < 0)
+            return ret;
+
+    return 0;
+}
+
+static int init_sws(AVFilterContext *ctx, struct SwsContext **psws,
+                    int srcw, int srch, enum AVPixelFormat src_format,
+                    enum AVColorSpace src_csp, enum AVColorRange src_range,
+                    int dstw, int dsth, const AVFilterLink *outlink)
+{
+    MultiScaleContext *s = ctx->priv;
+    struct SwsContext *sws;
+    const int *inv_table, *table;
+    int in_full, out_full, brightness, contrast, saturation;
+    int ret;
+
+    if (srcw == dstw && srch == dsth && src_format == outlink->format &&
+        src_csp == outlink->colorspace && src_range == outlink->color_range)
+        return 0;
+
+    sws = *psws = sws_alloc_context();
+    if (!sws)
+        return AVERROR(ENOMEM);
+
+    av_opt_set_int(sws, "srcw",       srcw,            0);
+    av_opt_set_int(sws, "srch",       srch,            0);
+    av_opt_set_int(sws, "src_format", src_format,      0);
+    av_opt_set_int(sws, "dstw",       dstw,            0);
+    av_opt_set_int(sws, "dsth",       dsth,            0);
+    av_opt_set_int(sws, "dst_format", outlink->format, 0);
+    av_opt_set_int(sws, "threads",    ff_filter_get_nb_threads(ctx), 0);
+    if (src_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(sws, "src_range", src_range == AVCOL_RANGE_JPEG, 0);
+    if (outlink->color_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(sws, "dst_range", outlink->color_range == AVCOL_RANGE_JPEG, 0);
+    if (s->flags_str && *s->flags_str) {
+        ret = av_opt_set(sws, "sws_flags", s->flags_str, 0);
+        if (ret < 0)
+            return ret;
+    }
+
+    if ((ret = sws_init_context(sws, NULL, NULL)) < 0)
+        return ret;
+
+    sws_getColorspaceDetails(sws, (int **)&inv_table, &in_full,
+                             (int **)&table, &out_full,
+                             &brightness, &contrast, &saturation);
+    if (src_csp != AVCOL_SPC_UNSPECIFIED)
+        inv_table = sws_getCoefficients(src_csp);
+    if (outlink->colorspace != AVCOL_SPC_UNSPECIFIED)
+        table = sws_getCoefficients(outlink->colorspace);
+    else
+        table = inv_table;
+    sws_setColorspaceDetails(sws, inv_table, in_full, table, out_full,
+                             brightness, contrast, saturation);
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    MultiScaleContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    const int idx = FF_OUTLINK_IDX(outlink);
+    const int src = s->src[idx];
+    int nb_input_users = 0, ret;
+
+    outlink->w = s->w[idx];
+    outlink->h = s->h[idx];
+    if (inlink->sample_aspect_ratio.num)
+        outlink->sample_aspect_ratio = av_mul_q((AVRational){ outlink->h * inlink->w,
+                                                              outlink->w * inlink->h },
+                                                inlink->sample_aspect_ratio);
+    else
+        outlink->sample_aspect_ratio = inlink->sample_aspect_ratio;
+
+    for (int i = 0; i < s->nb_sizes; i++)
+        nb_input_users += s->src[i] == SRC_INPUT;
+
+    if (nb_input_users > 1 && !s->convert && !s->pool &&
+        (inlink->format      != outlink->format     ||
+         inlink->colorspace  != outlink->colorspace ||
+         inlink->color_range != outlink->color_range)) {
+        ret = init_sws(ctx, &s->convert, inlink->w, inlink->h, inlink->format,
+                       inlink->colorspace, inlink->color_range,
+                       inlink->w, inlink->h, outlink);
+        if (ret < 0)
+            return ret;
+
+        s->pool = ff_frame_pool_video_init(av_buffer_allocz, inlink->w, inlink->h,
+                                           outlink->format, av_cpu_max_align());
+        if (!s->pool)
+            return AVERROR(ENOMEM);
+    }
+
+    sws_freeContext(s->sws[idx]);
+    s->sws[idx] = NULL;
+
+    if (src != SRC_INPUT)
+        return init_sws(ctx, &s->sws[idx], s->w[src], s->h[src], outlink->format,
+                        outlink->colorspace, outlink->color_range,
+                        outlink->w, outlink->h, outlink);
+    else if (s->convert)
+        return init_sws(ctx, &s->sws[idx], inlink->w, inlink->h, outlink->format,
+                        outlink->colorspace, outlink->color_range,
+                        outlink->w, outlink->h, outlink);
+    else
+        return init_sws(ctx, &s->sws[idx], inlink->w, inlink->h, inlink->format,
+                        inlink->colorspace, inlink->color_range,
+                        outlink->w, outlink->h, outlink);
+}
+
+static int scale_frames(AVFilterContext *ctx, AVFrame *in)
+{
+    MultiScaleContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFrame *converted = NULL;
+    const AVFrame *input = in;
+    int ret = 0;
+
+    if (in->width != inlink->w || in->height != inlink->h ||
+        in->format != inlink->format) {
+        av_log(ctx, AV_LOG_ERROR, "Changing video frame properties on the fly "
+               "is not supported.\n");
+        return AVERROR(EINVAL);
+    }
+
+    /* outputs that are either sent or used as the source of one that is */
+    for (int i = s->nb_sizes - 1; i >= 0; i--)
+        s->needed[i] = !ff_outlink_get_status(ctx->outputs[i]);
+    for (int i = s->nb_sizes - 1; i >= 0; i--)
+        if (s->needed[i] && s->src[i] != SRC_INPUT)
+            s->needed[s->src[i]] = 1;
+
+    if (s->convert) {
+        converted = ff_frame_pool_get(s->pool);
+        if (!converted)
+            return AVERROR(ENOMEM);
+        ret = av_frame_copy_props(converted, in);
+        if (ret < 0)
+            goto fail;
+        converted->color_range = ctx->outputs[0]->color_range;
+        converted->colorspace  = ctx->outputs[0]->colorspace;
+
+        ret = sws_scale_frame(s->convert, converted, in);
+        if (ret < 0)
+            goto fail;
+        input = converted;
+    }
+
+    for (int i = 0; i < s->nb_sizes; i++) {
+        AVFilterLink *outlink = ctx->outputs[i];
+        const AVFrame *src = s->src[i] == SRC_INPUT ? input : s->frames[s->src[i]];
+        AVFrame *out;
+
+        if (!s->needed[i])
+            continue;
+
+        if (!s->sws[i]) {
+            out = s->frames[i] = av_frame_clone(src);
+            if (!out) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+        } else {
+            out = s->frames[i] = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+            if (!out) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+
+            ret = av_frame_copy_props(out, in);
+            if (ret < 0)
+                goto fail;
+            out->color_range = outlink->color_range;
+            out->colorspace  = outlink->colorspace;
+
+            ret = sws_scale_frame(s->sws[i], out, src);
+            if (ret < 0)
+                goto fail;
+        }
+        out->sample_aspect_ratio = outlink->sample_aspect_ratio;
+    }
+
+    for (int i = 0; i < s->nb_sizes; i++) {
+        AVFrame *out = s->frames[i];
+
+        s->frames[i] = NULL;
+        if (!out)
+            continue;
+        if (ff_outlink_get_status(ctx->outputs[i])) {
+            av_frame_free(&out);
+            continue;
+        }
+
+        ret = ff_filter_frame(ctx->outputs[i], out);
+        if (ret < 0)
+            goto fail;
+    }
+
+fail:
+    for (int i = 0; i < s->nb_sizes; i++)
+        av_frame_free(&s->frames[i]);
+    av_frame_free(&converted);
+    return ret;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFrame *in;
+    int status, ret, nb_eofs = 0;
+    int64_t pts;
+
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        nb_eofs += ff_outlink_get_status(ctx->outputs[i]) == AVERROR_EOF;
+
+    if (nb_eofs == ctx->nb_outputs) {
+        ff_inlink_set_status(inlink, AVERROR_EOF);
+        return 0;
+    }
+
+    ret = ff_inlink_consume_frame(inlink, &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0) {
+        ret = scale_frames(ctx, in);
+        av_frame_free(&in);
+        if (ret < 0)
+            return ret;
+        /* run again for the next frame or the status */
+        ff_filter_set_ready(ctx, 100);
+        return 0;
+    }
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        for (int i = 0; i < ctx->nb_outputs; i++) {
+            if (ff_outlink_get_status(ctx->outputs[i]))
+                continue;
+            ff_outlink_set_status(ctx->outputs[i], status, pts);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < ctx->nb_outputs; i++) {
+        if (ff_outlink_get_status(ctx->outputs[i]))
+            continue;
+
+        if (ff_outlink_frame_wanted(ctx->outputs[i])) {
+            ff_inlink_request_frame(inlink);
+            return 0;
+        }
+    }
+
+    return FFERROR_NOT_READY;
+}
+
+#define OFFSET(x) offsetof(MultiScaleContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
+
+static const AVOption multiscale_options[] = {
+    { "sizes",   "set the '|'-separated list of output sizes", OFFSET(sizes_str), AV_OPT_TYPE_STRING,    { .str = NULL },               0, 0,       FLAGS },
+    { "format",  "set the output pixel format",                OFFSET(format),    AV_OPT_TYPE_PIXEL_FMT, { .i64 = AV_PIX_FMT_YUV420P }, -1, INT_MAX, FLAGS },
+    { "cascade", "scale each output from the smallest larger output instead of the input",
+                                                               OFFSET(cascade),   AV_OPT_TYPE_BOOL,      { .i64 = 0 },                  0, 1,       FLAGS },
+    { "flags",   "set libswscale scaling flags",               OFFSET(flags_str), AV_OPT_TYPE_STRING,    { .str = "" },                 0, 0,       FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(multiscale);
+
+static const AVFilterPad multiscale_inputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+};
+
+const AVFilter ff_vf_multiscale = {
+    .name            = "multiscale",
+    .description     = NULL_IF_CONFIG_SMALL("Scale the input video to several output sizes in a single pass."),
+    .priv_size       = sizeof(MultiScaleContext),
+    .priv_class      = &multiscale_class,
+    .init            = init,
+    .uninit          = uninit,
+    .activate        = activate,
+    FILTER_INPUTS(multiscale_inputs),
+    .outputs         = NULL,
+    FILTER_QUERY_FUNC2(query_formats),
+    .flags           = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+};
@@ -769,6 +769,9 @@ static int config_props(AVFilterLink *outlink)
             av_opt_set_int(s, "dst_h_chr_pos", h_chr_pos, 0);
             av_opt_set_int(s, "dst_v_chr_pos", v_chr_pos, 0);
 
+            if ((ret = sws_set_thread_pool(s, ctx->graph->thread_pool)) < 0)
+                return ret;
+
             if ((ret = sws_init_context(s, NULL, NULL)) < 0)
                 return ret;
 
@@ -932,10 +935,20 @@ static int scale_frame(AVFilterLink *link, AVFrame **frame_in,
     int ret;
     int frame_changed;
 
-    *frame_in = NULL;
+    *frame_in  = NULL;
+    *frame_out = NULL;
     if (in->colorspace == AVCOL_SPC_YCGCO)
         av_log(link->dst, AV_LOG_WARNING, "Detected unsupported YCgCo colorspace.\n");
 
+    /* Fold any cropping exported by upstream into the data pointers, so that
+     * swscale reads straight from the visible area of the source buffer
+     * instead of requiring a separate crop pass. */
+    if (in->crop_top || in->crop_bottom || in->crop_left || in->crop_right) {
+        ret = av_frame_apply_cropping(in, AV_FRAME_CROP_UNALIGNED);
+        if (ret < 0)
+            goto err;
+    }
+
     frame_changed = in->width  != link->w ||
                     in->height != link->h ||
                     in->format != link->format ||
@@ -1014,6 +1027,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
 scale:
     if (!scale->sws) {
+        /* Identity conversion: forward the input by reference, only
+         * updating the properties that may have been overridden. */
+        in->color_range = outlink->color_range;
+        in->colorspace  = outlink->colorspace;
+        if (scale->out_chroma_loc != AVCHROMA_LOC_UNSPECIFIED)
+            in->chroma_location = scale->out_chroma_loc;
         *frame_out = in;
         return 0;
     }
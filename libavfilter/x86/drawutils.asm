@@ -0,0 +1,89 @@
+;*****************************************************************************
+;* x86-optimized functions for the drawing utilities
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_0x1010101: times 8 dd 0x1010101
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; void ff_blend_row8(uint8_t *dst, const uint8_t *mask, int w,
+;                    unsigned src, unsigned alpha);
+;
+; a = mask[x] * alpha
+; dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24
+;
+; alpha is at most 0x10203, so every intermediate value fits in 32 bits.
+; w must be a positive multiple of 16.
+;-----------------------------------------------------------------------------
+%macro BLEND_ROW8 0
+cglobal blend_row8, 5, 5, 7, dst, mask, w, src, alpha
+    movd            xm4, srcd
+    movd            xm5, alphad
+%if cpuflag(avx2)
+    vpbroadcastd    m4, xm4
+    vpbroadcastd    m5, xm5
+%else
+    pshufd          m4, m4, 0
+    pshufd          m5, m5, 0
+%endif
+    mova            m6, [pd_0x1010101]
+    movsxdifnidn    wq, wd
+    add             dstq, wq
+    add             maskq, wq
+    neg             wq
+.loop:
+%assign i 0
+%rep 16 / (mmsize / 4)
+    pmovzxbd        m0, [maskq + wq + i*mmsize/4]
+    pmovzxbd        m1, [dstq + wq + i*mmsize/4]
+    pmulld          m0, m5              ; a
+    psubd           m2, m6, m0          ; 0x1010101 - a
+    pmulld          m1, m2
+    pmulld          m0, m4
+    paddd           m0, m1
+    psrld           m0, 24
+%if mmsize == 32
+    vextracti128    xm1, m0, 1
+    packusdw        xm0, xm1
+    packuswb        xm0, xm0
+    movq            [dstq + wq + i*8], xm0
+%else
+    packusdw        m0, m0
+    packuswb        m0, m0
+    movd            [dstq + wq + i*4], m0
+%endif
+%assign i i+1
+%endrep
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse4
+BLEND_ROW8
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLEND_ROW8
+%endif
@@ -21,6 +21,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/log.h"
 
 extern const AVClass ff_avio_class;
@@ -119,6 +120,20 @@ void ffio_init_write_context(FFIOContext *s, uint8_t *buffer, int buffer_size);
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read size bytes without copying them, by referencing the underlying
+ * resource when it is mapped into memory (e.g. the file protocol with
+ * the mmap option). The AV_INPUT_BUFFER_PADDING_SIZE bytes following the
+ * data are zero, as they would be in a newly allocated packet. The bytes
+ * are counted in the statistics of the context as if they had been read.
+ *
+ * @param buf on success, a new read-only reference to the data, whose size
+ *            includes the AV_INPUT_BUFFER_PADDING_SIZE bytes following it
+ * @return size on success, AVERROR(ENOSYS) if the data cannot be referenced,
+ *         in which case nothing was read, or another negative error code
+ */
+int ffio_read_zero_copy(AVIOContext *s, AVBufferRef **buf, int size);
+
 void ffio_fill(AVIOContext *s, int b, int64_t count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
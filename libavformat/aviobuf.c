@@ -31,6 +31,7 @@
 #include "avio.h"
 #include "avio_internal.h"
 #include "internal.h"
+#include "url.h"
 #include <stdarg.h>
 
 #define IO_BUFFER_SIZE 32768
@@ -681,6 +682,48 @@ int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsig
     }
 }
 
+int ffio_read_zero_copy(AVIOContext *s, AVBufferRef **pbuf, int size)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    AVBufferRef *buf;
+    int64_t pos;
+    int ret;
+
+    if (!h || !h->prot->url_get_mapping || s->write_flag ||
+        s->update_checksum || size <= 0)
+        return AVERROR(ENOSYS);
+
+    pos = avio_tell(s);
+    if (pos < 0)
+        return AVERROR(ENOSYS);
+
+    ret = h->prot->url_get_mapping(h, pos, size, &buf);
+    if (ret < 0)
+        return ret;
+
+    if (s->buf_end - s->buf_ptr >= size) {
+        s->buf_ptr += size;
+    } else {
+        /* skip the data by seeking the protocol, which is cheap for a
+         * mapping, rather than reading it into the buffer */
+        int64_t res = s->seek(s->opaque, pos + size, SEEK_SET);
+        if (res < 0) {
+            av_buffer_unref(&buf);
+            return res;
+        }
+        /* the buffered part was counted when it was read */
+        ffiocontext(s)->bytes_read += size - (s->buf_end - s->buf_ptr);
+        s->bytes_read = ffiocontext(s)->bytes_read;
+        s->buf_end = s->buf_ptr = s->buf_ptr_max = s->buffer;
+        s->pos = pos + size;
+        s->eof_reached = 0;
+    }
+
+    *pbuf = buf;
+
+    return size;
+}
+
 int avio_read_partial(AVIOContext *s, unsigned char *buf, int size)
 {
     int len;
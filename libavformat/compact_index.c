@@ -0,0 +1,383 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+
+#include "compact_index.h"
+
+/* timestamp, pos, size and flags, min_distance */
+#define MAX_ENTRY_BYTES (10 + 10 + 5 + 5)
+
+typedef struct CompactIndexBlock {
+    int64_t  last_timestamp;    ///< timestamp of the last entry
+    int64_t  last_pos;          ///< position of the last entry
+    int      first;             ///< index of the first entry in the whole index
+    int      nb_entries;
+    uint8_t *data;
+    unsigned size;
+    unsigned allocated_size;
+} CompactIndexBlock;
+
+struct FFCompactIndex {
+    CompactIndexBlock *blocks;
+    int                nb_blocks;
+    unsigned           blocks_allocated_size;
+    int                nb_entries;
+
+    int                cached_block;    ///< block decoded into cache, or -1
+    AVIndexEntry       cache[FF_COMPACT_INDEX_BLOCK_SIZE];
+};
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = v | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static uint64_t get_varint(const uint8_t **pp)
+{
+    const uint8_t *p = *pp;
+    uint64_t v = 0;
+
+    for (int shift = 0; ; shift += 7) {
+        v |= (uint64_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+            break;
+    }
+    *pp = p;
+    return v;
+}
+
+static int block_reserve(CompactIndexBlock *b, int nb_entries)
+{
+    uint8_t *data = av_fast_realloc(b->data, &b->allocated_size,
+                                    b->size + nb_entries * MAX_ENTRY_BYTES);
+    if (!data)
+        return AVERROR(ENOMEM);
+    b->data = data;
+    return 0;
+}
+
+/* space must have been reserved for the entry */
+static void block_append(CompactIndexBlock *b, const AVIndexEntry *e)
+{
+    int64_t prev_timestamp = b->nb_entries ? b->last_timestamp : 0;
+    int64_t prev_pos       = b->nb_entries ? b->last_pos       : 0;
+    uint8_t *p = b->data + b->size;
+
+    p = put_varint(p, zigzag((uint64_t)e->timestamp - prev_timestamp));
+    p = put_varint(p, zigzag((uint64_t)e->pos       - prev_pos));
+    p = put_varint(p, (uint64_t)e->size << 2 | (e->flags & 3));
+    p = put_varint(p, zigzag(e->min_distance));
+
+    b->size           = p - b->data;
+    b->last_timestamp = e->timestamp;
+    b->last_pos       = e->pos;
+    b->nb_entries++;
+}
+
+static void block_decode(const CompactIndexBlock *b, AVIndexEntry *entries)
+{
+    const uint8_t *p = b->data;
+    uint64_t timestamp = 0, pos = 0;
+
+    for (int i = 0; i < b->nb_entries; i++) {
+        uint64_t size_flags;
+
+        timestamp += unzigzag(get_varint(&p));
+        pos       += unzigzag(get_varint(&p));
+        size_flags = get_varint(&p);
+
+        entries[i].timestamp    = timestamp;
+        entries[i].pos          = pos;
+        entries[i].size         = size_flags >> 2;
+        entries[i].flags        = size_flags & 3;
+        entries[i].min_distance = unzigzag(get_varint(&p));
+    }
+}
+
+/* replace the entries of a block, space must have been reserved for them */
+static void block_encode(CompactIndexBlock *b, const AVIndexEntry *entries, int nb_entries)
+{
+    b->size       = 0;
+    b->nb_entries = 0;
+    for (int i = 0; i < nb_entries; i++)
+        block_append(b, &entries[i]);
+}
+
+/* release the space reserved for appending to a full block */
+static void block_shrink(CompactIndexBlock *b)
+{
+    uint8_t *data = av_realloc(b->data, b->size);
+    if (data) {
+        b->data           = data;
+        b->allocated_size = b->size;
+    }
+}
+
+static CompactIndexBlock *insert_block(FFCompactIndex *ci, int idx)
+{
+    CompactIndexBlock *blocks;
+
+    if (ci->nb_blocks >= INT_MAX / sizeof(*blocks) - 1)
+        return NULL;
+    blocks = av_fast_realloc(ci->blocks, &ci->blocks_allocated_size,
+                             (ci->nb_blocks + 1) * sizeof(*blocks));
+    if (!blocks)
+        return NULL;
+    ci->blocks = blocks;
+
+    memmove(blocks + idx + 1, blocks + idx, (ci->nb_blocks - idx) * sizeof(*blocks));
+    memset(&blocks[idx], 0, sizeof(*blocks));
+    blocks[idx].first = idx ? blocks[idx - 1].first + blocks[idx - 1].nb_entries : 0;
+    ci->nb_blocks++;
+    if (ci->cached_block >= idx)
+        ci->cached_block++;
+    return &blocks[idx];
+}
+
+/* index of the block containing the entry idx */
+static int find_block(const FFCompactIndex *ci, int idx)
+{
+    int a = 0, b = ci->nb_blocks - 1;
+
+    while (a < b) {
+        int m = (a + b + 1) >> 1;
+        if (ci->blocks[m].first <= idx)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return a;
+}
+
+static const AVIndexEntry *get_block(FFCompactIndex *ci, int idx)
+{
+    if (ci->cached_block != idx) {
+        block_decode(&ci->blocks[idx], ci->cache);
+        ci->cached_block = idx;
+    }
+    return ci->cache;
+}
+
+FFCompactIndex *ff_compact_index_alloc(void)
+{
+    FFCompactIndex *ci = av_mallocz(sizeof(*ci));
+    if (ci)
+        ci->cached_block = -1;
+    return ci;
+}
+
+static void compact_index_uninit(FFCompactIndex *ci)
+{
+    for (int i = 0; i < ci->nb_blocks; i++)
+        av_freep(&ci->blocks[i].data);
+    av_freep(&ci->blocks);
+}
+
+void ff_compact_index_free(FFCompactIndex **pci)
+{
+    FFCompactIndex *ci = *pci;
+
+    if (!ci)
+        return;
+    compact_index_uninit(ci);
+    av_freep(pci);
+}
+
+static int compact_index_append(FFCompactIndex *ci, const AVIndexEntry *e)
+{
+    CompactIndexBlock *b = ci->nb_blocks ? &ci->blocks[ci->nb_blocks - 1] : NULL;
+    int ret;
+
+    if (!b || b->nb_entries == FF_COMPACT_INDEX_BLOCK_SIZE) {
+        b = insert_block(ci, ci->nb_blocks);
+        if (!b)
+            return AVERROR(ENOMEM);
+    }
+    /* reserve space for a part of a new block, to not grow it for each entry */
+    ret = block_reserve(b, b->nb_entries ? 1 : FF_COMPACT_INDEX_BLOCK_SIZE / 4);
+    if (ret < 0)
+        return ret;
+
+    block_append(b, e);
+    if (b->nb_entries == FF_COMPACT_INDEX_BLOCK_SIZE)
+        block_shrink(b);
+    if (ci->cached_block == ci->nb_blocks - 1)
+        ci->cached_block = -1;
+    return ci->nb_entries++;
+}
+
+int ff_compact_index_add(FFCompactIndex *ci, int64_t pos, int64_t timestamp,
+                         int size, int distance, int flags)
+{
+    AVIndexEntry entries[FF_COMPACT_INDEX_BLOCK_SIZE + 1];
+    AVIndexEntry e = { .pos = pos, .timestamp = timestamp, .size = size,
+                       .flags = flags, .min_distance = distance };
+    CompactIndexBlock *b;
+    int a, c, i, n, ret;
+
+    if (ci->nb_entries >= INT_MAX - 1)
+        return AVERROR(ENOMEM);
+
+    if (!ci->nb_blocks || ci->blocks[ci->nb_blocks - 1].last_timestamp < timestamp)
+        return compact_index_append(ci, &e);
+
+    /* the first block ending at or after the timestamp */
+    a = 0;
+    c = ci->nb_blocks - 1;
+    while (a < c) {
+        int m = (a + c) >> 1;
+        if (ci->blocks[m].last_timestamp >= timestamp)
+            c = m;
+        else
+            a = m + 1;
+    }
+    b = &ci->blocks[a];
+    n = b->nb_entries;
+    memcpy(entries, get_block(ci, a), n * sizeof(*entries));
+
+    for (i = 0; entries[i].timestamp < timestamp; i++)
+        ;
+    if (entries[i].timestamp == timestamp) {
+        if (entries[i].pos == pos && distance < entries[i].min_distance)
+            // do not reduce the distance
+            e.min_distance = entries[i].min_distance;
+        entries[i] = e;
+
+        ret = block_reserve(b, n);
+        if (ret < 0)
+            return ret;
+        block_encode(b, entries, n);
+    } else {
+        CompactIndexBlock *next = NULL;
+
+        memmove(entries + i + 1, entries + i, (n - i) * sizeof(*entries));
+        entries[i] = e;
+        n++;
+
+        if (n > FF_COMPACT_INDEX_BLOCK_SIZE) {
+            next = insert_block(ci, a + 1);
+            if (!next)
+                return AVERROR(ENOMEM);
+            b = &ci->blocks[a];
+            ret = block_reserve(next, n - n / 2);
+            if (ret >= 0)
+                ret = block_reserve(b, n / 2);
+            if (ret < 0) {
+                av_freep(&next->data);
+                memmove(next, next + 1, (ci->nb_blocks - a - 2) * sizeof(*next));
+                ci->nb_blocks--;
+                if (ci->cached_block > a)
+                    ci->cached_block--;
+                return ret;
+            }
+            block_encode(b, entries, n / 2);
+            block_encode(next, entries + n / 2, n - n / 2);
+            next->first = b->first + b->nb_entries;
+        } else {
+            ret = block_reserve(b, n);
+            if (ret < 0)
+                return ret;
+            block_encode(b, entries, n);
+        }
+
+        for (int j = a + 1 + !!next; j < ci->nb_blocks; j++)
+            ci->blocks[j].first++;
+        ci->nb_entries++;
+    }
+
+    ci->cached_block = -1;
+    return b->first + i;
+}
+
+const AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx)
+{
+    int block;
+
+    if (idx < 0 || idx >= ci->nb_entries)
+        return NULL;
+
+    if (ci->cached_block >= 0) {
+        const CompactIndexBlock *b = &ci->blocks[ci->cached_block];
+        if (idx >= b->first && idx < b->first + b->nb_entries)
+            return &ci->cache[idx - b->first];
+    }
+
+    block = find_block(ci, idx);
+    return &get_block(ci, block)[idx - ci->blocks[block].first];
+}
+
+int ff_compact_index_count(const FFCompactIndex *ci)
+{
+    return ci->nb_entries;
+}
+
+size_t ff_compact_index_size(const FFCompactIndex *ci)
+{
+    size_t size = sizeof(*ci) + ci->blocks_allocated_size;
+
+    for (int i = 0; i < ci->nb_blocks; i++)
+        size += ci->blocks[i].allocated_size;
+    return size;
+}
+
+int ff_compact_index_halve(FFCompactIndex *ci)
+{
+    FFCompactIndex tmp = { .cached_block = -1 };
+    AVIndexEntry entries[FF_COMPACT_INDEX_BLOCK_SIZE];
+
+    for (int i = 0; i < ci->nb_blocks; i++) {
+        const CompactIndexBlock *b = &ci->blocks[i];
+
+        block_decode(b, entries);
+        for (int j = b->first & 1; j < b->nb_entries; j += 2) {
+            int ret = compact_index_append(&tmp, &entries[j]);
+            if (ret < 0) {
+                compact_index_uninit(&tmp);
+                return ret;
+            }
+        }
+    }
+
+    compact_index_uninit(ci);
+    ci->blocks                = tmp.blocks;
+    ci->nb_blocks             = tmp.nb_blocks;
+    ci->blocks_allocated_size = tmp.blocks_allocated_size;
+    ci->nb_entries            = tmp.nb_entries;
+    ci->cached_block          = -1;
+    return 0;
+}
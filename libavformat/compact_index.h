@@ -0,0 +1,79 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_COMPACT_INDEX_H
+#define AVFORMAT_COMPACT_INDEX_H
+
+/**
+ * @file
+ * Index entries stored in blocks of delta coded entries.
+ *
+ * The entries are sorted by timestamp, like FFStream.index_entries. Each
+ * block holds up to FF_COMPACT_INDEX_BLOCK_SIZE entries, coded as variable
+ * length differences to the previous entry, which typically takes 6-10
+ * bytes instead of the sizeof(AVIndexEntry) of a plain index. Appending an
+ * entry after the last one only codes that entry, inserting one in the
+ * middle recodes its block, which is split when full.
+ *
+ * Entries are returned decoded, from a copy of the last accessed block.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avformat.h"
+
+#define FF_COMPACT_INDEX_BLOCK_SIZE 64
+
+typedef struct FFCompactIndex FFCompactIndex;
+
+FFCompactIndex *ff_compact_index_alloc(void);
+
+void ff_compact_index_free(FFCompactIndex **pci);
+
+/**
+ * Add an entry, or update the one with the same timestamp, in the same way
+ * as ff_add_index_entry().
+ *
+ * @return the index of the entry, or a negative error code
+ */
+int ff_compact_index_add(FFCompactIndex *ci, int64_t pos, int64_t timestamp,
+                         int size, int distance, int flags);
+
+/**
+ * @return the entry at idx, valid until the next call with ci, or NULL if
+ *         idx is out of range
+ */
+const AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx);
+
+int ff_compact_index_count(const FFCompactIndex *ci);
+
+/**
+ * @return the number of bytes used by the index
+ */
+size_t ff_compact_index_size(const FFCompactIndex *ci);
+
+/**
+ * Discard every second entry, keeping the first one.
+ *
+ * @return 0 on success, or a negative error code, in which case the index
+ *         is left unchanged
+ */
+int ff_compact_index_halve(FFCompactIndex *ci);
+
+#endif /* AVFORMAT_COMPACT_INDEX_H */
@@ -51,6 +51,7 @@
 #include "http.h"
 #endif
 #include "internal.h"
+#include "ioqueue.h"
 #include "isom.h"
 #include "mux.h"
 #include "os_support.h"
@@ -204,6 +205,8 @@ typedef struct DASHContext {
     AVRational min_playback_rate;
     AVRational max_playback_rate;
     int64_t update_period;
+    int io_queue_size;
+    FFIOQueue *io_queue; /* segments and manifests finalized in the background */
 } DASHContext;
 
 static const struct codec_string {
@@ -482,6 +485,38 @@ static void set_http_options(AVDictionary **options, DASHContext *c)
         av_dict_set_int(options, "timeout", c->timeout, 0);
 }
 
+/* the segments are synced to storage before the manifests referencing them */
+static void set_segment_options(AVDictionary **options, DASHContext *c)
+{
+    set_http_options(options, c);
+    if (c->io_queue)
+        av_dict_set_int(options, "fsync", 1, 0);
+}
+
+static int dashenc_manifest_open(AVFormatContext *s, AVIOContext **pb, char *filename,
+                                 AVDictionary **options)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->io_queue)
+        return ff_ioqueue_open_buf(pb);
+    return dashenc_io_open(s, pb, filename, options);
+}
+
+/* queue writing a manifest opened with dashenc_manifest_open() */
+static int dashenc_manifest_queue(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                                  const char *final_filename)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *http_opts = NULL;
+    int ret;
+
+    set_http_options(&http_opts, c);
+    ret = ff_ioqueue_write_buf(c->io_queue, pb, filename, http_opts, final_filename);
+    av_dict_free(&http_opts);
+    return ret;
+}
+
 static void get_hls_playlist_name(char *playlist_name, int string_size,
                                   const char *base_url, int id) {
     if (base_url)
@@ -527,7 +562,7 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     snprintf(temp_filename_hls, sizeof(temp_filename_hls), use_rename ? "%s.tmp" : "%s", filename_hls);
 
     set_http_options(&http_opts, c);
-    ret = dashenc_io_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
+    ret = dashenc_manifest_open(s, &c->m3u8_out, temp_filename_hls, &http_opts);
     av_dict_free(&http_opts);
     if (ret < 0) {
         handle_io_open_error(s, ret, temp_filename_hls);
@@ -573,6 +608,12 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     if (final)
         ff_hls_write_end_list(c->m3u8_out);
 
+    if (c->io_queue) {
+        dashenc_manifest_queue(s, &c->m3u8_out, temp_filename_hls,
+                               use_rename ? filename_hls : NULL);
+        return;
+    }
+
     dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
 
     if (use_rename)
@@ -602,6 +643,8 @@ static void dash_free(AVFormatContext *s)
     DASHContext *c = s->priv_data;
     int i, j;
 
+    ff_ioqueue_free(&c->io_queue);
+
     if (c->as) {
         for (i = 0; i < c->nb_as; i++) {
             av_dict_free(&c->as[i].metadata);
@@ -1145,7 +1188,7 @@ static int write_manifest(AVFormatContext *s, int final)
 
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->url);
     set_http_options(&opts, c);
-    ret = dashenc_io_open(s, &c->mpd_out, temp_filename, &opts);
+    ret = dashenc_manifest_open(s, &c->mpd_out, temp_filename, &opts);
     av_dict_free(&opts);
     if (ret < 0) {
         return handle_io_open_error(s, ret, temp_filename);
@@ -1237,11 +1280,16 @@ static int write_manifest(AVFormatContext *s, int final)
 
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    dashenc_io_close(s, &c->mpd_out, temp_filename);
-
-    if (use_rename) {
-        if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
+    if (c->io_queue) {
+        if ((ret = dashenc_manifest_queue(s, &c->mpd_out, temp_filename,
+                                          use_rename ? s->url : NULL)) < 0)
             return ret;
+    } else {
+        dashenc_io_close(s, &c->mpd_out, temp_filename);
+        if (use_rename) {
+            if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
+                return ret;
+        }
     }
 
     if (c->hls_playlist) {
@@ -1260,7 +1308,7 @@ static int write_manifest(AVFormatContext *s, int final)
         snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", filename_hls);
 
         set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &c->m3u8_out, temp_filename, &opts);
+        ret = dashenc_manifest_open(s, &c->m3u8_out, temp_filename, &opts);
         av_dict_free(&opts);
         if (ret < 0) {
             return handle_io_open_error(s, ret, temp_filename);
@@ -1354,10 +1402,16 @@ static int write_manifest(AVFormatContext *s, int final)
             }
         }
 
-        dashenc_io_close(s, &c->m3u8_out, temp_filename);
-        if (use_rename)
-            if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
+        if (c->io_queue) {
+            if ((ret = dashenc_manifest_queue(s, &c->m3u8_out, temp_filename,
+                                              use_rename ? filename_hls : NULL)) < 0)
                 return ret;
+        } else {
+            dashenc_io_close(s, &c->m3u8_out, temp_filename);
+            if (use_rename)
+                if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
+                    return ret;
+        }
         c->master_playlist_created = 1;
     }
 
@@ -1435,6 +1489,14 @@ static int dash_init(AVFormatContext *s)
             av_log(s, AV_LOG_VERBOSE, "Enabling Producer Reference Time element for Low Latency mode\n");
     }
 
+    if (c->io_queue_size > 0) {
+        if (c->http_persistent) {
+            av_log(s, AV_LOG_WARNING, "io_queue_size is ignored with http_persistent\n");
+        } else if ((ret = ff_ioqueue_alloc(&c->io_queue, s, c->io_queue_size)) < 0) {
+            return ret;
+        }
+    }
+
     if (c->write_prft && !c->utc_timing_url) {
         av_log(s, AV_LOG_WARNING, "Producer Reference Time element option will be ignored as utc_timing_url is not set\n");
         c->write_prft = 0;
@@ -1579,7 +1641,7 @@ static int dash_init(AVFormatContext *s)
             ff_dash_fill_tmpl_params(os->initfile, sizeof(os->initfile), os->init_seg_name, i, 0, os->bit_rate, 0);
         }
         snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-        set_http_options(&opts, c);
+        set_segment_options(&opts, c);
         if (!c->single_file) {
             if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
                 return ret;
@@ -1862,6 +1924,8 @@ static void dashenc_delete_file(AVFormatContext *s, char *filename) {
 
         //Nothing to write
         dashenc_io_close(s, &c->http_delete, filename);
+    } else if (c->io_queue) {
+        ff_ioqueue_delete(c->io_queue, filename);
     } else {
         int res = ffurl_delete(filename);
         if (res < 0) {
@@ -1963,6 +2027,14 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
 
         if (c->single_file) {
             find_index_range(s, os->full_path, os->pos, &index_length);
+        } else if (c->io_queue) {
+            /* the segment is closed and renamed while the next one is muxed */
+            ret = ff_ioqueue_close(c->io_queue, &os->out,
+                                   use_rename ? os->temp_path : NULL,
+                                   use_rename ? os->full_path : NULL);
+            if (ret < 0 && !c->ignore_io_errors)
+                break;
+            ret = 0;
         } else {
             dashenc_io_close(s, &os->out, os->temp_path);
 
@@ -2255,7 +2327,7 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
                  os->filename);
         snprintf(os->temp_path, sizeof(os->temp_path),
                  use_rename ? "%s.tmp" : "%s", os->full_path);
-        set_http_options(&opts, c);
+        set_segment_options(&opts, c);
         ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
         av_dict_free(&opts);
         if (ret < 0) {
@@ -2330,6 +2402,12 @@ static int dash_write_trailer(AVFormatContext *s)
         }
     }
 
+    if (c->io_queue) {
+        int ret = ff_ioqueue_wait(c->io_queue);
+        if (ret < 0 && !c->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2379,6 +2457,7 @@ static const AVOption options[] = {
     { "ignore_io_errors", "Ignore IO errors during open and write. Useful for long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "index_correction", "Enable/Disable segment index correction logic", OFFSET(index_correction), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.$ext$"}, 0, 0, E },
+    { "io_queue_size", "finalize up to this many files in the background (0 disables)", OFFSET(io_queue_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, E },
     { "ldash", "Enable Low-latency dash. Constrains the value of a few elements", OFFSET(ldash), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "lhls", "Enable Low-latency HLS(Experimental). Adds #EXT-X-PREFETCH tag with current segment's URI", OFFSET(lhls), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "master_m3u8_publish_rate", "Publish master playlist every after this many segment intervals", OFFSET(master_publish_rate), AV_OPT_TYPE_INT, {.i64 = 0}, 0, UINT_MAX, E},
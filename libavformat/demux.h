@@ -39,6 +39,13 @@ struct AVDeviceInfoList;
  */
 #define FF_INFMT_FLAG_PREFER_CODEC_FRAMERATE                   (1 << 1)
 
+/**
+ * The demuxer only accesses the index through av_add_index_entry() and the
+ * other index functions, and never FFStream.index_entries directly, so that
+ * the index can be stored in the smaller FFCompactIndex.
+ */
+#define FF_INFMT_FLAG_COMPACT_INDEX                            (1 << 2)
+
 typedef struct FFInputFormat {
     /**
      * The public AVInputFormat. See avformat.h for it.
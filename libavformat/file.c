@@ -22,10 +22,13 @@
 #include "config_components.h"
 
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
+#include "libavutil/error.h"
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavcodec/defs.h"
 #include "avio.h"
 #if HAVE_DIRENT_H
 #include <dirent.h>
@@ -37,10 +40,16 @@
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <sys/stat.h>
 #include <stdlib.h>
 #include "os_support.h"
 #include "url.h"
+#if HAVE_IO_URING
+#include "uring.h"
+#endif
 
 /* Some systems may not have S_ISFIFO */
 #ifndef S_ISFIFO
@@ -96,8 +105,22 @@ typedef struct FileContext {
     int blocksize;
     int follow;
     int seekable;
+    int use_mmap;
+    int use_io_uring;
+    int io_uring_depth;
+    int fsync;
 #if HAVE_DIRENT_H
     DIR *dir;
+#endif
+    /* the whole file when mapped into memory, its size, and the position in it */
+    AVBufferRef *map;
+    int64_t map_size;
+    int64_t map_pos;
+    int64_t readahead_end;
+    int64_t checked_end;
+    size_t page_size;
+#if HAVE_IO_URING
+    FFURing *uring;
 #endif
 } FileContext;
 
@@ -106,6 +129,10 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "mmap", "Map regular files into memory for reading", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { "io_uring", "Use io_uring for asynchronous I/O on regular files", offsetof(FileContext, use_io_uring), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "io_uring_depth", "Number of io_uring requests in flight", offsetof(FileContext, io_uring_depth), AV_OPT_TYPE_INT, { .i64 = 4 }, 1, 64, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "fsync", "Flush written data to the storage device when closing", offsetof(FileContext, fsync), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_ENCODING_PARAM },
     { NULL }
 };
 
@@ -136,11 +163,178 @@ static const AVClass fd_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+#if HAVE_MMAP
+/* size of the region ahead of the read position paged in asynchronously */
+#define MMAP_READAHEAD (4 << 20)
+/* amount of data read between two checks for truncation of the file */
+#define MMAP_CHECK_INTERVAL (256 << 10)
+
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int file_map(URLContext *h, const struct stat *st)
+{
+    FileContext *c = h->priv_data;
+    size_t size;
+    void *data;
+
+#if HAVE_SYSCONF && defined(_SC_PAGESIZE)
+    c->page_size = sysconf(_SC_PAGESIZE);
+#endif
+    if (!c->page_size)
+        c->page_size = 4096;
+
+    /* the end of the last page is readable and zeroed, and serves as the
+     * padding of data at the end of the file */
+    if (!S_ISREG(st->st_mode) || st->st_size <= 0 ||
+        FFALIGN((uint64_t)st->st_size, c->page_size) > SIZE_MAX)
+        return AVERROR(ENOSYS);
+    size = FFALIGN((uint64_t)st->st_size, c->page_size);
+
+    /* Writes to the file by other processes still show through a private
+     * mapping, and accessing pages beyond the end of a file truncated later
+     * raises SIGBUS, see file_check_mapping(). */
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, c->fd, 0);
+    if (data == MAP_FAILED)
+        return AVERROR(errno);
+
+    c->map = av_buffer_create(data, size, file_unmap, (void *)(uintptr_t)size,
+                              AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        munmap(data, size);
+        return AVERROR(ENOMEM);
+    }
+    c->map_size = st->st_size;
+
+#if HAVE_POSIX_MADVISE
+    posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    return 0;
+}
+
+static void file_readahead(FileContext *c)
+{
+#if HAVE_POSIX_MADVISE
+    int64_t start;
+
+    if (c->map_pos >= c->map_size ||
+        (c->map_pos >= c->readahead_end - MMAP_READAHEAD &&
+         c->map_pos <  c->readahead_end - MMAP_READAHEAD / 2))
+        return;
+
+    start = c->map_pos & ~(int64_t)(c->page_size - 1);
+    posix_madvise(c->map->data + start, FFMIN(MMAP_READAHEAD, c->map_size - start),
+                  POSIX_MADV_WILLNEED);
+    c->readahead_end = start + MMAP_READAHEAD;
+#endif
+}
+
+/**
+ * Accessing the mapping beyond the end of a file truncated after it was
+ * mapped raises SIGBUS. Check the size of the file every MMAP_CHECK_INTERVAL
+ * bytes, and go back to reading the file if it shrank.
+ * This does not protect against a truncation racing with the reads of the
+ * current window, nor against packets referencing the mapping.
+ *
+ * @return 1 if the mapping can still be read from, 0 if it was dropped
+ */
+static int file_check_mapping(URLContext *h)
+{
+    FileContext *c = h->priv_data;
+    struct stat st;
+
+    if (c->map_pos >= c->checked_end - MMAP_CHECK_INTERVAL && c->map_pos < c->checked_end)
+        return 1;
+
+    if (!fstat(c->fd, &st) && st.st_size >= c->map_size) {
+        c->checked_end = c->map_pos + MMAP_CHECK_INTERVAL;
+        return 1;
+    }
+
+    av_log(h, AV_LOG_WARNING, "File truncated, not reading it from memory anymore\n");
+    av_buffer_unref(&c->map);
+    lseek(c->fd, c->map_pos, SEEK_SET);
+    return 0;
+}
+
+static int file_get_mapping(URLContext *h, int64_t pos, int size, AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+    const uint8_t *pad;
+    AVBufferRef *ref;
+    int64_t start, end;
+    size_t len;
+    uint8_t *data;
+    int i;
+
+    if (!c->map || !file_check_mapping(h) || pos < 0 || size <= 0 ||
+        pos + size > c->map_size)
+        return AVERROR(ENOSYS);
+
+    /* the data at the end of the file is followed by the zeroed end of
+     * the last page, so the mapping of the whole file can be referenced */
+    pad = c->map->data + pos + size;
+    for (i = 0; pos + size + i < c->map->size && i < AV_INPUT_BUFFER_PADDING_SIZE; i++)
+        if (pad[i])
+            break;
+    if (i == AV_INPUT_BUFFER_PADDING_SIZE) {
+        ref = av_buffer_ref(c->map);
+        if (!ref)
+            return AVERROR(ENOMEM);
+        goto end;
+    }
+
+    /* Otherwise, map the pages of the data again, privately and writable,
+     * and zero the padding. Only the pages of the padding are copied. */
+    start = pos & ~(int64_t)(c->page_size - 1);
+    end   = FFALIGN(pos + size + AV_INPUT_BUFFER_PADDING_SIZE, c->page_size);
+    if (end > c->map->size || end - start > SIZE_MAX)
+        return AVERROR(ENOSYS);
+    len  = end - start;
+    data = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, c->fd, start);
+    if (data == MAP_FAILED)
+        return AVERROR(ENOSYS);
+    memset(data + pos - start + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    ref = av_buffer_create(data, len, file_unmap, (void *)(uintptr_t)len,
+                           AV_BUFFER_FLAG_READONLY);
+    if (!ref) {
+        munmap(data, len);
+        return AVERROR(ENOMEM);
+    }
+    pos -= start;
+
+end:
+    ref->data += pos;
+    ref->size  = size + AV_INPUT_BUFFER_PADDING_SIZE;
+    *buf = ref;
+    return 0;
+}
+#endif /* HAVE_MMAP */
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+#if HAVE_MMAP
+    if (c->map && file_check_mapping(h)) {
+        if (c->map_pos >= c->map_size)
+            return AVERROR_EOF;
+        size = FFMIN(size, c->map_size - c->map_pos);
+        memcpy(buf, c->map->data + c->map_pos, size);
+        c->map_pos += size;
+        file_readahead(c);
+        return size;
+    }
+#endif
+#if HAVE_IO_URING
+    if (c->uring)
+        return ff_uring_read(c->uring, buf, size);
+#endif
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
@@ -154,6 +348,10 @@ static int file_write(URLContext *h, const unsigned char *buf, int size)
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+#if HAVE_IO_URING
+    if (c->uring)
+        return ff_uring_write(c->uring, buf, size);
+#endif
     ret = write(c->fd, buf, size);
     return (ret == -1) ? AVERROR(errno) : ret;
 }
@@ -221,8 +419,21 @@ static int fd_dup(URLContext *h, int oldfd)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
-    int ret = close(c->fd);
-    return (ret == -1) ? AVERROR(errno) : 0;
+    int ret = 0;
+
+    /* packets may still reference the mapping, which outlives the descriptor */
+    av_buffer_unref(&c->map);
+#if HAVE_IO_URING
+    ret = ff_uring_free(&c->uring);
+#endif
+#if HAVE_FSYNC
+    if (c->fsync && (h->flags & AVIO_FLAG_WRITE) && fsync(c->fd) == -1 && !ret)
+        ret = AVERROR(errno);
+#endif
+
+    if (close(c->fd) == -1 && !ret)
+        ret = AVERROR(errno);
+    return ret;
 }
 
 /* XXX: use llseek */
@@ -231,6 +442,50 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
     FileContext *c = h->priv_data;
     int64_t ret;
 
+#if HAVE_MMAP
+    if (c->map) {
+        switch (whence) {
+        case AVSEEK_SIZE: return c->map_size;
+        case SEEK_SET:                          break;
+        case SEEK_CUR:    pos += c->map_pos;    break;
+        case SEEK_END:    pos += c->map_size;   break;
+        default:          return AVERROR(EINVAL);
+        }
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        c->map_pos = pos;
+        file_readahead(c);
+        return pos;
+    }
+#endif
+#if HAVE_IO_URING
+    if (c->uring) {
+        struct stat st;
+
+        if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+            /* the size is only known once all writes in flight are done,
+             * while the reads ahead do not change it and are kept */
+            if (h->flags & AVIO_FLAG_WRITE) {
+                ret = ff_uring_seek(c->uring, ff_uring_tell(c->uring));
+                if (ret < 0)
+                    return ret;
+            }
+            if (fstat(c->fd, &st) < 0)
+                return AVERROR(errno);
+        }
+        switch (whence) {
+        case AVSEEK_SIZE: return st.st_size;
+        case SEEK_SET:                                   break;
+        case SEEK_CUR:    pos += ff_uring_tell(c->uring); break;
+        case SEEK_END:    pos += st.st_size;             break;
+        default:          return AVERROR(EINVAL);
+        }
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        return ff_uring_seek(c->uring, pos);
+    }
+#endif
+
     if (whence == AVSEEK_SIZE) {
         struct stat st;
         ret = fstat(c->fd, &st);
@@ -286,6 +541,7 @@ static int file_open(URLContext *h, const char *filename, int flags)
     int access;
     int fd;
     struct stat st;
+    int stat_ret;
 
     av_strstart(filename, "file:", &filename);
 
@@ -308,7 +564,30 @@ static int file_open(URLContext *h, const char *filename, int flags)
         return AVERROR(errno);
     c->fd = fd;
 
-    h->is_streamed = !fstat(fd, &st) && S_ISFIFO(st.st_mode);
+    stat_ret = fstat(fd, &st);
+    h->is_streamed = !stat_ret && S_ISFIFO(st.st_mode);
+
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow && !stat_ret) {
+#if HAVE_MMAP
+        int ret = file_map(h, &st);
+        if (ret < 0)
+            av_log(h, AV_LOG_VERBOSE, "Not mapping the file into memory: %s\n",
+                   av_err2str(ret));
+#else
+        av_log(h, AV_LOG_WARNING, "Memory mapping files is not supported\n");
+#endif
+    }
+
+    if (c->use_io_uring && !c->map && !c->follow && !stat_ret && S_ISREG(st.st_mode)) {
+#if HAVE_IO_URING
+        int ret = ff_uring_alloc(&c->uring, fd, 0, c->io_uring_depth,
+                                 FFMIN(c->blocksize, 262144));
+        if (ret < 0)
+            av_log(h, AV_LOG_VERBOSE, "Not using io_uring: %s\n", av_err2str(ret));
+#else
+        av_log(h, AV_LOG_WARNING, "io_uring is not supported\n");
+#endif
+    }
 
     /* Buffer writes more than the default 32k to improve throughput especially
      * with networked file systems */
@@ -414,6 +693,9 @@ const URLProtocol ff_file_protocol = {
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
     .url_check           = file_check,
+#if HAVE_MMAP
+    .url_get_mapping     = file_get_mapping,
+#endif
     .url_delete          = file_delete,
     .url_move            = file_move,
     .priv_data_size      = sizeof(FileContext),
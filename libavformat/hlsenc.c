@@ -50,6 +50,7 @@
 #endif
 #include "hlsplaylist.h"
 #include "internal.h"
+#include "ioqueue.h"
 #include "nal.h"
 #include "mux.h"
 #include "os_support.h"
@@ -263,6 +264,8 @@ typedef struct HLSContext {
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
+    int io_queue_size;
+    FFIOQueue *io_queue; /* segments and playlists finalized in the background */
 } HLSContext;
 
 static int strftime_expand(const char *fmt, char **dest)
@@ -348,6 +351,30 @@ static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSCont
         av_dict_set(options, "headers", c->headers, 0);
 }
 
+static int hls_playlist_open(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                             AVDictionary **options)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->io_queue)
+        return ff_ioqueue_open_buf(pb);
+    return hlsenc_io_open(s, pb, filename, options);
+}
+
+/* queue writing a playlist opened with hls_playlist_open() */
+static int hls_playlist_queue(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                              const char *final_filename)
+{
+    HLSContext *hls = s->priv_data;
+    AVDictionary *options = NULL;
+    int ret;
+
+    set_http_options(s, &options, hls);
+    ret = ff_ioqueue_write_buf(hls->io_queue, pb, filename, options, final_filename);
+    av_dict_free(&options);
+    return ret;
+}
+
 static void write_codec_attr(AVStream *st, VariantStream *vs)
 {
     int codec_strlen = strlen(vs->codec_attr);
@@ -594,6 +621,10 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
 
         //Nothing to write
         hlsenc_io_close(avf, &hls->http_delete, path);
+    } else if (hls->io_queue) {
+        int ret = ff_ioqueue_delete(hls->io_queue, path);
+        if (ret < 0)
+            return hls->ignore_io_errors ? 1 : ret;
     } else if (unlink(path) < 0) {
         av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                path, strerror(errno));
@@ -1056,7 +1087,10 @@ static int sls_flag_check_duration_size(HLSContext *hls, VariantStream *vs)
 static void sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(vs->current_segment_final_filename_fmt)) {
-        ff_rename(old_filename, vs->avf->url, hls);
+        if (hls->io_queue)
+            ff_ioqueue_rename(hls->io_queue, old_filename, vs->avf->url);
+        else
+            ff_rename(old_filename, vs->avf->url, hls);
     }
 }
 
@@ -1361,6 +1395,7 @@ static void hls_free_segments(HLSSegment *p)
 
 static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
 {
+    HLSContext *hls = s->priv_data;
     size_t len = strlen(oc->url);
     char *final_filename = av_strdup(oc->url);
     int ret;
@@ -1368,7 +1403,10 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     if (!final_filename)
         return AVERROR(ENOMEM);
     final_filename[len-4] = '\0';
-    ret = ff_rename(oc->url, final_filename, s);
+    if (hls->io_queue)
+        ret = ff_ioqueue_rename(hls->io_queue, oc->url, final_filename);
+    else
+        ret = ff_rename(oc->url, final_filename, s);
     oc->url[len-4] = '\0';
     av_freep(&final_filename);
     return ret;
@@ -1447,7 +1485,7 @@ static int create_master_playlist(AVFormatContext *s,
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", hls->master_m3u8_url);
-    ret = hlsenc_io_open(s, &hls->m3u8_out, temp_filename, &options);
+    ret = hls_playlist_open(s, &hls->m3u8_out, temp_filename, &options);
     av_dict_free(&options);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Failed to open master play list file '%s'\n",
@@ -1583,6 +1621,11 @@ static int create_master_playlist(AVFormatContext *s,
 fail:
     if (ret >=0)
         hls->master_m3u8_created = 1;
+    if (hls->io_queue) {
+        int err = hls_playlist_queue(s, &hls->m3u8_out, temp_filename,
+                                     use_temp_file ? hls->master_m3u8_url : NULL);
+        return ret < 0 ? ret : err;
+    }
     hlsenc_io_close(s, &hls->m3u8_out, temp_filename);
     if (use_temp_file)
         ff_rename(temp_filename, hls->master_m3u8_url, s);
@@ -1637,7 +1680,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", vs->m3u8_name);
-    ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
+    ret = hls_playlist_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
     av_dict_free(&options);
     if (ret < 0) {
         goto fail;
@@ -1694,7 +1737,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     if (vs->vtt_m3u8_name) {
         set_http_options(vs->vtt_avf, &options, hls);
         snprintf(temp_vtt_filename, sizeof(temp_vtt_filename), use_temp_file ? "%s.tmp" : "%s", vs->vtt_m3u8_name);
-        ret = hlsenc_io_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options);
+        ret = hls_playlist_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options);
         av_dict_free(&options);
         if (ret < 0) {
             goto fail;
@@ -1717,15 +1760,25 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
 fail:
     av_dict_free(&options);
-    ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
-    if (ret < 0) {
-        return ret;
-    }
-    hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
-    if (use_temp_file) {
-        ff_rename(temp_filename, vs->m3u8_name, s);
-        if (vs->vtt_m3u8_name)
-            ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+    if (hls->io_queue) {
+        ret = hls_playlist_queue(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename,
+                                 use_temp_file ? vs->m3u8_name : NULL);
+        if (ret >= 0 && hls->sub_m3u8_out)
+            ret = hls_playlist_queue(s, &hls->sub_m3u8_out, temp_vtt_filename,
+                                     use_temp_file ? vs->vtt_m3u8_name : NULL);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
+        if (ret < 0) {
+            return ret;
+        }
+        hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
+        if (use_temp_file) {
+            ff_rename(temp_filename, vs->m3u8_name, s);
+            if (vs->vtt_m3u8_name)
+                ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+        }
     }
     if (ret >= 0 && hls->master_pl_name)
         if (create_master_playlist(s, vs, last) < 0)
@@ -2630,7 +2683,10 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 
                 set_http_options(s, &options, hls);
 
-                ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                if (hls->io_queue)
+                    ret = ff_ioqueue_open_buf(&vs->out);
+                else
+                    ret = hlsenc_io_open(s, &vs->out, filename, &options);
                 if (ret < 0) {
                     av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
                            "Failed to open file '%s'\n", filename);
@@ -2648,8 +2704,14 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                     return ret;
                 }
                 vs->size = range_length;
-                ret = hlsenc_io_close(s, &vs->out, filename);
-                if (ret < 0) {
+                if (hls->io_queue) {
+                    /* the segment is written while the next one is muxed,
+                     * and synced to storage before the next playlist */
+                    av_dict_set_int(&options, "fsync", 1, 0);
+                    ret = ff_ioqueue_write_buf(hls->io_queue, &vs->out, filename, options, NULL);
+                    if (hls->ignore_io_errors)
+                        ret = 0;
+                } else if ((ret = hlsenc_io_close(s, &vs->out, filename)) < 0) {
                     av_log(s, AV_LOG_WARNING, "upload segment failed,"
                            " will retry with a new http session.\n");
                     ff_format_io_close(s, &vs->out);
@@ -2758,6 +2820,8 @@ static void hls_deinit(AVFormatContext *s)
     int i = 0;
     VariantStream *vs = NULL;
 
+    ff_ioqueue_free(&hls->io_queue);
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         vs = &hls->var_streams[i];
 
@@ -2922,6 +2986,12 @@ failed:
         av_free(old_filename);
     }
 
+    if (hls->io_queue) {
+        ret = ff_ioqueue_wait(hls->io_queue);
+        if (ret < 0 && !hls->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2961,6 +3031,16 @@ static int hls_init(AVFormatContext *s)
         av_log(hls, AV_LOG_WARNING, "No HTTP method set, hls muxer defaulting to method PUT.\n");
     }
 
+    if (hls->io_queue_size > 0) {
+        if (hls->http_persistent) {
+            av_log(hls, AV_LOG_WARNING, "io_queue_size is ignored with http_persistent.\n");
+        } else {
+            ret = ff_ioqueue_alloc(&hls->io_queue, s, hls->io_queue_size);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
     ret = validate_name(hls->nb_varstreams, s->url);
     if (ret < 0)
         return ret;
@@ -3238,6 +3318,7 @@ static const AVOption options[] = {
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
+    {"io_queue_size", "finalize up to this many files in the background (0 disables)", OFFSET(io_queue_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, E },
     { NULL },
 };
 
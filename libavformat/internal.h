@@ -189,6 +189,11 @@ typedef struct FFStream {
                                     support seeking natively. */
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
+    /**
+     * Used instead of index_entries by demuxers with
+     * FF_INFMT_FLAG_COMPACT_INDEX, nb_index_entries is kept up to date.
+     */
+    struct FFCompactIndex *compact_index;
 
     int64_t interleaver_chunk_size;
     int64_t interleaver_chunk_duration;
@@ -456,6 +461,13 @@ int ff_sdp_write_media(char *buff, int size, const AVStream *st, int idx,
                        const char *dest_addr, const char *dest_type,
                        int port, int ttl, AVFormatContext *fmt);
 
+/**
+ * Like av_get_packet(), but the packet may reference the input data directly
+ * instead of a copy of it, see ffio_read_zero_copy(). The packet data is then
+ * not writable, av_packet_make_writable() must be used before modifying it.
+ */
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size);
+
 /**
  * Read a whole line of text from AVIOContext. Stop reading after reaching
  * either a \\n, a \\0 or EOF. The returned string is always \\0-terminated,
@@ -0,0 +1,342 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/error.h"
+#include "libavutil/fifo.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "avio.h"
+#include "internal.h"
+#include "ioqueue.h"
+#include "url.h"
+
+enum IOJobType {
+    IO_JOB_WRITE,
+    IO_JOB_CLOSE,
+    IO_JOB_RENAME,
+    IO_JOB_DELETE,
+};
+
+typedef struct IOJob {
+    enum IOJobType type;
+    char          *url;
+    AVDictionary  *options;
+    uint8_t       *buf;
+    int            size;
+    AVIOContext   *pb;
+    char          *rename_from;
+    char          *rename_to;
+} IOJob;
+
+struct FFIOQueue {
+    AVFormatContext *s;
+    int              max_jobs;
+
+    /* queued jobs, the first one is being run by the thread */
+    AVFifo          *jobs;
+    int              error;
+
+#if HAVE_THREADS
+    pthread_t        thread;
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    int              finished;
+#endif
+};
+
+static void job_free(IOJob *job)
+{
+    av_freep(&job->url);
+    av_dict_free(&job->options);
+    av_freep(&job->buf);
+    av_freep(&job->rename_from);
+    av_freep(&job->rename_to);
+}
+
+static int job_run(FFIOQueue *q, IOJob *job)
+{
+    AVFormatContext *s = q->s;
+    int ret = 0;
+
+    switch (job->type) {
+    case IO_JOB_WRITE:
+        ret = s->io_open(s, &job->pb, job->url, AVIO_FLAG_WRITE, &job->options);
+        if (ret < 0) {
+            av_log(s, AV_LOG_ERROR, "Failed to open file '%s'\n", job->url);
+            break;
+        }
+        avio_write(job->pb, job->buf, job->size);
+        /* fall through */
+    case IO_JOB_CLOSE:
+        ret = ff_format_io_close(s, &job->pb);
+        if (ret < 0)
+            av_log(s, AV_LOG_ERROR, "Failed to write file '%s'\n",
+                   job->url ? job->url : job->rename_from ? job->rename_from : "");
+        break;
+    case IO_JOB_DELETE:
+        ret = ffurl_delete(job->url);
+        if (ret < 0)
+            av_log(s, ret == AVERROR(ENOENT) ? AV_LOG_WARNING : AV_LOG_ERROR,
+                   "failed to delete %s: %s\n", job->url, av_err2str(ret));
+        /* the muxers never fail because of this */
+        return 0;
+    }
+
+    if (ret >= 0 && job->rename_to)
+        ret = ff_rename(job->rename_from ? job->rename_from : job->url,
+                        job->rename_to, s);
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *ioqueue_thread(void *arg)
+{
+    FFIOQueue *q = arg;
+
+    pthread_mutex_lock(&q->lock);
+    while (1) {
+        IOJob job;
+        int ret;
+
+        if (!av_fifo_can_read(q->jobs)) {
+            if (q->finished)
+                break;
+            pthread_cond_wait(&q->cond, &q->lock);
+            continue;
+        }
+        av_fifo_peek(q->jobs, &job, 1, 0);
+        pthread_mutex_unlock(&q->lock);
+
+        ret = job_run(q, &job);
+        job_free(&job);
+
+        pthread_mutex_lock(&q->lock);
+        if (ret < 0 && !q->error)
+            q->error = ret;
+        av_fifo_drain2(q->jobs, 1);
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return NULL;
+}
+#endif
+
+int ff_ioqueue_alloc(FFIOQueue **pq, AVFormatContext *s, int max_jobs)
+{
+    FFIOQueue *q;
+#if HAVE_THREADS
+    int ret;
+#endif
+
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->s        = s;
+    q->max_jobs = FFMAX(max_jobs, 1);
+
+    q->jobs = av_fifo_alloc2(q->max_jobs, sizeof(IOJob), 0);
+    if (!q->jobs) {
+        av_free(q);
+        return AVERROR(ENOMEM);
+    }
+
+#if HAVE_THREADS
+    ret = pthread_mutex_init(&q->lock, NULL);
+    if (ret) {
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    ret = pthread_cond_init(&q->cond, NULL);
+    if (ret) {
+        pthread_mutex_destroy(&q->lock);
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    ret = pthread_create(&q->thread, NULL, ioqueue_thread, q);
+    if (ret) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        av_fifo_freep2(&q->jobs);
+        av_free(q);
+        return AVERROR(ret);
+    }
+#endif
+
+    *pq = q;
+    return 0;
+}
+
+void ff_ioqueue_free(FFIOQueue **pq)
+{
+    FFIOQueue *q = *pq;
+
+    if (!q)
+        return;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&q->lock);
+    q->finished = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+#endif
+
+    av_fifo_freep2(&q->jobs);
+    av_freep(pq);
+}
+
+static int ioqueue_error(FFIOQueue *q)
+{
+    int ret = q->error;
+    q->error = 0;
+    return ret;
+}
+
+/* takes ownership of the job in any case */
+static int ioqueue_add(FFIOQueue *q, IOJob *job)
+{
+    int ret;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&q->lock);
+    while (av_fifo_can_read(q->jobs) >= q->max_jobs)
+        pthread_cond_wait(&q->cond, &q->lock);
+    av_fifo_write(q->jobs, job, 1);
+    pthread_cond_broadcast(&q->cond);
+    ret = ioqueue_error(q);
+    pthread_mutex_unlock(&q->lock);
+#else
+    ret = job_run(q, job);
+    job_free(job);
+    if (ret < 0 && !q->error)
+        q->error = ret;
+    ret = ioqueue_error(q);
+#endif
+
+    return ret;
+}
+
+int ff_ioqueue_open_buf(AVIOContext **pb)
+{
+    return avio_open_dyn_buf(pb);
+}
+
+static int job_set_rename(IOJob *job, const char *rename_from, const char *rename_to)
+{
+    if (rename_from && !(job->rename_from = av_strdup(rename_from)))
+        return AVERROR(ENOMEM);
+    if (rename_to && !(job->rename_to = av_strdup(rename_to)))
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+int ff_ioqueue_write_buf(FFIOQueue *q, AVIOContext **pb, const char *url,
+                         const AVDictionary *options, const char *rename_to)
+{
+    IOJob job = { .type = IO_JOB_WRITE };
+    int ret;
+
+    if (!*pb)
+        return 0;
+
+    job.size = avio_close_dyn_buf(*pb, &job.buf);
+    *pb = NULL;
+    if (!job.buf)
+        return AVERROR(ENOMEM);
+
+    job.url = av_strdup(url);
+    ret = job.url ? av_dict_copy(&job.options, options, 0) : AVERROR(ENOMEM);
+    if (ret >= 0)
+        ret = job_set_rename(&job, NULL, rename_to);
+    if (ret < 0) {
+        job_free(&job);
+        return ret;
+    }
+
+    return ioqueue_add(q, &job);
+}
+
+int ff_ioqueue_close(FFIOQueue *q, AVIOContext **pb,
+                     const char *rename_from, const char *rename_to)
+{
+    IOJob job = { .type = IO_JOB_CLOSE, .pb = *pb };
+    int ret;
+
+    *pb = NULL;
+    if (!job.pb)
+        return 0;
+
+    ret = job_set_rename(&job, rename_from, rename_to);
+    if (ret < 0) {
+        /* still close it, without renaming */
+        job_free(&job);
+        ff_format_io_close(q->s, &job.pb);
+        return ret;
+    }
+
+    return ioqueue_add(q, &job);
+}
+
+int ff_ioqueue_rename(FFIOQueue *q, const char *url_src, const char *url_dst)
+{
+    IOJob job = { .type = IO_JOB_RENAME };
+    int ret = job_set_rename(&job, url_src, url_dst);
+
+    if (ret < 0) {
+        job_free(&job);
+        return ret;
+    }
+
+    return ioqueue_add(q, &job);
+}
+
+int ff_ioqueue_delete(FFIOQueue *q, const char *url)
+{
+    IOJob job = { .type = IO_JOB_DELETE, .url = av_strdup(url) };
+
+    if (!job.url)
+        return AVERROR(ENOMEM);
+
+    return ioqueue_add(q, &job);
+}
+
+int ff_ioqueue_wait(FFIOQueue *q)
+{
+    int ret;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&q->lock);
+    while (av_fifo_can_read(q->jobs))
+        pthread_cond_wait(&q->cond, &q->lock);
+    ret = ioqueue_error(q);
+    pthread_mutex_unlock(&q->lock);
+#else
+    ret = ioqueue_error(q);
+#endif
+
+    return ret;
+}
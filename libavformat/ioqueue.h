@@ -0,0 +1,102 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_IOQUEUE_H
+#define AVFORMAT_IOQUEUE_H
+
+/**
+ * @file
+ * Background completion of the output files of segmenting muxers.
+ *
+ * Writing a file from memory, closing an output, renaming and deleting
+ * files are done by a separate thread, in the order in which they were
+ * queued, so that a playlist queued after a segment is only written once
+ * the segment is complete. The muxer only blocks when the given number of
+ * operations is in flight. The files are opened and closed with the
+ * io_open() and io_close2() callbacks of the muxer, from the thread.
+ *
+ * An operation which fails is logged, and its error is returned by a later
+ * call. Without threads, the operations are done immediately.
+ */
+
+#include "libavutil/dict.h"
+
+#include "avformat.h"
+
+typedef struct FFIOQueue FFIOQueue;
+
+/**
+ * @param s        muxer whose io_open() and io_close2() callbacks are used
+ *                 and which is used for logging
+ * @param max_jobs maximum number of operations in flight
+ */
+int ff_ioqueue_alloc(FFIOQueue **pq, AVFormatContext *s, int max_jobs);
+
+/**
+ * Wait for all operations and free the queue.
+ */
+void ff_ioqueue_free(FFIOQueue **pq);
+
+/**
+ * Open a dynamic buffer standing in for a file written with
+ * ff_ioqueue_write_buf().
+ */
+int ff_ioqueue_open_buf(AVIOContext **pb);
+
+/**
+ * Queue writing the contents of a buffer opened with ff_ioqueue_open_buf()
+ * to url, and renaming url to rename_to if it is not NULL. *pb is closed
+ * and set to NULL.
+ *
+ * @param options options for opening url, copied
+ * @return 0, or the error of an earlier operation
+ */
+int ff_ioqueue_write_buf(FFIOQueue *q, AVIOContext **pb, const char *url,
+                         const AVDictionary *options, const char *rename_to);
+
+/**
+ * Queue closing an output, and renaming rename_from to rename_to if they
+ * are not NULL. *pb is set to NULL and must not be used anymore.
+ *
+ * @return 0, or the error of an earlier operation
+ */
+int ff_ioqueue_close(FFIOQueue *q, AVIOContext **pb,
+                     const char *rename_from, const char *rename_to);
+
+/**
+ * Queue renaming a file.
+ *
+ * @return 0, or the error of an earlier operation
+ */
+int ff_ioqueue_rename(FFIOQueue *q, const char *url_src, const char *url_dst);
+
+/**
+ * Queue deleting a file.
+ *
+ * @return 0, or the error of an earlier operation
+ */
+int ff_ioqueue_delete(FFIOQueue *q, const char *url);
+
+/**
+ * Wait for all queued operations.
+ *
+ * @return 0, or the first error of an operation which was not returned yet
+ */
+int ff_ioqueue_wait(FFIOQueue *q);
+
+#endif /* AVFORMAT_IOQUEUE_H */
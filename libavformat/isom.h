@@ -337,6 +337,7 @@ typedef struct MOVContext {
     int use_mfra_for;
     int has_looked_for_mfra;
     int use_tfdt;
+    int frag_window;        ///< read fragments on demand, keeping the samples of this many
     MOVFragmentIndex frag_index;
     int atom_depth;
     unsigned int aax_mode;  ///< 'aax' file has been detected
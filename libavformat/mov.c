@@ -8250,6 +8250,9 @@ static int cenc_filter(MOVContext *mov, AVStream* st, MOVStreamContext *sc, AVPa
         }
 
         if (mov->decryption_key) {
+            ret = av_packet_make_writable(pkt);
+            if (ret < 0)
+                return ret;
             return cenc_decrypt(mov, sc, encrypted_sample, pkt->data, pkt->size);
         } else {
             size_t size;
@@ -9288,6 +9291,14 @@ static const MOVParseTableEntry mov_default_parse_table[] = {
 { 0, NULL }
 };
 
+/* whether to stop after the first fragment, and read the others on demand */
+static int mov_frags_on_demand(MOVContext *c, AVIOContext *pb)
+{
+    return !(pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+           c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete ||
+           (c->frag_window > 0 && c->trex_data);
+}
+
 static int mov_read_default(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
     int64_t total_size = 0;
@@ -9382,9 +9393,8 @@ static int mov_read_default(MOVContext *c, AVIOContext *pb, MOVAtom atom)
                 return err;
             }
             if (c->found_moov && c->found_mdat && a.size <= INT64_MAX - start_pos &&
-                ((!(pb->seekable & AVIO_SEEKABLE_NORMAL) || c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete) ||
-                 start_pos + a.size == avio_size(pb))) {
-                if (!(pb->seekable & AVIO_SEEKABLE_NORMAL) || c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete)
+                (mov_frags_on_demand(c, pb) || start_pos + a.size == avio_size(pb))) {
+                if (mov_frags_on_demand(c, pb))
                     c->next_root_atom = start_pos + a.size;
                 c->atom_depth --;
                 return 0;
@@ -10631,6 +10641,191 @@ static int should_retry(AVIOContext *pb, int error_code) {
     return 1;
 }
 
+/**
+ * Find the top-level moof following the one at pos, by walking the box
+ * headers.
+ *
+ * @return the offset of the moof, 0 if there is none, or a negative error code
+ */
+static int64_t mov_next_moof_offset(AVIOContext *pb, int64_t pos)
+{
+    int first = 1;
+
+    while (1) {
+        uint64_t size;
+        uint32_t type;
+
+        if (avio_seek(pb, pos, SEEK_SET) != pos)
+            return 0;
+        size = avio_rb32(pb);
+        type = avio_rl32(pb);
+        if (size == 1)
+            size = avio_rb64(pb);
+        if (avio_feof(pb) || !size)
+            return 0;
+        if (size < 8 || size > INT64_MAX - pos)
+            return AVERROR_INVALIDDATA;
+
+        if (type == MKTAG('m','o','o','f') && !first)
+            return pos;
+        first = 0;
+        pos  += size;
+    }
+}
+
+/**
+ * Set the root atom to continue with after the fragment at index, which is
+ * only known once that has been found with the frag_window option.
+ */
+static int mov_set_next_root_atom(AVFormatContext *s, int index)
+{
+    MOVContext *mov = s->priv_data;
+    int64_t next = 0;
+
+    if (index + 1 < mov->frag_index.nb_items) {
+        next = mov->frag_index.item[index + 1].moof_offset;
+    } else if (!mov->frag_index.complete && mov->frag_window > 0) {
+        next = mov_next_moof_offset(s->pb, mov->frag_index.item[index].moof_offset);
+        if (next < 0)
+            return next;
+    }
+    mov->next_root_atom = next;
+    return 0;
+}
+
+/**
+ * Remove the samples of a fragment from the index of a stream.
+ */
+static void mov_drop_frag_samples(MOVContext *mov, AVStream *st, int index)
+{
+    FFStream *const sti = ffstream(st);
+    MOVStreamContext *sc = st->priv_data;
+    MOVFragmentStreamInfo *frag_stream_info;
+    int start, end = sti->nb_index_entries, len;
+
+    frag_stream_info = get_frag_stream_info(&mov->frag_index, index, sc->id);
+    if (!frag_stream_info || frag_stream_info->index_entry < 0)
+        return;
+    start = frag_stream_info->index_entry;
+
+    for (int i = index + 1; i < mov->frag_index.nb_items; i++) {
+        MOVFragmentStreamInfo *next = get_frag_stream_info(&mov->frag_index, i, sc->id);
+        if (next && next->index_entry >= 0) {
+            end = next->index_entry;
+            break;
+        }
+    }
+    len = end - start;
+
+    memmove(sti->index_entries + start, sti->index_entries + end,
+            (sti->nb_index_entries - end) * sizeof(*sti->index_entries));
+    sti->nb_index_entries -= len;
+    if (sc->current_sample >= end)
+        mov_current_sample_set(sc, sc->current_sample - len);
+
+    /* the ctts entries are usually one per sample, but may cover runs of
+     * samples or fewer samples than the index */
+    if (sc->ctts_data) {
+        int64_t time_sample = 0;
+        unsigned int count = 0;
+
+        for (unsigned int i = 0; i < sc->ctts_count; i++) {
+            MOVCtts ctts = sc->ctts_data[i];
+            int64_t dropped = FFMIN(end, time_sample + ctts.count) - FFMAX(start, time_sample);
+
+            time_sample += ctts.count;
+            if (dropped > 0)
+                ctts.count -= dropped;
+            if (ctts.count)
+                sc->ctts_data[count++] = ctts;
+        }
+        sc->ctts_count = count;
+
+        sc->ctts_index  = sc->ctts_count;
+        sc->ctts_sample = 0;
+        time_sample = 0;
+        for (unsigned int i = 0; i < sc->ctts_count; i++) {
+            int64_t next = time_sample + sc->ctts_data[i].count;
+            if (next > sc->current_sample) {
+                sc->ctts_index  = i;
+                sc->ctts_sample = sc->current_sample - time_sample;
+                break;
+            }
+            time_sample = next;
+        }
+    }
+
+    /* the samples are read again with the fragment headers; the encryption
+     * info is kept, as it is not read twice */
+    frag_stream_info->index_entry   = -1;
+    frag_stream_info->index_base    = -1;
+    frag_stream_info->next_trun_dts = AV_NOPTS_VALUE;
+
+    for (int i = index + 1; i < mov->frag_index.nb_items; i++) {
+        frag_stream_info = get_frag_stream_info(&mov->frag_index, i, sc->id);
+        if (!frag_stream_info)
+            continue;
+        if (frag_stream_info->index_entry >= 0)
+            frag_stream_info->index_entry -= len;
+        if (frag_stream_info->index_base >= 0)
+            frag_stream_info->index_base -= len;
+    }
+}
+
+/**
+ * Make room for reading one more fragment with the frag_window option, by
+ * dropping the samples of fragments none of whose streams are being read.
+ */
+static void mov_trim_frag_index(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    MOVFragmentIndex *frag_index = &mov->frag_index;
+    int nb_read = 0;
+
+    for (int i = 0; i < frag_index->nb_items; i++)
+        nb_read += frag_index->item[i].headers_read;
+
+    /* a seek may need the fragment after the one holding the timestamp */
+    for (int i = 0; i < frag_index->nb_items && nb_read >= FFMAX(mov->frag_window, 2); i++) {
+        int in_use = 0;
+
+        if (!frag_index->item[i].headers_read)
+            continue;
+
+        for (int j = 0; j < s->nb_streams && !in_use; j++) {
+            MOVStreamContext *sc = s->streams[j]->priv_data;
+            MOVFragmentStreamInfo *frag_stream_info;
+            int end = ffstream(s->streams[j])->nb_index_entries;
+
+            /* edit lists map the samples, which can then not be moved */
+            if (sc->index_ranges) {
+                in_use = 1;
+                break;
+            }
+
+            frag_stream_info = get_frag_stream_info(frag_index, i, sc->id);
+            if (!frag_stream_info || frag_stream_info->index_entry < 0)
+                continue;
+            for (int k = i + 1; k < frag_index->nb_items; k++) {
+                MOVFragmentStreamInfo *next = get_frag_stream_info(frag_index, k, sc->id);
+                if (next && next->index_entry >= 0) {
+                    end = next->index_entry;
+                    break;
+                }
+            }
+            in_use = sc->current_sample >= frag_stream_info->index_entry &&
+                     sc->current_sample <  end;
+        }
+        if (in_use)
+            continue;
+
+        for (int j = 0; j < s->nb_streams; j++)
+            mov_drop_frag_samples(mov, s->streams[j], i);
+        frag_index->item[i].headers_read = 0;
+        nb_read--;
+    }
+}
+
 static int mov_switch_root(AVFormatContext *s, int64_t target, int index)
 {
     int ret;
@@ -10648,11 +10843,13 @@ static int mov_switch_root(AVFormatContext *s, int64_t target, int index)
         index = search_frag_moof_offset(&mov->frag_index, target);
     if (index >= 0 && index < mov->frag_index.nb_items &&
         mov->frag_index.item[index].moof_offset == target) {
-        if (index + 1 < mov->frag_index.nb_items)
-            mov->next_root_atom = mov->frag_index.item[index + 1].moof_offset;
         if (mov->frag_index.item[index].headers_read)
-            return 0;
+            return mov_set_next_root_atom(s, index);
+        if (mov->frag_window > 0)
+            mov_trim_frag_index(s);
         mov->frag_index.item[index].headers_read = 1;
+    } else if (mov->frag_window > 0) {
+        mov_trim_frag_index(s);
     }
 
     mov->found_mdat = 0;
@@ -10660,6 +10857,13 @@ static int mov_switch_root(AVFormatContext *s, int64_t target, int index)
     ret = mov_read_default(mov, s->pb, (MOVAtom){ AV_RL32("root"), INT64_MAX });
     if (ret < 0)
         return ret;
+    if (mov->frag_window > 0) {
+        /* mark a fragment which was not known before as read */
+        index = search_frag_moof_offset(&mov->frag_index, mov->fragment.moof_offset);
+        if (index < mov->frag_index.nb_items &&
+            mov->frag_index.item[index].moof_offset == mov->fragment.moof_offset)
+            mov->frag_index.item[index].headers_read = 1;
+    }
     if (avio_feof(s->pb))
         return AVERROR_EOF;
     av_log(s, AV_LOG_TRACE, "read fragments, offset 0x%"PRIx64"\n", avio_tell(s->pb));
@@ -10877,7 +11081,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         }
 #endif
         else
-            ret = av_get_packet(sc->pb, pkt, sample->size);
+            ret = ff_get_packet_ref(sc->pb, pkt, sample->size);
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
                 mov_current_sample_dec(sc);
@@ -10919,8 +11123,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     if (st->discard == AVDISCARD_ALL)
         goto retry;
 
-    if (mov->aax_mode)
+    if (mov->aax_mode) {
+        ret = av_packet_make_writable(pkt);
+        if (ret < 0)
+            return ret;
         aax_filter(pkt->data, pkt->size, mov);
+    }
 
     ret = cenc_filter(mov, st, sc, pkt, current_index);
     if (ret < 0) {
@@ -10930,21 +11138,74 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+/**
+ * Read the fragments following the last known one, until one starts after
+ * timestamp, so that fragments without an index can be seeked to.
+ */
+static int mov_read_frags_until(AVFormatContext *s, AVStream *st, int64_t timestamp)
+{
+    MOVContext *mov = s->priv_data;
+    MOVFragmentIndex *frag_index = &mov->frag_index;
+
+    while (frag_index->nb_items) {
+        int last = frag_index->nb_items - 1;
+        int64_t frag_time = get_frag_time(s, st, frag_index, last);
+        int64_t next;
+        int ret;
+
+        if (frag_time == AV_NOPTS_VALUE || frag_time > timestamp)
+            break;
+
+        next = mov_next_moof_offset(s->pb, frag_index->item[last].moof_offset);
+        if (next <= 0)
+            return next;
+        ret = mov_switch_root(s, next, -1);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            return ret;
+        if (frag_index->nb_items == last + 1)
+            break;
+    }
+    return 0;
+}
+
 static int mov_seek_fragment(AVFormatContext *s, AVStream *st, int64_t timestamp)
 {
     MOVContext *mov = s->priv_data;
-    int index;
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    MOVFragmentStreamInfo *frag_stream_info;
+    int index, ret;
 
-    if (!mov->frag_index.complete)
-        return 0;
+    if (!mov->frag_index.complete) {
+        if (mov->frag_window <= 0 || !mov->frag_index.nb_items)
+            return 0;
+        /* the old position does not need to be kept in the index */
+        mov_current_sample_set(sc, sti->nb_index_entries);
+        ret = mov_read_frags_until(s, st, timestamp);
+        if (ret < 0)
+            return ret;
+    }
 
-    index = search_frag_timestamp(s, &mov->frag_index, st, timestamp);
-    if (index < 0)
-        index = 0;
-    if (!mov->frag_index.item[index].headers_read)
-        return mov_switch_root(s, -1, index);
-    if (index + 1 < mov->frag_index.nb_items)
-        mov->next_root_atom = mov->frag_index.item[index + 1].moof_offset;
+    /* before the first fragment, which may have been dropped from the index */
+    index = FFMAX(search_frag_timestamp(s, &mov->frag_index, st, timestamp), 0);
+    ret = mov_switch_root(s, -1, index);
+    if (ret < 0 || mov->frag_index.complete || !index)
+        return ret;
+
+    /* the samples of this stream may start after the timestamp, while those
+     * of the previous fragment are not in the index anymore */
+    frag_stream_info = get_frag_stream_info(&mov->frag_index, index, sc->id);
+    if (frag_stream_info && frag_stream_info->index_entry >= 0 &&
+        frag_stream_info->index_entry < sti->nb_index_entries &&
+        sti->index_entries[frag_stream_info->index_entry].timestamp > timestamp &&
+        !mov->frag_index.item[index - 1].headers_read) {
+        ret = mov_switch_root(s, -1, index - 1);
+        if (ret < 0)
+            return ret;
+        return mov_set_next_root_atom(s, index - 1);
+    }
 
     return 0;
 }
@@ -11169,6 +11430,8 @@ static const AVOption mov_options[] = {
         FLAGS, .unit = "use_mfra_for" },
     {"use_tfdt", "use tfdt for fragment timestamps", OFFSET(use_tfdt), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"frag_window", "read fragments on demand, keeping the samples of at most this many in the index (0 = read all when opening)",
+        OFFSET(frag_window), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
     { "export_all", "Export unrecognized metadata entries", OFFSET(export_all),
         AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { "export_xmp", "Export full XMP metadata", OFFSET(export_xmp),
@@ -56,6 +56,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/stereo3d.h"
 #include "libavutil/timecode.h"
@@ -100,7 +101,8 @@ static const AVOption options[] = {
       { "frag_keyframe", "Fragment at video keyframes", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_KEYFRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "global_sidx", "Write a global sidx index at the start of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_GLOBAL_SIDX}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "isml", "Create a live smooth streaming feed (for pushing to a publishing point)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_ISML}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
-      { "moov_size", "maximum moov size so it can be placed at the begin", offsetof(MOVMuxContext, reserved_moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = 0 },
+      { "moov_size", "maximum moov size so it can be placed at the begin", offsetof(MOVMuxContext, reserved_moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, -1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "moov_size" },
+          { "auto", "Estimate it from the streams, and move the moov atom with a second pass if it is exceeded", 0, AV_OPT_TYPE_CONST, {.i64 = -1}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "moov_size" },
       { "negative_cts_offsets", "Use negative CTS offsets (reducing the need for edit lists)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "prefer_icc", "If writing colr atom prioritise usage of ICC profile if it exists in stream packet side data", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_PREFER_ICC}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
@@ -7656,6 +7658,18 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
+    if (mov->reserved_moov_size < 0) {
+        if (mov->flags & FF_MOV_FLAG_FRAGMENT || mov->mode == MODE_AVIF ||
+            !(s->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+            av_log(s, AV_LOG_WARNING, "moov_size auto is only supported for "
+                   "non-fragmented output to a seekable file, ignoring\n");
+            mov->reserved_moov_size = 0;
+        } else {
+            mov->moov_size_auto = 1;
+            mov->flags |= FF_MOV_FLAG_FASTSTART;
+        }
+    }
+
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         mov->reserved_moov_size = -1;
     }
@@ -8071,6 +8085,108 @@ static int mov_init(AVFormatContext *s)
     return 0;
 }
 
+/*
+ * Estimate the number of samples of a track from its expected duration,
+ * 0 if it has none and -1 if the duration is unknown.
+ */
+static int64_t estimate_track_samples(AVFormatContext *s, MOVTrack *track,
+                                      int64_t *duration)
+{
+    AVStream *st = track->st;
+    AVCodecParameters *par = track->par;
+    const AVDictionaryEntry *t;
+    double rate;
+
+    if (!st || is_cover_image(st))
+        return 0;
+
+    *duration = s->duration > 0 ? s->duration : INT64_MAX;
+    if (st->duration > 0) {
+        *duration = FFMIN(*duration, av_rescale_q(st->duration, st->time_base,
+                                                  AV_TIME_BASE_Q));
+    } else if ((t = av_dict_get(st->metadata, "DURATION", NULL, 0))) {
+        /* as copied from a Matroska input */
+        int64_t tag_duration;
+        if (av_parse_time(&tag_duration, t->value, 1) >= 0 && tag_duration > 0)
+            *duration = FFMIN(*duration, tag_duration);
+    }
+    if (*duration == INT64_MAX)
+        return -1;
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        rate = av_q2d(st->avg_frame_rate);
+        if (rate <= 0)
+            rate = 60;
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        rate = par->sample_rate / (double)(par->frame_size > 0 ? par->frame_size : 1024);
+        break;
+    default:
+        rate = 1;
+        break;
+    }
+    return rate * *duration / AV_TIME_BASE + 1;
+}
+
+/*
+ * Estimate the size of the moov atom of a non-fragmented file from the
+ * codec parameters and the expected durations of the streams, with some
+ * margin, or return 0 if a duration is unknown.
+ */
+static int64_t estimate_moov_size(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    const AVDictionaryEntry *t = NULL;
+    int64_t size = 4096, total_samples = 0, total_bytes = 0;
+    int i, offset_size;
+
+    while ((t = av_dict_iterate(s->metadata, t)))
+        size += strlen(t->key) + strlen(t->value) + 32;
+
+    for (i = 0; i < mov->nb_tracks; i++) {
+        int64_t duration, nb_samples = estimate_track_samples(s, &mov->tracks[i], &duration);
+        if (nb_samples < 0)
+            return 0;
+        total_samples += nb_samples;
+        total_bytes   += mov->tracks[i].par->bit_rate / 8 * (duration / AV_TIME_BASE);
+    }
+    /* co64 instead of stco */
+    offset_size = total_bytes > UINT32_MAX ? 8 : 4;
+
+    for (i = 0; i < mov->nb_tracks; i++) {
+        MOVTrack *track = &mov->tracks[i];
+        AVCodecParameters *par = track->par;
+        int64_t duration, nb_chunks, bytes_per_sample = 4; /* stsz */
+        int64_t nb_samples = estimate_track_samples(s, track, &duration);
+
+        size += 1024 + par->extradata_size;
+        if (track->st) {
+            t = NULL;
+            while ((t = av_dict_iterate(track->st->metadata, t)))
+                size += strlen(t->key) + strlen(t->value) + 32;
+        }
+        if (!nb_samples)
+            continue;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO)
+            bytes_per_sample += 3 + (par->video_delay ? 8 : 0); /* stss, stts, ctts */
+        else if (par->codec_type != AVMEDIA_TYPE_AUDIO)
+            bytes_per_sample += 8; /* stts */
+
+        /* interleaving starts a new chunk about every time another track
+         * had samples, a single track is split every 1 MiB */
+        if (total_samples > nb_samples)
+            nb_chunks = FFMIN(nb_samples, total_samples - nb_samples + 1);
+        else
+            nb_chunks = nb_samples / 8 + 1;
+
+        size += nb_samples * bytes_per_sample + nb_chunks * (offset_size + 8 /* stsc */);
+    }
+
+    return size + size / 16;
+}
+
 static int mov_write_header(AVFormatContext *s)
 {
     AVIOContext *pb = s->pb;
@@ -8151,6 +8267,19 @@ static int mov_write_header(AVFormatContext *s)
             return ret;
     }
 
+    if (mov->moov_size_auto) {
+        int64_t size = estimate_moov_size(s);
+        if (size > 0) {
+            mov->reserved_moov_size = FFMIN(size, INT_MAX);
+            av_log(s, AV_LOG_VERBOSE, "Reserving %d bytes for the moov atom\n",
+                   mov->reserved_moov_size);
+        } else {
+            av_log(s, AV_LOG_VERBOSE, "Cannot estimate the moov atom size "
+                   "without a duration, it will be moved with a second pass\n");
+            mov->moov_size_auto = 0;
+        }
+    }
+
     if (mov->reserved_moov_size){
         mov->reserved_header_pos = avio_tell(pb);
         if (mov->reserved_moov_size > 0)
@@ -8170,7 +8299,7 @@ static int mov_write_header(AVFormatContext *s)
             mov->mdat_pos = avio_tell(pb);
         }
     } else if (mov->mode != MODE_AVIF) {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && !mov->moov_size_auto)
             mov->reserved_header_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
@@ -8319,6 +8448,68 @@ static int shift_data(AVFormatContext *s)
     return ff_format_shift_data(s, mov->reserved_header_pos, moov_size);
 }
 
+/*
+ * Write the moov atom in the space reserved with moov_size auto, followed by
+ * a free atom filling the rest. If it does not fit, the media data is shifted
+ * by the missing amount only.
+ */
+static int mov_write_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int reserved = mov->reserved_moov_size;
+    int moov_size = get_moov_size(s);
+    int shift, moov_size2, ret;
+    int64_t size;
+
+    if (moov_size < 0)
+        return moov_size;
+
+    if (moov_size == reserved || moov_size + 8 <= reserved) {
+        av_log(s, AV_LOG_INFO, "moov atom of %d bytes written in the reserved "
+               "space, %d bytes unused\n", moov_size, reserved - moov_size);
+        shift = 0;
+    } else {
+        /* a free atom takes at least 8 bytes, so a moov atom slightly
+         * smaller than the reserved space needs a shift too */
+        shift = moov_size > reserved ? moov_size - reserved : moov_size + 8 - reserved;
+        for (int i = 0; i < mov->nb_tracks; i++)
+            mov->tracks[i].data_offset += shift;
+
+        /* the offsets may have switched from stco to co64 */
+        moov_size2 = get_moov_size(s);
+        if (moov_size2 < 0)
+            return moov_size2;
+        if (moov_size2 != moov_size) {
+            for (int i = 0; i < mov->nb_tracks; i++)
+                mov->tracks[i].data_offset += moov_size2 - moov_size;
+            shift    += moov_size2 - moov_size;
+            moov_size = moov_size2;
+        }
+
+        av_log(s, AV_LOG_WARNING, "moov atom of %d bytes exceeds the reserved %d "
+               "bytes, shifting the media data by %d bytes\n",
+               moov_size, reserved, shift);
+        /* the data up to the current position is shifted */
+        avio_seek(pb, moov_pos, SEEK_SET);
+        if ((ret = ff_format_shift_data(s, mov->reserved_header_pos + reserved, shift)) < 0)
+            return ret;
+        moov_pos += shift;
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    if ((ret = mov_write_moov_tag(pb, mov, s)) < 0)
+        return ret;
+    size = reserved + shift - (avio_tell(pb) - mov->reserved_header_pos);
+    if (size > 0) {
+        avio_wb32(pb, size);
+        ffio_wfourcc(pb, "free");
+        ffio_fill(pb, 0, size - 8);
+    }
+    avio_seek(pb, moov_pos, SEEK_SET);
+    return 0;
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -8411,7 +8602,10 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->moov_size_auto) {
+            if ((res = mov_write_reserved_moov(s, moov_pos)) < 0)
+                return res;
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
             if (res < 0)
@@ -221,6 +221,7 @@ typedef struct MOVMuxContext {
     int video_track_timescale;
 
     int reserved_moov_size; ///< 0 for disabled, -1 for automatic, size otherwise
+    int moov_size_auto;     ///< reserved_moov_size is an estimate, moved with a second pass if exceeded
     int64_t reserved_header_pos;
 
     char *major_brand;
@@ -707,6 +707,7 @@ const FFInputFormat ff_mpegps_demuxer = {
     .read_header    = mpegps_read_header,
     .read_packet    = mpegps_read_packet,
     .read_timestamp = mpegps_read_dts,
+    .flags_internal = FF_INFMT_FLAG_COMPACT_INDEX,
 };
 
 #if CONFIG_VOBSUB_DEMUXER
@@ -3446,7 +3446,8 @@ const FFInputFormat ff_mpegts_demuxer = {
     .read_packet    = mpegts_read_packet,
     .read_close     = mpegts_read_close,
     .read_timestamp = mpegts_get_dts,
-    .flags_internal  = FF_INFMT_FLAG_PREFER_CODEC_FRAMERATE,
+    .flags_internal  = FF_INFMT_FLAG_PREFER_CODEC_FRAMERATE |
+                       FF_INFMT_FLAG_COMPACT_INDEX,
 };
 
 const FFInputFormat ff_mpegtsraw_demuxer = {
@@ -3459,5 +3460,6 @@ const FFInputFormat ff_mpegtsraw_demuxer = {
     .read_packet    = mpegts_raw_read_packet,
     .read_close     = mpegts_read_close,
     .read_timestamp = mpegts_get_dts,
-    .flags_internal  = FF_INFMT_FLAG_PREFER_CODEC_FRAMERATE,
+    .flags_internal  = FF_INFMT_FLAG_PREFER_CODEC_FRAMERATE |
+                       FF_INFMT_FLAG_COMPACT_INDEX,
 };
@@ -62,6 +62,7 @@ const FFInputFormat ff_ ## shortname ## _demuxer = {\
     .read_packet    = ff_raw_read_partial_packet,\
     .raw_codec_id   = id,\
     .priv_data_size = sizeof(FFRawVideoDemuxerContext),\
+    .flags_internal = FF_INFMT_FLAG_COMPACT_INDEX,\
 };
 
 #define FF_DEF_RAWVIDEO_DEMUXER(shortname, longname, probe, ext, id)\
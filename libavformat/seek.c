@@ -31,6 +31,7 @@
 #include "avformat.h"
 #include "avformat_internal.h"
 #include "avio_internal.h"
+#include "compact_index.h"
 #include "demux.h"
 #include "internal.h"
 
@@ -53,7 +54,11 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
     FFStream *const sti = ffstream(st);
     unsigned int max_entries = s->max_index_size / sizeof(AVIndexEntry);
 
-    if ((unsigned) sti->nb_index_entries >= max_entries) {
+    if (sti->compact_index) {
+        if (ff_compact_index_size(sti->compact_index) >= s->max_index_size &&
+            ff_compact_index_halve(sti->compact_index) >= 0)
+            sti->nb_index_entries = ff_compact_index_count(sti->compact_index);
+    } else if ((unsigned) sti->nb_index_entries >= max_entries) {
         int i;
         for (i = 0; 2 * i < sti->nb_index_entries; i++)
             sti->index_entries[i] = sti->index_entries[2 * i];
@@ -61,6 +66,20 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
     }
 }
 
+static int check_index_entry(int64_t *timestamp, int size)
+{
+    if (*timestamp == AV_NOPTS_VALUE)
+        return AVERROR(EINVAL);
+
+    if (size < 0 || size > 0x3FFFFFFF)
+        return AVERROR(EINVAL);
+
+    if (is_relative(*timestamp)) //FIXME this maintains previous behavior but we should shift by the correct offset once known
+        *timestamp -= RELATIVE_TS_BASE;
+
+    return 0;
+}
+
 int ff_add_index_entry(AVIndexEntry **index_entries,
                        int *nb_index_entries,
                        unsigned int *index_entries_allocated_size,
@@ -68,19 +87,14 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
                        int size, int distance, int flags)
 {
     AVIndexEntry *entries, *ie;
-    int index;
+    int index, ret;
 
     if ((unsigned) *nb_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry))
         return -1;
 
-    if (timestamp == AV_NOPTS_VALUE)
-        return AVERROR(EINVAL);
-
-    if (size < 0 || size > 0x3FFFFFFF)
-        return AVERROR(EINVAL);
-
-    if (is_relative(timestamp)) //FIXME this maintains previous behavior but we should shift by the correct offset once known
-        timestamp -= RELATIVE_TS_BASE;
+    ret = check_index_entry(&timestamp, size);
+    if (ret < 0)
+        return ret;
 
     entries = av_fast_realloc(*index_entries,
                               index_entries_allocated_size,
@@ -123,14 +137,43 @@ int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
                        int size, int distance, int flags)
 {
     FFStream *const sti = ffstream(st);
+    const AVFormatContext *s = sti->fmtctx;
     timestamp = ff_wrap_timestamp(st, timestamp);
+
+    if (!sti->compact_index && !sti->index_entries && s && s->iformat &&
+        ffifmt(s->iformat)->flags_internal & FF_INFMT_FLAG_COMPACT_INDEX) {
+        sti->compact_index = ff_compact_index_alloc();
+        if (!sti->compact_index)
+            return AVERROR(ENOMEM);
+    }
+    if (sti->compact_index) {
+        int ret = check_index_entry(&timestamp, size);
+        if (ret < 0)
+            return ret;
+        ret = ff_compact_index_add(sti->compact_index, pos, timestamp,
+                                   size, distance, flags);
+        sti->nb_index_entries = ff_compact_index_count(sti->compact_index);
+        return ret;
+    }
+
     return ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
                               &sti->index_entries_allocated_size, pos,
                               timestamp, size, distance, flags);
 }
 
-int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
-                              int64_t wanted_timestamp, int flags)
+static const AVIndexEntry *get_entry_array(void *entries, int idx)
+{
+    return (const AVIndexEntry *)entries + idx;
+}
+
+static const AVIndexEntry *get_entry_compact(void *ci, int idx)
+{
+    return ff_compact_index_get(ci, idx);
+}
+
+static av_always_inline int index_search(void *entries, int nb_entries,
+                                         const AVIndexEntry *(*get)(void *entries, int idx),
+                                         int64_t wanted_timestamp, int flags)
 {
     int a, b, m;
     int64_t timestamp;
@@ -139,22 +182,22 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
     b = nb_entries;
 
     // Optimize appending index entries at the end.
-    if (b && entries[b - 1].timestamp < wanted_timestamp)
+    if (b && get(entries, b - 1)->timestamp < wanted_timestamp)
         a = b - 1;
 
     while (b - a > 1) {
         m         = (a + b) >> 1;
 
         // Search for the next non-discarded packet.
-        while ((entries[m].flags & AVINDEX_DISCARD_FRAME) && m < b && m < nb_entries - 1) {
+        while ((get(entries, m)->flags & AVINDEX_DISCARD_FRAME) && m < b && m < nb_entries - 1) {
             m++;
-            if (m == b && entries[m].timestamp >= wanted_timestamp) {
+            if (m == b && get(entries, m)->timestamp >= wanted_timestamp) {
                 m = b - 1;
                 break;
             }
         }
 
-        timestamp = entries[m].timestamp;
+        timestamp = get(entries, m)->timestamp;
         if (timestamp >= wanted_timestamp)
             b = m;
         if (timestamp <= wanted_timestamp)
@@ -164,7 +207,7 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
 
     if (!(flags & AVSEEK_FLAG_ANY))
         while (m >= 0 && m < nb_entries &&
-               !(entries[m].flags & AVINDEX_KEYFRAME))
+               !(get(entries, m)->flags & AVINDEX_KEYFRAME))
             m += (flags & AVSEEK_FLAG_BACKWARD) ? -1 : 1;
 
     if (m == nb_entries)
@@ -172,6 +215,13 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
     return m;
 }
 
+int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
+                              int64_t wanted_timestamp, int flags)
+{
+    return index_search((void *)entries, nb_entries, get_entry_array,
+                        wanted_timestamp, flags);
+}
+
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
 {
     int64_t pos_delta = 0;
@@ -203,14 +253,14 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
                 continue;
 
             for (int i1 = 0, i2 = 0; i1 < sti1->nb_index_entries; i1++) {
-                const AVIndexEntry *const e1 = &sti1->index_entries[i1];
+                const AVIndexEntry *const e1 = avformat_index_get_entry(st1, i1);
                 int64_t e1_pts = av_rescale_q(e1->timestamp, st1->time_base, AV_TIME_BASE_Q);
 
                 if (e1->size < (1 << 23))
                     skip = FFMAX(skip, e1->size);
 
                 for (; i2 < sti2->nb_index_entries; i2++) {
-                    const AVIndexEntry *const e2 = &sti2->index_entries[i2];
+                    const AVIndexEntry *const e2 = avformat_index_get_entry(st2, i2);
                     int64_t e2_pts = av_rescale_q(e2->timestamp, st2->time_base, AV_TIME_BASE_Q);
                     int64_t cur_delta;
                     if (e2_pts < e1_pts || e2_pts - (uint64_t)e1_pts < time_tolerance)
@@ -245,6 +295,9 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
 int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
 {
     const FFStream *const sti = ffstream(st);
+    if (sti->compact_index)
+        return index_search(sti->compact_index, sti->nb_index_entries,
+                            get_entry_compact, wanted_timestamp, flags);
     return ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
                                      wanted_timestamp, flags);
 }
@@ -259,6 +312,8 @@ const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx)
     const FFStream *const sti = ffstream(st);
     if (idx < 0 || idx >= sti->nb_index_entries)
         return NULL;
+    if (sti->compact_index)
+        return ff_compact_index_get(sti->compact_index, idx);
 
     return &sti->index_entries[idx];
 }
@@ -267,15 +322,9 @@ const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
                                                             int64_t wanted_timestamp,
                                                             int flags)
 {
-    const FFStream *const sti = ffstream(st);
-    int idx = ff_index_search_timestamp(sti->index_entries,
-                                        sti->nb_index_entries,
-                                        wanted_timestamp, flags);
+    int idx = av_index_search_timestamp(st, wanted_timestamp, flags);
 
-    if (idx < 0)
-        return NULL;
-
-    return &sti->index_entries[idx];
+    return avformat_index_get_entry(st, idx);
 }
 
 static int64_t read_timestamp(AVFormatContext *s, int stream_index, int64_t *ppos, int64_t pos_limit,
@@ -309,7 +358,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
 
     st  = s->streams[stream_index];
     sti = ffstream(st);
-    if (sti->index_entries) {
+    if (sti->index_entries || sti->compact_index) {
         const AVIndexEntry *e;
 
         /* FIXME: Whole function must be checked for non-keyframe entries in
@@ -317,7 +366,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
         index = av_index_search_timestamp(st, target_ts,
                                           flags | AVSEEK_FLAG_BACKWARD);
         index = FFMAX(index, 0);
-        e     = &sti->index_entries[index];
+        e     = avformat_index_get_entry(st, index);
 
         if (e->timestamp <= target_ts || e->pos == e->min_distance) {
             pos_min = e->pos;
@@ -332,7 +381,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
                                           flags & ~AVSEEK_FLAG_BACKWARD);
         av_assert0(index < sti->nb_index_entries);
         if (index >= 0) {
-            e = &sti->index_entries[index];
+            e = avformat_index_get_entry(st, index);
             av_assert1(e->timestamp >= target_ts);
             pos_max   = e->pos;
             ts_max    = e->timestamp;
@@ -536,7 +585,7 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     index = av_index_search_timestamp(st, timestamp, flags);
 
     if (index < 0 && sti->nb_index_entries &&
-        timestamp < sti->index_entries[0].timestamp)
+        timestamp < avformat_index_get_entry(st, 0)->timestamp)
         return -1;
 
     if (index < 0 || index == sti->nb_index_entries - 1) {
@@ -544,8 +593,8 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
         int nonkey = 0;
 
         if (sti->nb_index_entries) {
-            av_assert0(sti->index_entries);
-            ie = &sti->index_entries[sti->nb_index_entries - 1];
+            ie = avformat_index_get_entry(st, sti->nb_index_entries - 1);
+            av_assert0(ie);
             if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
                 return ret;
             s->io_repositioned = 1;
@@ -585,7 +634,7 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     if (ffifmt(s->iformat)->read_seek)
         if (ffifmt(s->iformat)->read_seek(s, stream_index, timestamp, flags) >= 0)
             return 0;
-    ie = &sti->index_entries[index];
+    ie = avformat_index_get_entry(st, index);
     if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
         return ret;
     s->io_repositioned = 1;
@@ -0,0 +1,129 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compare the compact index to the plain one, adding the same entries to
+ * both, in order, in random order and with updates of existing entries.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavformat/compact_index.h"
+#include "libavformat/demux.h"
+
+typedef struct TestIndex {
+    AVIndexEntry   *entries;
+    int             nb_entries;
+    unsigned int    allocated_size;
+    FFCompactIndex *ci;
+} TestIndex;
+
+static int add(TestIndex *t, int64_t pos, int64_t timestamp, int size,
+               int distance, int flags)
+{
+    int ret1 = ff_add_index_entry(&t->entries, &t->nb_entries, &t->allocated_size,
+                                  pos, timestamp, size, distance, flags);
+    int ret2 = ff_compact_index_add(t->ci, pos, timestamp, size, distance, flags);
+
+    if (ret1 != ret2) {
+        printf("add ts %"PRId64": index %d, compact index %d\n", timestamp, ret1, ret2);
+        return -1;
+    }
+    return 0;
+}
+
+static int compare(TestIndex *t, const char *name)
+{
+    int n = ff_compact_index_count(t->ci);
+
+    if (n != t->nb_entries) {
+        printf("%s: %d entries, compact index %d\n", name, t->nb_entries, n);
+        return -1;
+    }
+    /* both in order and from the end, to access the blocks out of order */
+    for (int i = 0; i < 2 * n; i++) {
+        int idx = i < n ? i : 2 * n - 1 - i;
+        const AVIndexEntry *e1 = &t->entries[idx];
+        const AVIndexEntry *e2 = ff_compact_index_get(t->ci, idx);
+
+        if (!e2 || e1->pos != e2->pos || e1->timestamp != e2->timestamp ||
+            e1->size != e2->size || e1->flags != e2->flags ||
+            e1->min_distance != e2->min_distance) {
+            printf("%s: entry %d differs\n", name, idx);
+            return -1;
+        }
+    }
+    printf("%s: %d entries\n", name, n);
+    return 0;
+}
+
+static int test(const char *name, int nb_entries, int random, int halve)
+{
+    TestIndex t = { .ci = ff_compact_index_alloc() };
+    AVLFG lfg;
+    int ret = 0;
+
+    if (!t.ci)
+        return -1;
+    av_lfg_init(&lfg, 0xC0FFEE);
+
+    for (int i = 0; i < nb_entries && ret >= 0; i++) {
+        int64_t ts = random ? av_lfg_get(&lfg) % (4 * nb_entries) - nb_entries
+                            : i * 3600LL - 1000000;
+        int64_t pos = random ? av_lfg_get(&lfg) * 188LL : i * 65536LL + (av_lfg_get(&lfg) & 0xFFFF);
+        int size = av_lfg_get(&lfg) & 0x3FFFF;
+        int distance = av_lfg_get(&lfg) & 0xFF;
+        int flags = av_lfg_get(&lfg) & 3;
+
+        ret = add(&t, pos, ts, size, distance, flags);
+        /* update an entry with the same position */
+        if (ret >= 0 && random && !(i & 7))
+            ret = add(&t, pos, ts, size + 1, distance / 2, flags);
+    }
+    if (ret >= 0 && halve) {
+        int i;
+        for (i = 0; 2 * i < t.nb_entries; i++)
+            t.entries[i] = t.entries[2 * i];
+        t.nb_entries = i;
+        ret = ff_compact_index_halve(t.ci);
+    }
+    if (ret >= 0)
+        ret = compare(&t, name);
+
+    av_freep(&t.entries);
+    ff_compact_index_free(&t.ci);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    ret |= test("empty",         0,    0, 0);
+    ret |= test("one block",     FF_COMPACT_INDEX_BLOCK_SIZE, 0, 0);
+    ret |= test("append",        100000, 0, 0);
+    ret |= test("append halved", 100001, 0, 1);
+    ret |= test("random",        20000, 1, 0);
+    ret |= test("random halved", 20000, 1, 1);
+
+    return !!ret;
+}
@@ -0,0 +1,154 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Writes a file through io_uring in requests of varying sizes, reads it
+ * back sequentially and after seeks, overwrites a part of it, and closes
+ * the ring while reads are still in flight. Succeeds without testing
+ * anything when the kernel does not provide io_uring.
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/macros.h"
+
+#include "libavformat/uring.h"
+
+#define FILE_SIZE  100000
+#define DEPTH      4
+#define BUF_SIZE   4096
+
+static uint8_t ref[FILE_SIZE];
+
+static int write_file(int fd, AVLFG *lfg)
+{
+    FFURing *r;
+    int ret, pos = 0;
+
+    if ((ret = ff_uring_alloc(&r, fd, 0, DEPTH, BUF_SIZE)) < 0)
+        return ret;
+    while (pos < FILE_SIZE) {
+        int size = 1 + av_lfg_get(lfg) % (2 * BUF_SIZE);
+        size = FFMIN(size, FILE_SIZE - pos);
+        if ((ret = ff_uring_write(r, ref + pos, size)) != size) {
+            fprintf(stderr, "write of %d bytes at %d returned %d\n", size, pos, ret);
+            ff_uring_free(&r);
+            return -1;
+        }
+        pos += size;
+    }
+    return ff_uring_free(&r);
+}
+
+static int check_read(FFURing *r, AVLFG *lfg, int64_t pos, int len)
+{
+    uint8_t buf[2 * BUF_SIZE];
+
+    while (len > 0) {
+        int size = 1 + av_lfg_get(lfg) % sizeof(buf);
+        int ret  = ff_uring_read(r, buf, size);
+
+        if (pos == FILE_SIZE) {
+            if (ret != AVERROR_EOF) {
+                fprintf(stderr, "read at the end of the file returned %d\n", ret);
+                return -1;
+            }
+            return 0;
+        }
+        if (ret <= 0 || ret > size || memcmp(buf, ref + pos, ret)) {
+            fprintf(stderr, "read of %d bytes at %"PRId64" returned %d or wrong data\n",
+                    size, pos, ret);
+            return -1;
+        }
+        pos += ret;
+        len -= ret;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    const char *filename = "uring.tmp";
+    FFURing *r = NULL;
+    AVLFG lfg;
+    int fd, ret;
+
+    av_lfg_init(&lfg, 1);
+    for (int i = 0; i < FILE_SIZE; i++)
+        ref[i] = av_lfg_get(&lfg);
+
+    fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror(filename);
+        return 1;
+    }
+    unlink(filename);
+
+    ret = write_file(fd, &lfg);
+    if (ret == AVERROR(ENOSYS) || ret == AVERROR(EPERM)) {
+        fprintf(stderr, "io_uring not available, skipping\n");
+        close(fd);
+        return 0;
+    }
+    if (ret < 0)
+        goto fail;
+
+    /* sequential reading up to the end of the file */
+    if ((ret = ff_uring_alloc(&r, fd, 0, DEPTH, BUF_SIZE)) < 0 ||
+        (ret = check_read(r, &lfg, 0, FILE_SIZE + 1)) < 0)
+        goto fail;
+
+    /* reads after seeks, dropping the reads queued ahead */
+    for (int i = 0; i < 50; i++) {
+        int64_t pos = av_lfg_get(&lfg) % (FILE_SIZE + 1);
+        if ((ret = ff_uring_seek(r, pos)) != pos ||
+            (ret = check_read(r, &lfg, pos, av_lfg_get(&lfg) % (3 * BUF_SIZE))) < 0) {
+            fprintf(stderr, "seek to %"PRId64" failed\n", pos);
+            goto fail;
+        }
+    }
+
+    /* overwrite a part of the file in the middle of reading it */
+    for (int i = 5000; i < 15000; i++)
+        ref[i] = ~ref[i];
+    if ((ret = ff_uring_seek(r, 5000)) < 0 ||
+        (ret = ff_uring_write(r, ref + 5000, 10000)) != 10000 ||
+        (ret = ff_uring_seek(r, 0)) < 0 ||
+        (ret = check_read(r, &lfg, 0, FILE_SIZE + 1)) < 0)
+        goto fail;
+
+    /* close with reads in flight */
+    if ((ret = ff_uring_seek(r, 0)) < 0 ||
+        (ret = check_read(r, &lfg, 0, 1)) < 0 ||
+        (ret = ff_uring_free(&r)) < 0)
+        goto fail;
+
+    close(fd);
+    return 0;
+fail:
+    fprintf(stderr, "test failed: %s\n", av_err2str(ret < 0 ? ret : AVERROR_BUG));
+    ff_uring_free(&r);
+    close(fd);
+    return 1;
+}
@@ -0,0 +1,540 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Needed for syscall() */
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+
+#include "uring.h"
+
+/* user_data of cancellation requests, whose completions are ignored */
+#define URING_CANCEL UINT64_MAX
+
+enum URingState {
+    URING_FREE,
+    URING_FILLING,  ///< write buffer not yet queued
+    URING_BUSY,     ///< queued for or owned by the kernel
+    URING_DONE,     ///< completed, result in res
+};
+
+typedef struct URingRequest {
+    uint8_t        *data;
+    struct iovec    iov;
+    enum URingState state;
+    int             write;
+    int64_t         pos;
+    /* size of the request; for writes, the amount of data in the buffer */
+    int             len;
+    /* bytes written so far, or bytes of a completed read consumed so far */
+    int             done;
+    int             res;
+} URingRequest;
+
+struct FFURing {
+    int ring_fd;
+    int fd;
+
+    void                *sq_ring;
+    void                *cq_ring;
+    size_t               sq_ring_size;
+    size_t               cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t               sqes_size;
+
+    atomic_uint         *sq_tail;
+    unsigned            *sq_array;
+    unsigned             sq_mask;
+    atomic_uint         *cq_head;
+    atomic_uint         *cq_tail;
+    struct io_uring_cqe *cqes;
+    unsigned             cq_mask;
+
+    /* queued entries not yet passed to io_uring_enter() */
+    unsigned to_submit;
+    /* requests owned by the kernel */
+    int busy;
+
+    /* requests in use, in file order, starting at first */
+    URingRequest *reqs;
+    int           nb_reqs;
+    int           first;
+    int           count;
+    int           buf_size;
+
+    int64_t pos;
+    /* position of the next read to queue */
+    int64_t read_pos;
+    /* first error of a write, reported by the next call */
+    int     error;
+};
+
+static void uring_queue(FFURing *r, int idx)
+{
+    URingRequest *req = &r->reqs[idx];
+    unsigned tail = atomic_load_explicit(r->sq_tail, memory_order_relaxed);
+    struct io_uring_sqe *sqe = &r->sqes[tail & r->sq_mask];
+
+    req->iov.iov_base = req->data + (req->write ? req->done : 0);
+    req->iov.iov_len  = req->len  - (req->write ? req->done : 0);
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = r->fd;
+    sqe->addr      = (uintptr_t)&req->iov;
+    sqe->len       = 1;
+    sqe->off       = req->pos + (req->write ? req->done : 0);
+    sqe->user_data = idx;
+
+    r->sq_array[tail & r->sq_mask] = tail & r->sq_mask;
+    atomic_store_explicit(r->sq_tail, tail + 1, memory_order_release);
+
+    req->state = URING_BUSY;
+    r->to_submit++;
+    r->busy++;
+}
+
+/**
+ * Pass the queued entries to the kernel, and wait for at least one
+ * completion if requested.
+ */
+static int uring_submit(FFURing *r, int wait)
+{
+    while (r->to_submit || wait) {
+        unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+        int ret = syscall(__NR_io_uring_enter, r->ring_fd, r->to_submit,
+                          wait, flags, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        r->to_submit -= FFMIN(ret, r->to_submit);
+        if (wait || !ret)
+            break;
+    }
+    return 0;
+}
+
+static void uring_reap(FFURing *r)
+{
+    unsigned head = atomic_load_explicit(r->cq_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(r->cq_tail, memory_order_acquire);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &r->cqes[head & r->cq_mask];
+        URingRequest *req;
+
+        if (cqe->user_data == URING_CANCEL)
+            continue;
+        req        = &r->reqs[cqe->user_data];
+        req->res   = cqe->res;
+        req->state = URING_DONE;
+        r->busy--;
+    }
+    atomic_store_explicit(r->cq_head, head, memory_order_release);
+}
+
+static int uring_wait(FFURing *r, int idx)
+{
+    int ret = uring_submit(r, 0);
+    if (ret < 0)
+        return ret;
+
+    uring_reap(r);
+    while (r->reqs[idx].state == URING_BUSY) {
+        ret = uring_submit(r, 1);
+        if (ret < 0)
+            return ret;
+        uring_reap(r);
+    }
+    return 0;
+}
+
+static void uring_release(FFURing *r)
+{
+    r->reqs[r->first].state = URING_FREE;
+    r->first = (r->first + 1) % r->nb_reqs;
+    r->count--;
+}
+
+/**
+ * Release completed writes in order, waiting for at least nb_wait of them.
+ */
+static int uring_retire_writes(FFURing *r, int nb_wait)
+{
+    while (r->count) {
+        URingRequest *req = &r->reqs[r->first];
+        int ret;
+
+        if (req->state != URING_DONE && !nb_wait)
+            break;
+        if (req->state == URING_FILLING)
+            uring_queue(r, r->first);
+        ret = uring_wait(r, r->first);
+        if (ret < 0)
+            return ret;
+
+        if (req->res == -EINTR || req->res == -EAGAIN) {
+            uring_queue(r, r->first);
+            continue;
+        } else if (req->res > 0 && req->done + req->res < req->len) {
+            /* short write, queue the rest */
+            req->done += req->res;
+            uring_queue(r, r->first);
+            continue;
+        } else if (req->res <= 0 && !r->error) {
+            r->error = req->res ? AVERROR(-req->res) : AVERROR(EIO);
+        }
+
+        uring_release(r);
+        nb_wait = FFMAX(nb_wait - 1, 0);
+    }
+    return 0;
+}
+
+/**
+ * Ask the kernel to cancel the reads in flight, which are being dropped.
+ * They still complete, with -ECANCELED unless they were already running.
+ */
+static int uring_cancel_reads(FFURing *r)
+{
+    unsigned tail;
+    int ret = uring_submit(r, 0);
+    if (ret < 0)
+        return ret;
+
+    /* all entries were consumed by the submission, so there is room for
+     * one cancellation per request; their completions fit as well, as the
+     * completion queue is twice as large as the submission queue */
+    uring_reap(r);
+    tail = atomic_load_explicit(r->sq_tail, memory_order_relaxed);
+    for (int i = 0; i < r->count; i++) {
+        int idx = (r->first + i) % r->nb_reqs;
+        struct io_uring_sqe *sqe;
+
+        if (r->reqs[idx].state != URING_BUSY)
+            continue;
+
+        sqe = &r->sqes[tail & r->sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->fd        = -1;
+        sqe->addr      = idx;
+        sqe->user_data = URING_CANCEL;
+
+        r->sq_array[tail & r->sq_mask] = tail & r->sq_mask;
+        tail++;
+        r->to_submit++;
+    }
+    atomic_store_explicit(r->sq_tail, tail, memory_order_release);
+
+    return uring_submit(r, 0);
+}
+
+static int uring_drain(FFURing *r)
+{
+    int ret;
+
+    if (r->count && r->reqs[r->first].write) {
+        ret = uring_retire_writes(r, INT_MAX);
+        if (ret < 0)
+            return ret;
+    } else if (r->count) {
+        ret = uring_cancel_reads(r);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* the buffers can only be reused once the kernel is done with them */
+    while (r->count) {
+        ret = uring_wait(r, r->first);
+        if (ret < 0)
+            return ret;
+        uring_release(r);
+    }
+    r->read_pos = r->pos;
+
+    return 0;
+}
+
+int ff_uring_read(FFURing *r, uint8_t *buf, int size)
+{
+    URingRequest *req;
+    int ret;
+
+    if (r->count && r->reqs[r->first].write) {
+        ret = uring_drain(r);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* keep the queue full of reads ahead of the position */
+    while (r->count < r->nb_reqs) {
+        int idx = (r->first + r->count) % r->nb_reqs;
+
+        req        = &r->reqs[idx];
+        req->write = 0;
+        req->pos   = r->read_pos;
+        req->len   = r->buf_size;
+        req->done  = 0;
+        uring_queue(r, idx);
+
+        r->read_pos += r->buf_size;
+        r->count++;
+    }
+
+    req = &r->reqs[r->first];
+    while (1) {
+        ret = uring_wait(r, r->first);
+        if (ret < 0)
+            return ret;
+        if (req->res != -EINTR && req->res != -EAGAIN)
+            break;
+        uring_queue(r, r->first);
+    }
+
+    if (req->res <= 0) {
+        int err = req->res ? AVERROR(-req->res) : AVERROR_EOF;
+        ret = uring_drain(r);
+        return ret < 0 ? ret : err;
+    }
+
+    size = FFMIN(size, req->res - req->done);
+    memcpy(buf, req->data + req->done, size);
+    req->done += size;
+    r->pos    += size;
+
+    if (req->done == req->res) {
+        int short_read = req->res < req->len;
+
+        uring_release(r);
+        /* the following reads were queued at the wrong positions */
+        if (short_read) {
+            ret = uring_drain(r);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return size;
+}
+
+int ff_uring_write(FFURing *r, const uint8_t *buf, int size)
+{
+    int ret, written = 0;
+
+    if (r->count && !r->reqs[r->first].write) {
+        ret = uring_drain(r);
+        if (ret < 0)
+            return ret;
+    }
+
+    while (written < size) {
+        URingRequest *req = NULL;
+        int idx, len;
+
+        ret = uring_retire_writes(r, 0);
+        if (ret < 0)
+            return ret;
+        if (r->error)
+            return r->error;
+
+        if (r->count) {
+            idx = (r->first + r->count - 1) % r->nb_reqs;
+            req = &r->reqs[idx];
+        }
+        if (!req || req->state != URING_FILLING) {
+            if (r->count == r->nb_reqs) {
+                ret = uring_retire_writes(r, 1);
+                if (ret < 0)
+                    return ret;
+                continue;
+            }
+
+            idx        = (r->first + r->count) % r->nb_reqs;
+            req        = &r->reqs[idx];
+            req->state = URING_FILLING;
+            req->write = 1;
+            req->pos   = r->pos;
+            req->len   = 0;
+            req->done  = 0;
+            r->count++;
+        }
+
+        len = FFMIN(size - written, r->buf_size - req->len);
+        memcpy(req->data + req->len, buf + written, len);
+        req->len += len;
+        written  += len;
+        r->pos   += len;
+
+        if (req->len == r->buf_size) {
+            uring_queue(r, idx);
+            /* pass the writes to the kernel in batches */
+            if (r->to_submit >= FFMAX(r->nb_reqs / 2, 1)) {
+                ret = uring_submit(r, 0);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+    }
+
+    return size;
+}
+
+int64_t ff_uring_seek(FFURing *r, int64_t pos)
+{
+    int ret = uring_drain(r);
+    if (ret < 0)
+        return ret;
+    if (r->error)
+        return r->error;
+
+    r->pos = r->read_pos = pos;
+    return pos;
+}
+
+int64_t ff_uring_tell(const FFURing *r)
+{
+    return r->pos;
+}
+
+int ff_uring_free(FFURing **pr)
+{
+    FFURing *r = *pr;
+    int ret = 0;
+
+    if (!r)
+        return 0;
+
+    if (r->reqs) {
+        ret = uring_drain(r);
+        if (!ret)
+            ret = r->error;
+    }
+
+    if (r->sqes)
+        munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring && r->cq_ring != r->sq_ring)
+        munmap(r->cq_ring, r->cq_ring_size);
+    if (r->sq_ring)
+        munmap(r->sq_ring, r->sq_ring_size);
+    if (r->ring_fd >= 0)
+        close(r->ring_fd);
+
+    if (r->reqs)
+        av_freep(&r->reqs[0].data);
+    av_freep(&r->reqs);
+    av_freep(pr);
+
+    return ret;
+}
+
+static void *uring_mmap(FFURing *r, size_t size, off_t offset)
+{
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     r->ring_fd, offset);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+int ff_uring_alloc(FFURing **pr, int fd, int64_t pos, int nb_requests, int buf_size)
+{
+    struct io_uring_params p = { 0 };
+    uint8_t *data;
+    FFURing *r;
+    int ret;
+
+    r = av_mallocz(sizeof(*r));
+    if (!r)
+        return AVERROR(ENOMEM);
+    *pr = r;
+
+    r->fd       = fd;
+    r->pos      = r->read_pos = pos;
+    r->buf_size = buf_size;
+
+    r->ring_fd = syscall(__NR_io_uring_setup, nb_requests, &p);
+    if (r->ring_fd < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+
+    r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        r->sq_ring_size = r->cq_ring_size = FFMAX(r->sq_ring_size, r->cq_ring_size);
+
+    r->sq_ring = uring_mmap(r, r->sq_ring_size, IORING_OFF_SQ_RING);
+    if (!r->sq_ring) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ring = r->sq_ring;
+    } else {
+        r->cq_ring = uring_mmap(r, r->cq_ring_size, IORING_OFF_CQ_RING);
+        if (!r->cq_ring) {
+            ret = AVERROR(errno);
+            goto fail;
+        }
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes      = uring_mmap(r, r->sqes_size, IORING_OFF_SQES);
+    if (!r->sqes) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+
+    r->sq_tail  = (atomic_uint *)((uint8_t *)r->sq_ring + p.sq_off.tail);
+    r->sq_array =    (unsigned *)((uint8_t *)r->sq_ring + p.sq_off.array);
+    r->sq_mask  = *(unsigned *)((uint8_t *)r->sq_ring + p.sq_off.ring_mask);
+    r->cq_head  = (atomic_uint *)((uint8_t *)r->cq_ring + p.cq_off.head);
+    r->cq_tail  = (atomic_uint *)((uint8_t *)r->cq_ring + p.cq_off.tail);
+    r->cqes     = (struct io_uring_cqe *)((uint8_t *)r->cq_ring + p.cq_off.cqes);
+    r->cq_mask  = *(unsigned *)((uint8_t *)r->cq_ring + p.cq_off.ring_mask);
+
+    /* the submission queue can hold all requests, and the completion
+     * queue is at least as large, so neither can overflow */
+    r->nb_reqs = FFMIN(nb_requests, p.sq_entries);
+    r->reqs    = av_calloc(r->nb_reqs, sizeof(*r->reqs));
+    data       = av_malloc_array(r->nb_reqs, buf_size);
+    if (!r->reqs || !data) {
+        av_free(data);
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (int i = 0; i < r->nb_reqs; i++)
+        r->reqs[i].data = data + (size_t)i * buf_size;
+
+    return 0;
+fail:
+    ff_uring_free(pr);
+    return ret;
+}
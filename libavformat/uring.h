@@ -0,0 +1,85 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_URING_H
+#define AVFORMAT_URING_H
+
+/**
+ * @file
+ * Asynchronous reads and writes of a regular file through a Linux io_uring.
+ *
+ * Reading keeps a number of fixed-size reads in flight ahead of the current
+ * position. Writing copies the data into the same kind of buffers, which are
+ * submitted to the kernel in batches and completed in the background; errors
+ * are reported by a later call. All I/O uses explicit offsets, the file
+ * position of the descriptor is neither used nor updated.
+ */
+
+#include <stdint.h>
+
+typedef struct FFURing FFURing;
+
+/**
+ * Set up asynchronous I/O on a file descriptor.
+ *
+ * @param fd          descriptor of a regular file, which must stay open until
+ *                    ff_uring_free() is called
+ * @param pos         initial position
+ * @param nb_requests maximum number of requests in flight
+ * @param buf_size    size of each request
+ * @return 0 on success, or a negative error code, e.g. AVERROR(ENOSYS) if
+ *         the kernel does not support io_uring
+ */
+int ff_uring_alloc(FFURing **pr, int fd, int64_t pos, int nb_requests, int buf_size);
+
+/**
+ * Wait for all writes in flight and cancel the reads ahead of the position,
+ * then free the context.
+ *
+ * @return the first error of a write which was not reported yet, or 0
+ */
+int ff_uring_free(FFURing **pr);
+
+/**
+ * Read up to size bytes from the current position.
+ *
+ * @return the number of bytes read, AVERROR_EOF or another negative error code
+ */
+int ff_uring_read(FFURing *r, uint8_t *buf, int size);
+
+/**
+ * Queue size bytes for writing at the current position.
+ *
+ * @return size, or a negative error code, possibly from an earlier write
+ */
+int ff_uring_write(FFURing *r, const uint8_t *buf, int size);
+
+/**
+ * Wait for all writes in flight, cancel the reads ahead of the position and
+ * set the current position.
+ *
+ * @return pos, or a negative error code, possibly from an earlier write
+ */
+int64_t ff_uring_seek(FFURing *r, int64_t pos);
+
+/**
+ * @return the current position
+ */
+int64_t ff_uring_tell(const FFURing *r);
+
+#endif /* AVFORMAT_URING_H */
@@ -26,6 +26,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -83,6 +84,15 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    /**
+     * Get a new read-only reference to size bytes of the resource mapped
+     * into memory, starting at position pos, and followed by
+     * AV_INPUT_BUFFER_PADDING_SIZE zeroed bytes, which are included in the
+     * size of the buffer. The mapping stays valid after the context is
+     * closed, for as long as references to it exist.
+     * Does not change the position of the context.
+     */
+    int (*url_get_mapping)(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
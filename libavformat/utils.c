@@ -104,6 +104,24 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size)
+{
+    int ret;
+
+    av_packet_unref(pkt);
+    pkt->pos = avio_tell(s);
+
+    ret = ffio_read_zero_copy(s, &pkt->buf, size);
+    if (ret == AVERROR(ENOSYS))
+        return av_get_packet(s, pkt, size);
+    if (ret < 0)
+        return ret;
+
+    pkt->data = pkt->buf->data;
+    pkt->size = size;
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
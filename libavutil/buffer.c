@@ -256,6 +256,91 @@ int av_buffer_replace(AVBufferRef **pdst, const AVBufferRef *src)
     return 0;
 }
 
+#define CACHE_NONE 0xFF
+
+static void buffer_pool_init_cache(AVBufferPool *pool)
+{
+    for (unsigned i = 0; i < BUFFER_POOL_CACHE_SIZE; i++)
+        atomic_init(&pool->cache[i].next, i ? i - 1 : CACHE_NONE);
+    atomic_init(&pool->cache_full,  CACHE_NONE);
+    atomic_init(&pool->cache_empty, BUFFER_POOL_CACHE_SIZE - 1);
+    atomic_init(&pool->nb_pool, 0);
+}
+
+static void cache_push(AVBufferPool *pool, atomic_uint *head, unsigned idx)
+{
+    unsigned old = atomic_load_explicit(head, memory_order_relaxed);
+
+    do {
+        atomic_store_explicit(&pool->cache[idx].next, old & 0xFF, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, (old & ~0xFFu) + 0x100 + idx,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+/* returns the index of the popped slot, CACHE_NONE if the stack is empty */
+static unsigned cache_pop(AVBufferPool *pool, atomic_uint *head)
+{
+    unsigned old = atomic_load_explicit(head, memory_order_acquire);
+    unsigned idx, next;
+
+    do {
+        idx = old & 0xFF;
+        if (idx == CACHE_NONE)
+            return CACHE_NONE;
+        /* may be stale if the slot was taken meanwhile, the tag catches it */
+        next = atomic_load_explicit(&pool->cache[idx].next, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, (old & ~0xFFu) + 0x100 + next,
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+
+    return idx;
+}
+
+/*
+ * Push a free entry to the lock-free cache.
+ * Returns 0 on success, a negative value if the cache is full.
+ */
+static int buffer_pool_cache_put(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    unsigned idx = cache_pop(pool, &pool->cache_empty);
+
+    if (idx == CACHE_NONE)
+        return -1;
+    pool->cache[idx].entry = buf;
+    cache_push(pool, &pool->cache_full, idx);
+    return 0;
+}
+
+/*
+ * Pop the free entry released last from the lock-free cache, NULL if it is
+ * empty.
+ */
+static BufferPoolEntry *buffer_pool_cache_get(AVBufferPool *pool)
+{
+    unsigned idx = cache_pop(pool, &pool->cache_full);
+    BufferPoolEntry *buf;
+
+    if (idx == CACHE_NONE)
+        return NULL;
+    buf = pool->cache[idx].entry;
+    cache_push(pool, &pool->cache_empty, idx);
+    return buf;
+}
+
+/* return a free entry to the pool, preferring the lock-free cache */
+static void buffer_pool_put(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    if (buffer_pool_cache_put(pool, buf) >= 0)
+        return;
+
+    ff_mutex_lock(&pool->mutex);
+    buf->next = pool->pool;
+    pool->pool = buf;
+    atomic_fetch_add_explicit(&pool->nb_pool, 1, memory_order_relaxed);
+    ff_mutex_unlock(&pool->mutex);
+}
+
 AVBufferPool *av_buffer_pool_init2(size_t size, void *opaque,
                                    AVBufferRef* (*alloc)(void *opaque, size_t size),
                                    void (*pool_free)(void *opaque))
@@ -276,6 +361,7 @@ AVBufferPool *av_buffer_pool_init2(size_t size, void *opaque,
     pool->pool_free = pool_free;
 
     atomic_init(&pool->refcount, 1);
+    buffer_pool_init_cache(pool);
 
     return pool;
 }
@@ -295,19 +381,28 @@ AVBufferPool *av_buffer_pool_init(size_t size, AVBufferRef* (*alloc)(size_t size
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
 
     atomic_init(&pool->refcount, 1);
+    buffer_pool_init_cache(pool);
 
     return pool;
 }
 
 static void buffer_pool_flush(AVBufferPool *pool)
 {
+    BufferPoolEntry *buf;
+
+    while ((buf = buffer_pool_cache_get(pool))) {
+        buf->free(buf->opaque, buf->data);
+        av_freep(&buf);
+    }
+
     while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
+        buf = pool->pool;
         pool->pool = buf->next;
 
         buf->free(buf->opaque, buf->data);
         av_freep(&buf);
     }
+    atomic_store_explicit(&pool->nb_pool, 0, memory_order_relaxed);
 }
 
 /*
@@ -347,10 +442,7 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     BufferPoolEntry *buf = opaque;
     AVBufferPool *pool = buf->pool;
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    buffer_pool_put(pool, buf);
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -390,24 +482,35 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
     AVBufferRef *ret;
-    BufferPoolEntry *buf;
+    BufferPoolEntry *buf = NULL;
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
-    if (buf) {
-        memset(&buf->buffer, 0, sizeof(buf->buffer));
-        ret = buffer_create(&buf->buffer, buf->data, pool->size,
-                            pool_release_buffer, buf, 0);
-        if (ret) {
+    /* the entries in the list were released after the ones in the cache */
+    if (!atomic_load_explicit(&pool->nb_pool, memory_order_relaxed))
+        buf = buffer_pool_cache_get(pool);
+    if (!buf) {
+        ff_mutex_lock(&pool->mutex);
+        buf = pool->pool;
+        if (buf) {
             pool->pool = buf->next;
             buf->next = NULL;
-            buf->buffer.flags_internal |= BUFFER_FLAG_NO_FREE;
+            atomic_fetch_sub_explicit(&pool->nb_pool, 1, memory_order_relaxed);
+        } else if (!(buf = buffer_pool_cache_get(pool))) {
+            ret = pool_alloc_buffer(pool);
+            ff_mutex_unlock(&pool->mutex);
+            goto end;
         }
-    } else {
-        ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&pool->mutex);
     }
-    ff_mutex_unlock(&pool->mutex);
 
+    memset(&buf->buffer, 0, sizeof(buf->buffer));
+    ret = buffer_create(&buf->buffer, buf->data, pool->size,
+                        pool_release_buffer, buf, 0);
+    if (ret)
+        buf->buffer.flags_internal |= BUFFER_FLAG_NO_FREE;
+    else
+        buffer_pool_put(pool, buf);
+
+end:
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
 
@@ -85,9 +85,37 @@ typedef struct BufferPoolEntry {
     AVBuffer buffer;
 } BufferPoolEntry;
 
+/**
+ * Number of free entries an AVBufferPool can hold in its lock-free cache,
+ * at most 255. Entries beyond that go to the mutex-protected list.
+ */
+#define BUFFER_POOL_CACHE_SIZE 32
+
+typedef struct BufferPoolSlot {
+    BufferPoolEntry *entry;
+    /* index of the slot below this one in its stack */
+    atomic_uint next;
+} BufferPoolSlot;
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
+    /* number of entries in the list above, read without the mutex */
+    atomic_uint nb_pool;
+
+    /*
+     * Lock-free cache of free entries, used before falling back to the
+     * mutex-protected list above. The slots form two stacks, one of the
+     * slots holding free entries and one of the unused slots, so that the
+     * entry released last, which is most likely still in the CPU caches,
+     * is handed out first. The head of each stack holds the index of its
+     * top slot in the low 8 bits and a tag, incremented on every change,
+     * in the others, so that a slot popped and pushed back in between
+     * does not let a stale compare-and-swap succeed.
+     */
+    atomic_uint cache_full;
+    atomic_uint cache_empty;
+    BufferPoolSlot cache[BUFFER_POOL_CACHE_SIZE];
 
     /*
      * This is used to track when the pool is to be freed.
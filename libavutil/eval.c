@@ -155,6 +155,8 @@ static int strmatch(const char *s, const char *prefix)
     return !IS_IDENTIFIER_CHAR(s[i]);
 }
 
+typedef struct ExprProgram ExprProgram;
+
 struct AVExpr {
     enum {
         e_value, e_const, e_func0, e_func1, e_func2,
@@ -176,6 +178,7 @@ struct AVExpr {
     struct AVExpr *param[3];
     double *var;
     FFSFC64 *prng_state;
+    ExprProgram *prog; // compiled form of the root, see av_expr_eval_batch()
 };
 
 static double etime(double v)
@@ -354,6 +357,8 @@ static double eval_expr(Parser *p, AVExpr *e)
 }
 
 static int parse_expr(AVExpr **e, Parser *p);
+static void free_program(ExprProgram **prog);
+static int compile_expr(AVExpr *e);
 
 void av_expr_free(AVExpr *e)
 {
@@ -363,6 +368,7 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[2]);
     av_freep(&e->var);
     av_freep(&e->prng_state);
+    free_program(&e->prog);
     av_freep(&e);
 }
 
@@ -707,6 +713,54 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/* Whether the value of e only depends on its parameters. */
+static int is_foldable(const AVExpr *e)
+{
+    switch (e->type) {
+    case e_value:
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_random:
+    case e_randomi:
+    case e_print:
+        return 0;
+    case e_func0:
+        return e->a.func0 != etime;
+    default:
+        return 1;
+    }
+}
+
+/* Replace the subtrees which do not depend on constants, user functions
+ * or variables by their value. */
+static void fold_expr(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i, constant = 1;
+
+    for (i = 0; i < 3; i++) {
+        if (!e->param[i])
+            continue;
+        fold_expr(e->param[i]);
+        constant &= e->param[i]->type == e_value;
+    }
+    if (!constant || !is_foldable(e))
+        return;
+
+    e->value = eval_expr(&p, e);
+    e->type  = e_value;
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -749,12 +803,15 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_expr(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     e->prng_state = av_mallocz(sizeof(*e->prng_state) *VARS);
     if (!e->var || !e->prng_state) {
         ret = AVERROR(ENOMEM);
         goto end;
     }
+    if ((ret = compile_expr(e)) < 0)
+        goto end;
     *expr = e;
     e = NULL;
 end:
@@ -800,6 +857,229 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+#define BATCH_SIZE 64
+
+typedef struct ExprInsn {
+    const AVExpr *e;
+    int arg[3];         // instructions computing the parameters, -1 if absent
+} ExprInsn;
+
+/* The root expression flattened into one instruction per node, in an order
+ * where each instruction follows its parameters. Every instruction writes
+ * BATCH_SIZE results into its own register. The program is built when the
+ * expression is parsed and only read afterwards; the registers are allocated
+ * by each call, so that one expression can be evaluated from several threads. */
+struct ExprProgram {
+    ExprInsn *insn;
+    int nb_insn;
+    int nb_consts;      // 1 + highest constant index read by the expression
+    int stateful;       // uses variables or random(), evaluated per element
+};
+
+static void free_program(ExprProgram **pprog)
+{
+    ExprProgram *prog = *pprog;
+
+    if (!prog)
+        return;
+    av_freep(&prog->insn);
+    av_freep(pprog);
+}
+
+static void scan_expr(ExprProgram *prog, const AVExpr *e)
+{
+    for (int i = 0; i < 3 && e->param[i]; i++)
+        scan_expr(prog, e->param[i]);
+
+    switch (e->type) {
+    case e_const:
+        prog->nb_consts = FFMAX(prog->nb_consts, e->const_index + 1);
+        break;
+    case e_ld:
+    case e_st:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_random:
+    case e_randomi:
+    case e_print:
+        prog->stateful = 1;
+        break;
+    }
+    prog->nb_insn++;
+}
+
+static int emit_expr(ExprProgram *prog, const AVExpr *e)
+{
+    ExprInsn *insn;
+    int arg[3];
+
+    for (int i = 0; i < 3; i++)
+        arg[i] = e->param[i] ? emit_expr(prog, e->param[i]) : -1;
+
+    insn = &prog->insn[prog->nb_insn];
+    insn->e = e;
+    memcpy(insn->arg, arg, sizeof(arg));
+    return prog->nb_insn++;
+}
+
+static int compile_expr(AVExpr *e)
+{
+    ExprProgram *prog = av_mallocz(sizeof(*prog));
+
+    if (!prog)
+        return AVERROR(ENOMEM);
+
+    scan_expr(prog, e);
+    if (!prog->stateful) {
+        prog->insn = av_calloc(prog->nb_insn, sizeof(*prog->insn));
+        if (!prog->insn) {
+            free_program(&prog);
+            return AVERROR(ENOMEM);
+        }
+        prog->nb_insn = 0;
+        emit_expr(prog, e);
+    }
+
+    e->prog = prog;
+    return 0;
+}
+
+#define LOOP(x) for (int i = 0; i < n; i++) dst[i] = (x)
+
+/* Each case must compute exactly what eval_expr() does for one element. */
+static void exec_insn(const ExprProgram *prog, double *regs, const double **src,
+                      int idx, int off, int n,
+                      const double * const *const_arrays, void *opaque)
+{
+    const ExprInsn *insn = &prog->insn[idx];
+    const AVExpr *e = insn->e;
+    const double v = e->value;
+    const double *a = insn->arg[0] >= 0 ? src[insn->arg[0]] : NULL;
+    const double *b = insn->arg[1] >= 0 ? src[insn->arg[1]] : NULL;
+    const double *c = insn->arg[2] >= 0 ? src[insn->arg[2]] : NULL;
+    double *dst = regs + idx * BATCH_SIZE;
+
+    src[idx] = dst;
+
+    switch (e->type) {
+    case e_value:
+        break;
+    case e_const: {
+        const double *arr = const_arrays ? const_arrays[e->const_index] : NULL;
+        /* scalar constants are filled in once per call */
+        if (!arr)
+            break;
+        arr += off;
+        if (v == 1)
+            src[idx] = arr;
+        else
+            LOOP(v * arr[i]);
+        break;
+    }
+    case e_func0:  LOOP(v * e->a.func0(a[i]));                    break;
+    case e_func1:  LOOP(v * e->a.func1(opaque, a[i]));            break;
+    case e_func2:  LOOP(v * e->a.func2(opaque, a[i], b[i]));      break;
+    case e_squish: LOOP(1/(1+exp(4*a[i])));                       break;
+    case e_gauss:  LOOP(exp(-a[i]*a[i]/2)/sqrt(2*M_PI));          break;
+    case e_isnan:  LOOP(v * !!isnan(a[i]));                       break;
+    case e_isinf:  LOOP(v * !!isinf(a[i]));                       break;
+    case e_floor:  LOOP(v * floor(a[i]));                         break;
+    case e_ceil:   LOOP(v * ceil (a[i]));                         break;
+    case e_trunc:  LOOP(v * trunc(a[i]));                         break;
+    case e_round:  LOOP(v * round(a[i]));                         break;
+    case e_sgn:    LOOP(v * FFDIFFSIGN(a[i], 0));                 break;
+    case e_sqrt:   LOOP(v * sqrt (a[i]));                         break;
+    case e_not:    LOOP(v * (a[i] == 0));                         break;
+    /* both branches have been evaluated, select per element */
+    case e_if:     LOOP(v * ( a[i] ? b[i] : c ? c[i] : 0));       break;
+    case e_ifnot:  LOOP(v * (!a[i] ? b[i] : c ? c[i] : 0));       break;
+    case e_clip:
+        for (int i = 0; i < n; i++) {
+            double x = a[i], min = b[i], max = c[i];
+            dst[i] = isnan(min) || isnan(max) || isnan(x) || min > max ?
+                     NAN : v * av_clipd(x, min, max);
+        }
+        break;
+    case e_between: LOOP(v * (a[i] >= b[i] && a[i] <= c[i]));    break;
+    case e_lerp:   LOOP(a[i] + (b[i] - a[i]) * c[i]);             break;
+    case e_mod:    LOOP(v * (a[i] - floor(b[i] ? a[i] / b[i] : a[i] * INFINITY) * b[i])); break;
+    case e_gcd:    LOOP(v * av_gcd(a[i], b[i]));                  break;
+    case e_max:    LOOP(v * (a[i] >  b[i] ? a[i] : b[i]));        break;
+    case e_min:    LOOP(v * (a[i] <  b[i] ? a[i] : b[i]));        break;
+    case e_eq:     LOOP(v * (a[i] == b[i] ? 1.0 : 0.0));          break;
+    case e_gt:     LOOP(v * (a[i] >  b[i] ? 1.0 : 0.0));          break;
+    case e_gte:    LOOP(v * (a[i] >= b[i] ? 1.0 : 0.0));          break;
+    case e_lt:     LOOP(v * (a[i] <  b[i] ? 1.0 : 0.0));          break;
+    case e_lte:    LOOP(v * (a[i] <= b[i] ? 1.0 : 0.0));          break;
+    case e_pow:    LOOP(v * pow(a[i], b[i]));                     break;
+    case e_mul:    LOOP(v * (a[i] * b[i]));                       break;
+    case e_div:    LOOP(v * (b[i] ? (a[i] / b[i]) : a[i] * INFINITY)); break;
+    case e_add:    LOOP(v * (a[i] + b[i]));                       break;
+    case e_last:   LOOP(v * b[i]);                                break;
+    case e_hypot:  LOOP(v * hypot(a[i], b[i]));                   break;
+    case e_atan2:  LOOP(v * atan2(a[i], b[i]));                   break;
+    case e_bitand: LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] & (long int)b[i])); break;
+    case e_bitor:  LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] | (long int)b[i])); break;
+    default:       LOOP(NAN);                                     break;
+    }
+}
+
+int av_expr_eval_batch(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    const ExprProgram *prog = e->prog;
+    const double **src;
+    double *regs;
+
+    if (prog->stateful) {
+        double *values = NULL;
+        if (const_arrays) {
+            values = av_malloc_array(FFMAX(prog->nb_consts, 1), sizeof(*values));
+            if (!values)
+                return AVERROR(ENOMEM);
+        }
+        for (int i = 0; i < nb; i++) {
+            if (values)
+                for (int j = 0; j < prog->nb_consts; j++)
+                    values[j] = const_arrays[j] ? const_arrays[j][i] : const_values[j];
+            res[i] = av_expr_eval(e, values ? values : const_values, opaque);
+        }
+        av_free(values);
+        return 0;
+    }
+
+    regs = av_malloc_array(prog->nb_insn, BATCH_SIZE * sizeof(*regs) + sizeof(*src));
+    if (!regs)
+        return AVERROR(ENOMEM);
+    src = (const double **)(regs + prog->nb_insn * BATCH_SIZE);
+
+    /* the registers of values and of scalar constants are filled in once */
+    for (int i = 0; i < prog->nb_insn; i++) {
+        const AVExpr *c = prog->insn[i].e;
+        double *dst = regs + i * BATCH_SIZE;
+        if (c->type == e_value) {
+            for (int j = 0; j < BATCH_SIZE; j++)
+                dst[j] = c->value;
+        } else if (c->type == e_const &&
+                   !(const_arrays && const_arrays[c->const_index])) {
+            for (int j = 0; j < BATCH_SIZE; j++)
+                dst[j] = c->value * const_values[c->const_index];
+        }
+    }
+
+    for (int off = 0; off < nb; off += BATCH_SIZE) {
+        const int n = FFMIN(nb - off, BATCH_SIZE);
+        for (int i = 0; i < prog->nb_insn; i++)
+            exec_insn(prog, regs, src, i, off, n, const_arrays, opaque);
+        memcpy(res + off, src[prog->nb_insn - 1], n * sizeof(*res));
+    }
+
+    av_free(regs);
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
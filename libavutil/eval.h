@@ -87,6 +87,37 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for an array of elements.
+ *
+ * The result for element i is the value av_expr_eval() would return with
+ * every constant which has an array in const_arrays set to element i of
+ * that array. The expression is evaluated for many elements at once, which
+ * is much faster than calling av_expr_eval() per element. Expressions using
+ * ld(), st(), while(), taylor(), root(), random(), randomi() or print() are
+ * still evaluated one element at a time, in order.
+ *
+ * The working memory is allocated by each call, so the same expression may
+ * be evaluated from several threads at once, unless it uses the variables
+ * or random generators stored in the AVExpr, as with av_expr_eval().
+ *
+ * Both branches of if() and ifnot() are evaluated, and user functions may be
+ * called for the elements in any order, so they must not have side effects.
+ *
+ * @param e the AVExpr to evaluate
+ * @param res array where the nb results are stored
+ * @param nb number of elements to evaluate
+ * @param const_values values for the identifiers from av_expr_parse()
+ *                     const_names which have no array in const_arrays
+ * @param const_arrays NULL, or an array indexed like const_values holding
+ *                     either NULL or a pointer to nb values of the constant
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_expr_eval_batch(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
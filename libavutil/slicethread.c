@@ -17,17 +17,32 @@
  */
 
 #include <stdatomic.h>
+#include "buffer.h"
 #include "cpu.h"
 #include "internal.h"
 #include "slicethread.h"
 #include "mem.h"
 #include "thread.h"
+#include "threadpool_internal.h"
 #include "avassert.h"
 
 #define MAX_AUTO_THREADS 16
 
 #if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
 
+/* [begin, end) packed into one word, so that both ends change atomically */
+#define JOB_RANGE(begin, end) ((uint64_t)(end) << 32 | (begin))
+
+/**
+ * Jobs not yet started of one thread when work stealing. The owner takes
+ * jobs from the front, other threads steal from the back.
+ */
+typedef struct JobRange {
+    atomic_uint_least64_t range;
+    /* keep the ranges of different threads in different cache lines */
+    char padding[64 - sizeof(uint64_t)];
+} JobRange;
+
 typedef struct WorkerContext {
     AVSliceThread   *ctx;
     pthread_mutex_t mutex;
@@ -52,8 +67,84 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    AVBufferRef     *pool_ref;  ///< shared pool running the jobs instead of workers
+    FFThreadPoolTask task;
+
+    JobRange        *ranges;    ///< one per thread, only set when work stealing
+    atomic_uint     nb_finished;
 };
 
+static int pop_job(JobRange *r, unsigned *job)
+{
+    uint_least64_t range = atomic_load_explicit(&r->range, memory_order_acquire);
+    unsigned begin, end;
+
+    do {
+        begin = (uint32_t)range;
+        end   = range >> 32;
+        if (begin >= end)
+            return 0;
+    } while (!atomic_compare_exchange_weak_explicit(&r->range, &range,
+                                                    JOB_RANGE(begin + 1, end),
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+
+    *job = begin;
+    return 1;
+}
+
+/**
+ * Move the back half of the largest range left to the empty range of
+ * threadnr. Return 0 once all ranges are empty.
+ */
+static int steal_jobs(AVSliceThread *ctx, int threadnr)
+{
+    while (1) {
+        uint_least64_t range, victim_range = 0;
+        JobRange *victim = NULL;
+        unsigned begin, end, max_jobs = 0;
+
+        for (int i = 0; i < ctx->nb_active_threads; i++) {
+            if (i == threadnr)
+                continue;
+            range = atomic_load_explicit(&ctx->ranges[i].range, memory_order_acquire);
+            begin = (uint32_t)range;
+            end   = range >> 32;
+            if (begin < end && end - begin > max_jobs) {
+                max_jobs     = end - begin;
+                victim       = &ctx->ranges[i];
+                victim_range = range;
+            }
+        }
+        if (!victim)
+            return 0;
+
+        begin = (uint32_t)victim_range;
+        end   = victim_range >> 32;
+        max_jobs = (max_jobs + 1) / 2;
+        if (atomic_compare_exchange_strong_explicit(&victim->range, &victim_range,
+                                                    JOB_RANGE(begin, end - max_jobs),
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            atomic_store_explicit(&ctx->ranges[threadnr].range,
+                                  JOB_RANGE(end - max_jobs, end), memory_order_release);
+            return 1;
+        }
+    }
+}
+
+static void run_stealing_jobs(AVSliceThread *ctx, int threadnr)
+{
+    JobRange *own = &ctx->ranges[threadnr];
+    unsigned job;
+
+    do {
+        while (pop_job(own, &job))
+            ctx->worker_func(ctx->priv, job, threadnr, ctx->nb_jobs, ctx->nb_active_threads);
+    } while (steal_jobs(ctx, threadnr));
+}
+
 static int run_jobs(AVSliceThread *ctx)
 {
     unsigned nb_jobs    = ctx->nb_jobs;
@@ -61,6 +152,12 @@ static int run_jobs(AVSliceThread *ctx)
     unsigned first_job    = atomic_fetch_add_explicit(&ctx->first_job, 1, memory_order_acq_rel);
     unsigned current_job  = first_job;
 
+    if (ctx->ranges) {
+        run_stealing_jobs(ctx, first_job);
+        return atomic_fetch_add_explicit(&ctx->nb_finished, 1, memory_order_acq_rel) ==
+               nb_active_threads - 1;
+    }
+
     do {
         ctx->worker_func(ctx->priv, current_job, first_job, nb_jobs, nb_active_threads);
     } while ((current_job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs);
@@ -68,6 +165,24 @@ static int run_jobs(AVSliceThread *ctx)
     return current_job == nb_jobs + nb_active_threads - 1;
 }
 
+/* Jobs are handed out in order from a single counter, so a job waiting for
+ * an earlier one never waits for a slot the pool did not start. When work
+ * stealing, the ranges of such slots are stolen by the others. */
+static void run_pool_jobs(void *opaque, int slot)
+{
+    AVSliceThread *ctx = opaque;
+    unsigned nb_jobs = ctx->nb_jobs;
+    unsigned job;
+
+    if (ctx->ranges) {
+        run_stealing_jobs(ctx, slot);
+        return;
+    }
+
+    while ((job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs)
+        ctx->worker_func(ctx->priv, job, slot, nb_jobs, ctx->nb_active_threads);
+}
+
 static void *attribute_align_arg thread_worker(void *v)
 {
     WorkerContext *w = v;
@@ -187,6 +302,59 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return nb_threads;
 }
 
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, AVBufferRef *pool)
+{
+    AVSliceThread *ctx;
+
+    av_assert0(nb_threads >= 0);
+    if (!nb_threads) {
+        int nb_cpus = av_cpu_count();
+        if (nb_cpus > 1)
+            nb_threads = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
+        else
+            nb_threads = 1;
+    }
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->pool_ref = av_buffer_ref(pool);
+    if (!ctx->pool_ref) {
+        av_freep(pctx);
+        return AVERROR(ENOMEM);
+    }
+
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    ctx->task.run    = run_pool_jobs;
+    ctx->task.opaque = ctx;
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+
+    return nb_threads;
+}
+
+int avpriv_slicethread_enable_work_stealing(AVSliceThread *ctx)
+{
+    /* the ranges need 64 bit atomics, keep handing out jobs in order
+     * on the platforms where the compat atomics are narrower */
+    if (ctx->ranges || sizeof(atomic_uint_least64_t) < sizeof(uint64_t))
+        return 0;
+
+    ctx->ranges = av_calloc(ctx->nb_threads, sizeof(*ctx->ranges));
+    if (!ctx->ranges)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < ctx->nb_threads; i++)
+        atomic_init(&ctx->ranges[i].range, 0);
+    atomic_init(&ctx->nb_finished, 0);
+
+    return 0;
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     int nb_workers, i, is_last = 0;
@@ -194,6 +362,23 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     av_assert0(nb_jobs > 0);
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+
+    if (ctx->ranges) {
+        for (i = 0; i < ctx->nb_active_threads; i++)
+            atomic_store_explicit(&ctx->ranges[i].range,
+                                  JOB_RANGE((int64_t)nb_jobs *  i      / ctx->nb_active_threads,
+                                            (int64_t)nb_jobs * (i + 1) / ctx->nb_active_threads),
+                                  memory_order_relaxed);
+        atomic_store_explicit(&ctx->nb_finished, 0, memory_order_relaxed);
+    }
+
+    if (ctx->pool_ref) {
+        atomic_store_explicit(&ctx->current_job, 0, memory_order_relaxed);
+        ctx->task.nb_slots = ctx->nb_active_threads;
+        ff_thread_pool_run((FFThreadPool *)ctx->pool_ref->data, &ctx->task);
+        return;
+    }
+
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
     nb_workers             = ctx->nb_active_threads;
@@ -231,6 +416,13 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+    av_freep(&ctx->ranges);
+    if (ctx->pool_ref) {
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -268,6 +460,20 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(ENOSYS);
 }
 
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, AVBufferRef *pool)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
+int avpriv_slicethread_enable_work_stealing(AVSliceThread *ctx)
+{
+    av_assert0(0);
+    return AVERROR(ENOSYS);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
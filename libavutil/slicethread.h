@@ -19,6 +19,8 @@
 #ifndef AVUTIL_SLICETHREAD_H
 #define AVUTIL_SLICETHREAD_H
 
+#include "buffer.h"
+
 typedef struct AVSliceThread AVSliceThread;
 
 /**
@@ -35,6 +37,33 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on a shared thread pool
+ * instead of threads of its own.
+ * @param pctx slice threading context returned here
+ * @param priv private pointer to be passed to callback function
+ * @param worker_func callback function to be executed
+ * @param nb_threads maximum number of threads running jobs at once, which
+ *                   is also the range of threadnr, 0 for automatic
+ * @param pool reference to a pool from av_thread_pool_alloc(), the context
+ *             keeps its own reference
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, AVBufferRef *pool);
+
+/**
+ * Hand out the jobs of each execute through per thread ranges of
+ * consecutive jobs, instead of in order from a single counter. A thread
+ * done with its own range steals the back half of the largest range left.
+ * Jobs then start in any order, so this must only be enabled when no job
+ * waits for another one.
+ * @param ctx slice threading context
+ * @return 0 on success, negative AVERROR on failure
+ */
+int avpriv_slicethread_enable_work_stealing(AVSliceThread *ctx);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
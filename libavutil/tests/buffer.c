@@ -0,0 +1,191 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Tests AVBufferPool buffer recycling, optionally from several threads.
+ *
+ * Run with "-b [threads] [iterations]" to benchmark av_buffer_pool_get()
+ * and the matching release with a number of contending threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define POOL_SIZE     1024
+#define MAX_BUFS      64
+#define MAX_THREADS   64
+
+typedef struct ThreadArg {
+    AVBufferPool *pool;
+    int id;
+    int iterations;
+    int held;
+    int errors;
+} ThreadArg;
+
+static void test_reuse(int nb_bufs)
+{
+    AVBufferPool *pool = av_buffer_pool_init(POOL_SIZE, NULL);
+    AVBufferRef *bufs[MAX_BUFS] = { NULL };
+    uint8_t *data[MAX_BUFS];
+    int reused = 0, lifo = 1, ret = -1;
+
+    if (!pool)
+        goto end;
+
+    for (int i = 0; i < nb_bufs; i++) {
+        bufs[i] = av_buffer_pool_get(pool);
+        if (!bufs[i])
+            goto end;
+        data[i] = bufs[i]->data;
+    }
+    for (int i = 0; i < nb_bufs; i++)
+        av_buffer_unref(&bufs[i]);
+
+    for (int i = 0; i < nb_bufs; i++) {
+        bufs[i] = av_buffer_pool_get(pool);
+        if (!bufs[i])
+            goto end;
+        /* the buffer released last must come back first */
+        lifo &= bufs[i]->data == data[nb_bufs - 1 - i];
+        for (int j = 0; j < nb_bufs; j++)
+            reused += bufs[i]->data == data[j];
+        for (int j = 0; j < i; j++)
+            if (bufs[j]->data == bufs[i]->data)
+                goto end;
+    }
+    ret = 0;
+
+end:
+    /* uninit with buffers outstanding, the pool must outlive them */
+    av_buffer_pool_uninit(&pool);
+    for (int i = 0; i < nb_bufs; i++)
+        av_buffer_unref(&bufs[i]);
+
+    if (ret < 0)
+        printf("reuse %2d buffers: error\n", nb_bufs);
+    else
+        printf("reuse %2d buffers: %d reused, %s\n", nb_bufs, reused,
+               lifo ? "last released first" : "out of order");
+}
+
+static void *thread_main(void *opaque)
+{
+    ThreadArg *arg = opaque;
+    AVBufferRef *bufs[MAX_BUFS];
+
+    for (int n = 0; n < arg->iterations; n++) {
+        for (int i = 0; i < arg->held; i++) {
+            bufs[i] = av_buffer_pool_get(arg->pool);
+            if (!bufs[i]) {
+                arg->errors++;
+                return NULL;
+            }
+            memset(bufs[i]->data, arg->id, 16);
+        }
+        for (int i = 0; i < arg->held; i++) {
+            for (int j = 0; j < 16; j++)
+                arg->errors += bufs[i]->data[j] != (uint8_t)arg->id;
+            av_buffer_unref(&bufs[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static int run_threads(int nb_threads, int iterations, int held)
+{
+#if HAVE_THREADS
+    AVBufferPool *pool = av_buffer_pool_init(POOL_SIZE, NULL);
+    pthread_t threads[MAX_THREADS];
+    ThreadArg args[MAX_THREADS];
+    int errors = 0, ret;
+
+    if (!pool)
+        return -1;
+
+    for (int i = 0; i < nb_threads; i++) {
+        args[i] = (ThreadArg){ .pool = pool, .id = i + 1,
+                               .iterations = iterations, .held = held };
+        if ((ret = pthread_create(&threads[i], NULL, thread_main, &args[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            exit(1);
+        }
+    }
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_join(threads[i], NULL);
+        errors += args[i].errors;
+    }
+
+    av_buffer_pool_uninit(&pool);
+    return errors;
+#else
+    ThreadArg arg = { .pool = av_buffer_pool_init(POOL_SIZE, NULL), .id = 1,
+                      .iterations = iterations * nb_threads, .held = held };
+
+    if (!arg.pool)
+        return -1;
+    thread_main(&arg);
+    av_buffer_pool_uninit(&arg.pool);
+    return arg.errors;
+#endif
+}
+
+static int benchmark(int argc, char **argv)
+{
+    int nb_threads = argc > 2 ? atoi(argv[2]) : 4;
+    int iterations = argc > 3 ? atoi(argv[3]) : 1000000;
+    int64_t t;
+    double gets;
+
+    nb_threads = av_clip(nb_threads, 1, MAX_THREADS);
+    iterations = FFMAX(iterations, 1);
+
+    t = av_gettime_relative();
+    if (run_threads(nb_threads, iterations, 2))
+        return 1;
+    t = FFMAX(av_gettime_relative() - t, 1);
+
+    gets = 2.0 * iterations * nb_threads;
+    printf("%d threads: %.0f gets in %.3f s, %.0f gets/s\n",
+           nb_threads, gets, t / 1000000.0, gets * 1000000.0 / t);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const int counts[] = { 1, 4, 32, 64 };
+
+    if (argc > 1 && !strcmp(argv[1], "-b"))
+        return benchmark(argc, argv);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(counts); i++)
+        test_reuse(counts[i]);
+
+    for (int held = 1; held <= 8; held *= 2)
+        printf("4 threads holding %d buffers: %d errors\n",
+               held, run_threads(4, 10000, held));
+
+    return 0;
+}
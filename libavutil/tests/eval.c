@@ -24,6 +24,8 @@
 
 #include "libavutil/libm.h"
 #include "libavutil/eval.h"
+#include "libavutil/log.h"
+#include "libavutil/macros.h"
 
 static const double const_values[] = {
     M_PI,
@@ -140,6 +142,24 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const batch_exprs[] = {
+        "-PI",
+        "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
+        "if(gt(PI,0),PI*2,-PI)",
+        "ifnot(PI,1)",
+        "clip(PI,-3,4)",
+        "mod(PI,3)-mod(-PI,0)",
+        "squish(PI)+gauss(PI)",
+        "between(PI,-1,1)*lerp(1,E,PI)",
+        "bitand(PI,7)+bitor(PI,3)",
+        "floor(PI)+ceil(PI)+trunc(PI)+round(PI)+sgn(PI)+abs(PI)",
+        "hypot(PI,E)+atan2(PI,E)+pow(E,PI)/PI",
+        "isnan(sqrt(PI))+not(PI)+max(PI,1)+min(PI,1)+gcd(PI,12)",
+        "eq(PI,1)+gte(PI,1)+lt(PI,1)+lte(PI,1);-E*PI",
+        "st(0,PI);ld(0)*2",
+        "7000000B*random(0)+PI",
+        NULL
+    };
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -155,6 +175,36 @@ int main(int argc, char **argv)
             printf("av_expr_parse_and_eval failed\n");
     }
 
+    /* av_expr_eval_batch() must match av_expr_eval() element by element */
+    for (expr = batch_exprs; *expr; expr++) {
+        double pi[100], res[100];
+        const double *const_arrays[] = { pi, NULL, NULL };
+        double values[] = { 0, M_E, 0 };
+        AVExpr *e, *e2;
+
+        if (av_expr_parse(&e,  *expr, const_names, NULL, NULL, NULL, NULL, AV_LOG_QUIET, NULL) < 0)
+            continue;
+        if (av_expr_parse(&e2, *expr, const_names, NULL, NULL, NULL, NULL, AV_LOG_QUIET, NULL) < 0) {
+            av_expr_free(e);
+            continue;
+        }
+        for (i = 0; i < FF_ARRAY_ELEMS(pi); i++)
+            pi[i] = i * 0.37 - 10;
+        if (av_expr_eval_batch(e2, res, FF_ARRAY_ELEMS(res), values, const_arrays, NULL) < 0)
+            printf("av_expr_eval_batch failed for '%s'\n", *expr);
+        for (i = 0; i < FF_ARRAY_ELEMS(pi); i++) {
+            values[0] = pi[i];
+            d = av_expr_eval(e, values, NULL);
+            if (!(isnan(d) && isnan(res[i])) && d != res[i]) {
+                printf("av_expr_eval_batch mismatch for '%s' at %d: %f != %f\n",
+                       *expr, i, res[i], d);
+                break;
+            }
+        }
+        av_expr_free(e);
+        av_expr_free(e2);
+    }
+
     ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
                            const_names, const_values,
                            NULL, NULL, NULL, NULL, NULL, 0, NULL);
@@ -0,0 +1,236 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Tests that every job of an execute runs exactly once and that no two
+ * concurrent jobs share a threadnr, with and without work stealing and on
+ * private threads as well as on a shared pool.
+ *
+ * Run with "-b [threads] [jobs per thread]" to benchmark the scaling
+ * efficiency of workloads whose cost varies between rows.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/slicethread.h"
+#include "libavutil/threadpool.h"
+#include "libavutil/time.h"
+
+#define MAX_THREADS 64
+#define MAX_JOBS    1024
+#define NB_ROWS     1024
+
+enum Profile {
+    PROFILE_UNIFORM,
+    PROFILE_RAMP,   ///< cost growing linearly with the row
+    PROFILE_BAND,   ///< a band of rows 16 times as expensive as the rest
+    PROFILE_RANDOM,
+    NB_PROFILES,
+};
+
+static const char *const profile_names[NB_PROFILES] = {
+    "uniform", "ramp", "band", "random",
+};
+
+typedef struct TestContext {
+    atomic_int runs[MAX_JOBS];
+    atomic_int busy[MAX_THREADS];
+    atomic_int errors;
+    int nb_threads;
+
+    /* benchmark */
+    int row_cost[NB_ROWS];
+    volatile unsigned sink;
+} TestContext;
+
+static void check_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *t = priv;
+
+    if (jobnr < 0 || jobnr >= nb_jobs || threadnr < 0 || threadnr >= nb_threads ||
+        nb_threads > t->nb_threads) {
+        atomic_fetch_add(&t->errors, 1);
+        return;
+    }
+    if (atomic_exchange(&t->busy[threadnr], 1))
+        atomic_fetch_add(&t->errors, 1);
+    atomic_fetch_add(&t->runs[jobnr], 1);
+    /* give other threads a chance to start and steal */
+    for (volatile int i = 0; i < 1000 * (jobnr % 7); i++);
+    atomic_store(&t->busy[threadnr], 0);
+}
+
+static int create(AVSliceThread **thread, TestContext *t,
+                  void (*worker)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                  int nb_threads, int stealing, AVBufferRef *pool)
+{
+    int ret;
+
+    if (pool)
+        ret = avpriv_slicethread_create_shared(thread, t, worker, nb_threads, pool);
+    else
+        ret = avpriv_slicethread_create(thread, t, worker, NULL, nb_threads);
+    if (ret < 0)
+        return ret;
+    if (stealing && (ret = avpriv_slicethread_enable_work_stealing(*thread)) < 0) {
+        avpriv_slicethread_free(thread);
+        return ret;
+    }
+    return 0;
+}
+
+static int test_jobs(int nb_threads, int stealing, AVBufferRef *pool)
+{
+    static const int job_counts[] = { 1, 2, 3, 7, 64, 1000 };
+    TestContext *t = av_mallocz(sizeof(*t));
+    AVSliceThread *thread;
+    int errors = 0;
+
+    if (!t || create(&thread, t, check_worker, nb_threads, stealing, pool) < 0) {
+        av_free(t);
+        return -1;
+    }
+    t->nb_threads = nb_threads;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(job_counts); i++) {
+        for (int iter = 0; iter < 20; iter++) {
+            int nb_jobs = job_counts[i];
+
+            for (int j = 0; j < nb_jobs; j++)
+                atomic_store(&t->runs[j], 0);
+            avpriv_slicethread_execute(thread, nb_jobs, 0);
+            for (int j = 0; j < nb_jobs; j++)
+                errors += atomic_load(&t->runs[j]) != 1;
+        }
+    }
+    errors += atomic_load(&t->errors);
+
+    avpriv_slicethread_free(&thread);
+    av_free(t);
+    return errors;
+}
+
+static void bench_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *t = priv;
+    const int row_start = (NB_ROWS *  jobnr     ) / nb_jobs;
+    const int row_end   = (NB_ROWS * (jobnr + 1)) / nb_jobs;
+    unsigned acc = jobnr;
+
+    for (int y = row_start; y < row_end; y++)
+        for (int i = 0; i < t->row_cost[y]; i++)
+            acc = acc * 1664525 + 1013904223;
+    t->sink = acc;
+}
+
+static void init_profile(TestContext *t, enum Profile profile)
+{
+    unsigned seed = 1;
+
+    for (int y = 0; y < NB_ROWS; y++) {
+        switch (profile) {
+        case PROFILE_UNIFORM: t->row_cost[y] = 4000;                               break;
+        case PROFILE_RAMP:    t->row_cost[y] = 8000 * y / NB_ROWS;                 break;
+        case PROFILE_BAND:    t->row_cost[y] = y >= NB_ROWS / 4 && y < NB_ROWS / 2 ?
+                                               16000 : 1000;                       break;
+        case PROFILE_RANDOM:  seed = seed * 1664525 + 1013904223;
+                              t->row_cost[y] = 1000 + (seed >> 8) % 15000;         break;
+        }
+    }
+}
+
+static double run_bench(TestContext *t, int nb_threads, int nb_jobs, int stealing)
+{
+    AVSliceThread *thread;
+    int64_t time;
+
+    if (create(&thread, t, bench_worker, nb_threads, stealing, NULL) < 0)
+        exit(1);
+
+    /* warm up the threads */
+    avpriv_slicethread_execute(thread, nb_jobs, 0);
+
+    time = av_gettime_relative();
+    for (int i = 0; i < 10; i++)
+        avpriv_slicethread_execute(thread, nb_jobs, 0);
+    time = FFMAX(av_gettime_relative() - time, 1);
+
+    avpriv_slicethread_free(&thread);
+    return time;
+}
+
+static int benchmark(int argc, char **argv)
+{
+    int nb_threads      = argc > 2 ? atoi(argv[2]) : 4;
+    int jobs_per_thread = argc > 3 ? atoi(argv[3]) : 4;
+    TestContext *t = av_mallocz(sizeof(*t));
+
+    if (!t)
+        return 1;
+    nb_threads      = av_clip(nb_threads, 2, MAX_THREADS);
+    jobs_per_thread = av_clip(jobs_per_thread, 1, NB_ROWS / nb_threads);
+
+    printf("%d threads, efficiency = serial time / (threads * time)\n", nb_threads);
+    printf("%-8s %12s %12s %12s\n", "profile", "ordered", "ordered", "stealing");
+    printf("%-8s %7d jobs %7d jobs %7d jobs\n", "", nb_threads,
+           nb_threads * jobs_per_thread, nb_threads * jobs_per_thread);
+    for (int p = 0; p < NB_PROFILES; p++) {
+        double serial;
+
+        init_profile(t, p);
+        serial = run_bench(t, 1, 1, 0);
+        printf("%-8s %11.1f%% %11.1f%% %11.1f%%\n", profile_names[p],
+               100 * serial / (nb_threads * run_bench(t, nb_threads, nb_threads, 0)),
+               100 * serial / (nb_threads * run_bench(t, nb_threads, nb_threads * jobs_per_thread, 0)),
+               100 * serial / (nb_threads * run_bench(t, nb_threads, nb_threads * jobs_per_thread, 1)));
+    }
+
+    av_free(t);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const int thread_counts[] = { 1, 2, 5, 16 };
+    AVBufferRef *pool;
+
+    if (argc > 1 && !strcmp(argv[1], "-b"))
+        return benchmark(argc, argv);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(thread_counts); i++)
+        for (int stealing = 0; stealing <= 1; stealing++)
+            printf("%2d threads, stealing %d: %d errors\n", thread_counts[i],
+                   stealing, test_jobs(thread_counts[i], stealing, NULL));
+
+    pool = av_thread_pool_alloc(3);
+    if (!pool)
+        return 1;
+    for (int i = 0; i < FF_ARRAY_ELEMS(thread_counts); i++)
+        for (int stealing = 0; stealing <= 1; stealing++)
+            printf("%2d threads on a pool of 3, stealing %d: %d errors\n",
+                   thread_counts[i], stealing, test_jobs(thread_counts[i], stealing, pool));
+    av_buffer_unref(&pool);
+
+    return 0;
+}
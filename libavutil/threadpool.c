@@ -0,0 +1,276 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+
+#include "config.h"
+
+#include "buffer.h"
+#include "cpu.h"
+#include "internal.h"
+#include "mem.h"
+#include "thread.h"
+#include "threadpool.h"
+#include "threadpool_internal.h"
+
+#if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
+
+/* Tasks are queued on the deques of the workers in turn. A worker takes the
+ * slots of the newest task on its own deque first, and steals the oldest task
+ * of another deque when its own is empty. Each task stays on one deque, whose
+ * mutex also guards the slot and running counts of the task. */
+typedef struct PoolWorker {
+    FFThreadPool     *pool;
+    pthread_t        thread;
+
+    pthread_mutex_t  mutex;
+    pthread_cond_t   done_cond; ///< a task of the deque lost its last running slot
+    FFThreadPoolTask *newest;
+    FFThreadPoolTask *oldest;
+} PoolWorker;
+
+struct FFThreadPool {
+    PoolWorker      *workers;
+    int             nb_workers;
+    int             nb_started;
+    atomic_uint     next_worker; ///< worker the next task is queued on
+    atomic_int      nb_queued;   ///< tasks on the deques with slots left
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;       ///< a task was queued or the pool is freed
+    int             finished;
+};
+
+/* must be called with the mutex of the worker held */
+static void unlink_task(FFThreadPool *pool, PoolWorker *w, FFThreadPoolTask *task)
+{
+    if (task->prev)
+        task->prev->next = task->next;
+    else
+        w->newest = task->next;
+    if (task->next)
+        task->next->prev = task->prev;
+    else
+        w->oldest = task->prev;
+    atomic_fetch_sub_explicit(&pool->nb_queued, 1, memory_order_relaxed);
+}
+
+static FFThreadPoolTask *take_slot(PoolWorker *w, int steal, int *slot)
+{
+    FFThreadPoolTask *task;
+
+    pthread_mutex_lock(&w->mutex);
+    task = steal ? w->oldest : w->newest;
+    if (task) {
+        *slot = task->next_slot++;
+        if (task->next_slot == task->nb_slots)
+            unlink_task(w->pool, w, task);
+        task->nb_running++;
+    }
+    pthread_mutex_unlock(&w->mutex);
+
+    return task;
+}
+
+static void *attribute_align_arg pool_worker(void *arg)
+{
+    PoolWorker *self = arg;
+    FFThreadPool *pool = self->pool;
+    const int idx = self - pool->workers;
+
+    for (;;) {
+        FFThreadPoolTask *task = NULL;
+        int slot;
+
+        for (int i = 0; !task && i < pool->nb_workers; i++)
+            task = take_slot(&pool->workers[(idx + i) % pool->nb_workers], i > 0, &slot);
+
+        if (task) {
+            PoolWorker *w = &pool->workers[task->worker];
+
+            task->run(task->opaque, slot);
+
+            pthread_mutex_lock(&w->mutex);
+            if (!--task->nb_running)
+                pthread_cond_broadcast(&w->done_cond);
+            pthread_mutex_unlock(&w->mutex);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+        if (!pool->finished &&
+            !atomic_load_explicit(&pool->nb_queued, memory_order_relaxed))
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        if (pool->finished) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    return NULL;
+}
+
+void ff_thread_pool_run(FFThreadPool *pool, FFThreadPoolTask *task)
+{
+    int nb_wake = FFMIN(task->nb_slots - 1, pool->nb_workers);
+    PoolWorker *w;
+
+    task->next_slot  = 1;
+    task->nb_running = 1;
+    task->worker     = atomic_fetch_add_explicit(&pool->next_worker, 1,
+                                                 memory_order_relaxed) % pool->nb_workers;
+    w = &pool->workers[task->worker];
+
+    if (nb_wake > 0) {
+        pthread_mutex_lock(&w->mutex);
+        task->prev = NULL;
+        task->next = w->newest;
+        if (w->newest)
+            w->newest->prev = task;
+        else
+            w->oldest = task;
+        w->newest = task;
+        atomic_fetch_add_explicit(&pool->nb_queued, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&w->mutex);
+
+        /* idle workers check the count with this mutex held before sleeping */
+        pthread_mutex_lock(&pool->mutex);
+        if (nb_wake == pool->nb_workers)
+            pthread_cond_broadcast(&pool->cond);
+        else
+            while (nb_wake--)
+                pthread_cond_signal(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    task->run(task->opaque, 0);
+
+    pthread_mutex_lock(&w->mutex);
+    if (task->next_slot < task->nb_slots) {
+        unlink_task(pool, w, task);
+        task->next_slot = task->nb_slots;
+    }
+    task->nb_running--;
+    while (task->nb_running)
+        pthread_cond_wait(&w->done_cond, &w->mutex);
+    pthread_mutex_unlock(&w->mutex);
+}
+
+static void pool_uninit(FFThreadPool *pool, int nb_inited)
+{
+    for (int i = 0; i < nb_inited; i++) {
+        pthread_cond_destroy(&pool->workers[i].done_cond);
+        pthread_mutex_destroy(&pool->workers[i].mutex);
+    }
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->workers);
+    av_free(pool);
+}
+
+static void pool_free(void *opaque, uint8_t *data)
+{
+    FFThreadPool *pool = (FFThreadPool *)data;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->finished = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->nb_started; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    pool_uninit(pool, pool->nb_workers);
+}
+
+AVBufferRef *av_thread_pool_alloc(int nb_threads)
+{
+    FFThreadPool *pool;
+    AVBufferRef *ref;
+    int i;
+
+    if (nb_threads < 0)
+        return NULL;
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+    pool->workers = av_calloc(nb_threads, sizeof(*pool->workers));
+    if (!pool->workers) {
+        av_free(pool);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&pool->mutex, NULL)) {
+        av_freep(&pool->workers);
+        av_free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->cond, NULL)) {
+        pthread_mutex_destroy(&pool->mutex);
+        av_freep(&pool->workers);
+        av_free(pool);
+        return NULL;
+    }
+    for (i = 0; i < nb_threads; i++) {
+        PoolWorker *w = &pool->workers[i];
+        w->pool = pool;
+        if (pthread_mutex_init(&w->mutex, NULL))
+            goto fail;
+        if (pthread_cond_init(&w->done_cond, NULL)) {
+            pthread_mutex_destroy(&w->mutex);
+            goto fail;
+        }
+    }
+    pool->nb_workers = nb_threads;
+
+    ref = av_buffer_create((uint8_t *)pool, sizeof(*pool), pool_free, NULL, 0);
+    if (!ref)
+        goto fail;
+
+    /* threads started so far are joined by pool_free() */
+    for (; pool->nb_started < nb_threads; pool->nb_started++) {
+        PoolWorker *w = &pool->workers[pool->nb_started];
+        if (pthread_create(&w->thread, NULL, pool_worker, w)) {
+            av_buffer_unref(&ref);
+            return NULL;
+        }
+    }
+
+    return ref;
+fail:
+    pool_uninit(pool, i);
+    return NULL;
+}
+
+#else /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
+
+void ff_thread_pool_run(FFThreadPool *pool, FFThreadPoolTask *task)
+{
+    task->run(task->opaque, 0);
+}
+
+AVBufferRef *av_thread_pool_alloc(int nb_threads)
+{
+    return NULL;
+}
+
+#endif /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS */
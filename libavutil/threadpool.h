@@ -0,0 +1,48 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Worker threads shared between codec, filter graph and scaler contexts.
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+#include "buffer.h"
+
+/**
+ * Allocate a pool of worker threads for slice threading.
+ *
+ * Codec, filter graph and scaler contexts attached to the pool do not
+ * create threads of their own. They still split their work into as many
+ * jobs as their thread count allows, but the jobs are run by the calling
+ * thread together with whichever pool threads are idle. The number of
+ * threads doing slice work in the process is thus bounded by nb_threads
+ * plus the number of threads calling into the attached contexts.
+ *
+ * Each attached context holds a reference to the pool; the threads are
+ * stopped when the last reference is released.
+ *
+ * @param nb_threads number of worker threads, 0 for one per CPU
+ * @return a reference to the pool, NULL on failure or when threads are not
+ *         supported
+ */
+AVBufferRef *av_thread_pool_alloc(int nb_threads);
+
+#endif /* AVUTIL_THREADPOOL_H */
@@ -0,0 +1,48 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_INTERNAL_H
+#define AVUTIL_THREADPOOL_INTERNAL_H
+
+typedef struct FFThreadPool FFThreadPool;
+
+typedef struct FFThreadPoolTask {
+    /**
+     * Called once for every slot, each time from a different thread. Slot 0
+     * runs on the thread calling ff_thread_pool_run(), other slots may never
+     * be started when the pool is busy, so the work must not be bound to a
+     * slot.
+     */
+    void (*run)(void *opaque, int slot);
+    void *opaque;
+    int   nb_slots;
+
+    // private to threadpool.c
+    int   next_slot;
+    int   nb_running;
+    int   worker;       ///< index of the worker whose deque holds the task
+    struct FFThreadPoolTask *prev, *next;
+} FFThreadPoolTask;
+
+/**
+ * Run task on the calling thread and on up to task->nb_slots - 1 idle
+ * threads of the pool. Returns once every started slot has returned.
+ */
+void ff_thread_pool_run(FFThreadPool *pool, FFThreadPoolTask *task);
+
+#endif /* AVUTIL_THREADPOOL_INTERNAL_H */
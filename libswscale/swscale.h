@@ -31,6 +31,7 @@
 #include <stdint.h>
 
 #include "libavutil/avutil.h"
+#include "libavutil/buffer.h"
 #include "libavutil/frame.h"
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
@@ -254,6 +255,20 @@ int sws_isSupportedOutput(enum AVPixelFormat pix_fmt);
  */
 int sws_isSupportedEndiannessConversion(enum AVPixelFormat pix_fmt);
 
+/**
+ * Run the slice threading of the context on a pool of threads which may be
+ * shared with other contexts, instead of creating threads of its own. The
+ * "threads" option still limits the number of threads working on this
+ * context at once.
+ *
+ * Must be called before sws_init_context().
+ *
+ * @param pool reference to a pool from av_thread_pool_alloc(), or NULL; the
+ *             context takes a new reference
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int sws_set_thread_pool(SwsContext *sws_context, AVBufferRef *pool);
+
 /**
  * Initialize the swscaler context sws_context.
  *
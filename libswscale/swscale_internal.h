@@ -66,6 +66,7 @@
 #define RETCODE_USE_CASCADE -12345
 
 typedef struct SwsInternal SwsInternal;
+typedef struct SwsFilterCacheEntry SwsFilterCacheEntry;
 
 static inline SwsInternal *sws_internal(const SwsContext *sws)
 {
@@ -702,6 +703,18 @@ struct SwsInternal {
     atomic_int   data_unaligned_warned;
 
     Half2FloatTables *h2f_tables;
+
+    /**
+     * Shared cache entries backing hLumFilter, hChrFilter, vLumFilter and
+     * vChrFilter, NULL where the context owns the arrays itself.
+     */
+    SwsFilterCacheEntry *filter_cache[4];
+
+    /**
+     * Pool shared with other contexts that the slice threads run on,
+     * see sws_set_thread_pool().
+     */
+    AVBufferRef *thread_pool;
 };
 //FIXME check init (where 0)
 
@@ -993,6 +1006,21 @@ void ff_get_unscaled_swscale(SwsInternal *c);
 void ff_get_unscaled_swscale_ppc(SwsInternal *c);
 void ff_get_unscaled_swscale_arm(SwsInternal *c);
 void ff_get_unscaled_swscale_aarch64(SwsInternal *c);
+void ff_get_unscaled_swscale_x86(SwsInternal *c);
+
+/**
+ * C unscaled converters that architecture specific code replaces for some
+ * of the formats they are selected for.
+ */
+int ff_planar_copy_wrapper(SwsInternal *c, const uint8_t *const src[],
+                           const int srcStride[], int srcSliceY, int srcSliceH,
+                           uint8_t *const dst[], const int dstStride[]);
+int ff_planar_to_p01x_wrapper(SwsInternal *c, const uint8_t *const src[],
+                              const int srcStride[], int srcSliceY, int srcSliceH,
+                              uint8_t *const dst[], const int dstStride[]);
+int ff_p01x_to_planar_wrapper(SwsInternal *c, const uint8_t *const src[],
+                              const int srcStride[], int srcSliceY, int srcSliceH,
+                              uint8_t *const dst[], const int dstStride[]);
 
 void ff_sws_init_scale(SwsInternal *c);
 
@@ -263,10 +263,10 @@ static int nv24ToYuv420Wrapper(SwsInternal *c, const uint8_t *const src[],
     return srcSliceH;
 }
 
-static int planarToP01xWrapper(SwsInternal *c, const uint8_t *const src8[],
-                               const int srcStride[], int srcSliceY,
-                               int srcSliceH, uint8_t *const dstParam8[],
-                               const int dstStride[])
+int ff_planar_to_p01x_wrapper(SwsInternal *c, const uint8_t *const src8[],
+                              const int srcStride[], int srcSliceY,
+                              int srcSliceH, uint8_t *const dstParam8[],
+                              const int dstStride[])
 {
     const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
     const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
@@ -314,6 +314,47 @@ static int planarToP01xWrapper(SwsInternal *c, const uint8_t *const src8[],
     return srcSliceH;
 }
 
+int ff_p01x_to_planar_wrapper(SwsInternal *c, const uint8_t *const src8[],
+                              const int srcStride[], int srcSliceY,
+                              int srcSliceH, uint8_t *const dstParam8[],
+                              const int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const uint16_t *srcY  = (const uint16_t *)src8[0];
+    const uint16_t *srcUV = (const uint16_t *)src8[1];
+    uint16_t *dstY = (uint16_t *)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstU = (uint16_t *)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    uint16_t *dstV = (uint16_t *)(dstParam8[2] + dstStride[2] * srcSliceY / 2);
+    int x, y;
+
+    /* The values only move down to the LSBs, the depth is the same. */
+    const int shiftY  = src_format->comp[0].shift - dst_format->comp[0].shift;
+    const int shiftUV = src_format->comp[1].shift - dst_format->comp[1].shift;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    for (y = 0; y < srcSliceH; y++) {
+        for (x = 0; x < c->srcW; x++)
+            dstY[x] = srcY[x] >> shiftY;
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & 1)) {
+            for (x = 0; x < c->chrSrcW; x++) {
+                dstU[x] = srcUV[2 * x    ] >> shiftUV;
+                dstV[x] = srcUV[2 * x + 1] >> shiftUV;
+            }
+            srcUV += srcStride[1] / 2;
+            dstU  += dstStride[1] / 2;
+            dstV  += dstStride[2] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
 #if AV_HAVE_BIGENDIAN
 #define output_pixel(p, v) do { \
         uint16_t *pp = (p); \
@@ -2131,9 +2172,9 @@ static int packedCopyWrapper(SwsInternal *c, const uint8_t *const src[],
         }\
     }
 
-static int planarCopyWrapper(SwsInternal *c, const uint8_t *const src[],
-                             const int srcStride[], int srcSliceY, int srcSliceH,
-                             uint8_t *const dst[], const int dstStride[])
+int ff_planar_copy_wrapper(SwsInternal *c, const uint8_t *const src[],
+                           const int srcStride[], int srcSliceY, int srcSliceH,
+                           uint8_t *const dst[], const int dstStride[])
 {
     const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
     const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -2350,7 +2391,13 @@ void ff_get_unscaled_swscale(SwsInternal *c)
          srcFormat == AV_PIX_FMT_YUV420P14 ||
          srcFormat == AV_PIX_FMT_YUV420P16 || srcFormat == AV_PIX_FMT_YUVA420P16) &&
         (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016)) {
-        c->convert_unscaled = planarToP01xWrapper;
+        c->convert_unscaled = ff_planar_to_p01x_wrapper;
+    }
+    /* p01x_to_yuv420p1x */
+    if ((srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) ||
+        (srcFormat == AV_PIX_FMT_P012 && dstFormat == AV_PIX_FMT_YUV420P12) ||
+        (srcFormat == AV_PIX_FMT_P016 && dstFormat == AV_PIX_FMT_YUV420P16)) {
+        c->convert_unscaled = ff_p01x_to_planar_wrapper;
     }
     /* yuv420p_to_p01xle */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
@@ -2587,7 +2634,7 @@ void ff_get_unscaled_swscale(SwsInternal *c)
         if (isPacked(c->srcFormat))
             c->convert_unscaled = packedCopyWrapper;
         else /* Planar YUV or gray */
-            c->convert_unscaled = planarCopyWrapper;
+            c->convert_unscaled = ff_planar_copy_wrapper;
     }
 
 #if ARCH_PPC
@@ -2596,6 +2643,8 @@ void ff_get_unscaled_swscale(SwsInternal *c)
     ff_get_unscaled_swscale_arm(c);
 #elif ARCH_AARCH64
     ff_get_unscaled_swscale_aarch64(c);
+#elif ARCH_X86
+    ff_get_unscaled_swscale_x86(c);
 #endif
 }
 
@@ -0,0 +1,137 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Creates pairs of scalers with the same parameters and checks that they
+ * share their filter coefficients, that a scaler with other parameters does
+ * not, and that both scalers of a pair give the same output, also after the
+ * other one has been freed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+static const struct {
+    enum AVPixelFormat src_fmt, dst_fmt;
+    int src_w, src_h, dst_w, dst_h;
+    int flags;
+} tests[] = {
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 352, 288, 176, 144, SWS_BICUBIC  },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, 352, 288, 640, 360, SWS_LANCZOS  },
+    { AV_PIX_FMT_RGB24,   AV_PIX_FMT_YUV420P, 320, 240, 200, 100, SWS_BILINEAR },
+    { AV_PIX_FMT_YUV444P, AV_PIX_FMT_RGBA,    128,  96, 256, 192, SWS_SPLINE   },
+};
+
+static int count_shared(const SwsContext *a, const SwsContext *b)
+{
+    const SwsInternal *c1 = sws_internal(a), *c2 = sws_internal(b);
+
+    return (c1->hLumFilter == c2->hLumFilter) +
+           (c1->hChrFilter == c2->hChrFilter) +
+           (c1->vLumFilter == c2->vLumFilter) +
+           (c1->vChrFilter == c2->vChrFilter);
+}
+
+static int scale(SwsContext *sws, uint8_t *const src[4], const int src_stride[4],
+                 int src_h, uint8_t *dst[4], const int dst_stride[4], int dst_h)
+{
+    return sws_scale(sws, (const uint8_t * const *) src, src_stride, 0, src_h,
+                     dst, dst_stride) == dst_h ? 0 : -1;
+}
+
+int main(void)
+{
+    const int flags = SWS_ACCURATE_RND | SWS_BITEXACT;
+    AVLFG lfg;
+    int errors = 0;
+
+    av_lfg_init(&lfg, 1);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        uint8_t *src[4], *dst1[4], *dst2[4];
+        int src_stride[4], dst_stride[4], src_size, dst_size;
+        SwsContext *a, *b, *other;
+        int shared, shared_other, diff, diff_after_free;
+
+        src_size = av_image_alloc(src, src_stride, tests[i].src_w, tests[i].src_h,
+                                  tests[i].src_fmt, 16);
+        dst_size = av_image_alloc(dst1, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                                  tests[i].dst_fmt, 16);
+        if (src_size < 0 || dst_size < 0 ||
+            av_image_alloc(dst2, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                           tests[i].dst_fmt, 16) < 0)
+            return 1;
+        for (int j = 0; j < src_size; j++)
+            src[0][j] = av_lfg_get(&lfg);
+        /* the padding of the lines is not written */
+        memset(dst1[0], 0, dst_size);
+        memset(dst2[0], 0, dst_size);
+
+        a = sws_getContext(tests[i].src_w, tests[i].src_h, tests[i].src_fmt,
+                           tests[i].dst_w, tests[i].dst_h, tests[i].dst_fmt,
+                           tests[i].flags | flags, NULL, NULL, NULL);
+        b = sws_getContext(tests[i].src_w, tests[i].src_h, tests[i].src_fmt,
+                           tests[i].dst_w, tests[i].dst_h, tests[i].dst_fmt,
+                           tests[i].flags | flags, NULL, NULL, NULL);
+        other = sws_getContext(tests[i].src_w, tests[i].src_h, tests[i].src_fmt,
+                               tests[i].dst_w + 2, tests[i].dst_h + 2, tests[i].dst_fmt,
+                               tests[i].flags | flags, NULL, NULL, NULL);
+        if (!a || !b || !other)
+            return 1;
+
+        shared       = count_shared(a, b);
+        shared_other = count_shared(a, other);
+        sws_freeContext(other);
+
+        if (scale(a, src, src_stride, tests[i].src_h, dst1, dst_stride, tests[i].dst_h) < 0 ||
+            scale(b, src, src_stride, tests[i].src_h, dst2, dst_stride, tests[i].dst_h) < 0)
+            return 1;
+        diff = memcmp(dst1[0], dst2[0], dst_size);
+
+        /* the coefficients must outlive the context that created them */
+        sws_freeContext(a);
+        memset(dst2[0], 0, dst_size);
+        if (scale(b, src, src_stride, tests[i].src_h, dst2, dst_stride, tests[i].dst_h) < 0)
+            return 1;
+        diff_after_free = memcmp(dst1[0], dst2[0], dst_size);
+        sws_freeContext(b);
+
+        printf("%s %dx%d -> %s %dx%d: %d filters shared, %d with other size, "
+               "output %s, %s after free\n",
+               av_get_pix_fmt_name(tests[i].src_fmt), tests[i].src_w, tests[i].src_h,
+               av_get_pix_fmt_name(tests[i].dst_fmt), tests[i].dst_w, tests[i].dst_h,
+               shared, shared_other,
+               diff ? "differs" : "identical",
+               diff_after_free ? "differs" : "identical");
+        errors += shared != 4 || shared_other || diff || diff_after_free;
+
+        av_freep(&src[0]);
+        av_freep(&dst1[0]);
+        av_freep(&dst2[0]);
+    }
+
+    return !!errors;
+}
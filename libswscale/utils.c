@@ -840,6 +840,169 @@ done:
     return ret;
 }
 
+/**
+ * Scaler coefficients only depend on the parameters passed to initFilter()
+ * (and on the source/destination bit depth when they get shuffled for the
+ * AVX2 horizontal scaler), so identical contexts share a single read-only
+ * copy of them through this process-wide cache.
+ */
+typedef struct SwsFilterKey {
+    int xInc, srcW, dstW;
+    int filterAlign, one;
+    int flags, cpu_flags;
+    double param[2];
+    int srcPos, dstPos;
+    int srcBpc, dstBpc; ///< only set for horizontal filters
+} SwsFilterKey;
+
+struct SwsFilterCacheEntry {
+    struct SwsFilterCacheEntry *next;
+    unsigned refcount;
+    SwsFilterKey key;
+
+    int16_t *filter;
+    int32_t *filter_pos;
+    int filter_size;
+};
+
+static AVMutex filter_cache_lock = AV_MUTEX_INITIALIZER;
+static SwsFilterCacheEntry *cached_filters;
+
+static void filter_cache_entry_free(SwsFilterCacheEntry **pentry)
+{
+    SwsFilterCacheEntry *entry = *pentry;
+    av_freep(&entry->filter);
+    av_freep(&entry->filter_pos);
+    av_freep(pentry);
+}
+
+/**
+ * Like initFilter(), but look up the result in the filter cache first.
+ * Filters derived from user supplied SwsVectors are never cached. On
+ * success, *pentry is either NULL (the caller owns the arrays) or a cache
+ * reference that must be released with filter_cache_unref().
+ */
+static av_cold int init_filter_cached(SwsInternal *c, SwsFilterCacheEntry **pentry,
+                                      int16_t **outFilter, int32_t **filterPos,
+                                      int *outFilterSize, int xInc, int srcW,
+                                      int dstW, int filterAlign, int one,
+                                      int flags, int cpu_flags,
+                                      SwsVector *srcFilter, SwsVector *dstFilter,
+                                      double param[2], int srcPos, int dstPos,
+                                      int shuffle)
+{
+    SwsFilterCacheEntry *entry;
+    SwsFilterKey key;
+    int ret;
+
+    *pentry = NULL;
+
+    if (srcFilter || dstFilter) {
+        ret = initFilter(outFilter, filterPos, outFilterSize, xInc, srcW, dstW,
+                         filterAlign, one, flags, cpu_flags, srcFilter, dstFilter,
+                         param, srcPos, dstPos);
+        if (ret >= 0 && shuffle &&
+            ff_shuffle_filter_coefficients(c, *filterPos, *outFilterSize,
+                                           *outFilter, dstW) < 0)
+            ret = AVERROR(ENOMEM);
+        return ret;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    if (shuffle) {
+        key.srcBpc  = c->srcBpc;
+        key.dstBpc  = c->dstBpc;
+    }
+
+    ff_mutex_lock(&filter_cache_lock);
+    for (entry = cached_filters; entry; entry = entry->next) {
+        if (!memcmp(&entry->key, &key, sizeof(key))) {
+            entry->refcount++;
+            break;
+        }
+    }
+    ff_mutex_unlock(&filter_cache_lock);
+
+    if (!entry) {
+        SwsFilterCacheEntry *cur;
+
+        entry = av_mallocz(sizeof(*entry));
+        if (!entry)
+            return AVERROR(ENOMEM);
+        entry->key      = key;
+        entry->refcount = 1;
+
+        ret = initFilter(&entry->filter, &entry->filter_pos, &entry->filter_size,
+                         xInc, srcW, dstW, filterAlign, one, flags, cpu_flags,
+                         NULL, NULL, param, srcPos, dstPos);
+        if (ret >= 0 && shuffle &&
+            ff_shuffle_filter_coefficients(c, entry->filter_pos, entry->filter_size,
+                                           entry->filter, dstW) < 0)
+            ret = AVERROR(ENOMEM);
+        if (ret < 0) {
+            filter_cache_entry_free(&entry);
+            return ret;
+        }
+
+        /* Another thread may have inserted the same filter meanwhile. */
+        ff_mutex_lock(&filter_cache_lock);
+        for (cur = cached_filters; cur; cur = cur->next) {
+            if (!memcmp(&cur->key, &key, sizeof(key))) {
+                cur->refcount++;
+                break;
+            }
+        }
+        if (cur) {
+            filter_cache_entry_free(&entry);
+            entry = cur;
+        } else {
+            entry->next    = cached_filters;
+            cached_filters = entry;
+        }
+        ff_mutex_unlock(&filter_cache_lock);
+    }
+
+    *pentry        = entry;
+    *outFilter     = entry->filter;
+    *filterPos     = entry->filter_pos;
+    *outFilterSize = entry->filter_size;
+    return 0;
+}
+
+static void filter_cache_unref(SwsFilterCacheEntry **pentry)
+{
+    SwsFilterCacheEntry *entry = *pentry;
+    SwsFilterCacheEntry **p;
+
+    if (!entry)
+        return;
+    *pentry = NULL;
+
+    ff_mutex_lock(&filter_cache_lock);
+    if (--entry->refcount) {
+        entry = NULL;
+    } else {
+        for (p = &cached_filters; *p != entry; p = &(*p)->next)
+            ;
+        *p = entry->next;
+    }
+    ff_mutex_unlock(&filter_cache_lock);
+
+    if (entry)
+        filter_cache_entry_free(&entry);
+}
+
 static void fill_rgb2yuv_table(SwsInternal *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -1865,28 +2028,26 @@ static av_cold int sws_init_single_context(SwsContext *sws, SwsFilter *srcFilter
                                     have_lsx(cpu_flags)    ? 8 :
                                     have_lasx(cpu_flags)   ? 8 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = init_filter_cached(c, &c->filter_cache[0],
+                           &c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                            cpu_flags, srcFilter->lumH, dstFilter->lumH,
                            c->param,
                            get_local_pos(c, 0, 0, 0),
-                           get_local_pos(c, 0, 0, 0))) < 0)
+                           get_local_pos(c, 0, 0, 0), 1)) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hLumFilterPos, c->hLumFilterSize, c->hLumFilter, dstW) < 0)
-                goto nomem;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = init_filter_cached(c, &c->filter_cache[1],
+                           &c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                            cpu_flags, srcFilter->chrH, dstFilter->chrH,
                            c->param,
                            get_local_pos(c, c->chrSrcHSubSample, c->src_h_chr_pos, 0),
-                           get_local_pos(c, c->chrDstHSubSample, c->dst_h_chr_pos, 0))) < 0)
+                           get_local_pos(c, c->chrDstHSubSample, c->dst_h_chr_pos, 0), 1)) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hChrFilterPos, c->hChrFilterSize, c->hChrFilter, c->chrDstW) < 0)
-                goto nomem;
         }
     } // initialize horizontal stuff
 
@@ -1896,22 +2057,24 @@ static av_cold int sws_init_single_context(SwsContext *sws, SwsFilter *srcFilter
                                 PPC_ALTIVEC(cpu_flags) ? 8 :
                                 have_neon(cpu_flags)   ? 2 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = init_filter_cached(c, &c->filter_cache[2],
+                       &c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
                        c->param,
                        get_local_pos(c, 0, 0, 1),
-                       get_local_pos(c, 0, 0, 1))) < 0)
+                       get_local_pos(c, 0, 0, 1), 0)) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = init_filter_cached(c, &c->filter_cache[3],
+                       &c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                        cpu_flags, srcFilter->chrV, dstFilter->chrV,
                        c->param,
                        get_local_pos(c, c->chrSrcVSubSample, c->src_v_chr_pos, 1),
-                       get_local_pos(c, c->chrDstVSubSample, c->dst_v_chr_pos, 1))) < 0)
+                       get_local_pos(c, c->chrDstVSubSample, c->dst_v_chr_pos, 1), 0)) < 0)
 
             goto fail;
 
@@ -2033,8 +2196,13 @@ static int context_init_threaded(SwsContext *sws,
     SwsInternal *c = sws_internal(sws);
     int ret;
 
-    ret = avpriv_slicethread_create(&c->slicethread, (void*) sws,
-                                    ff_sws_slice_worker, NULL, c->nb_threads);
+    if (c->thread_pool)
+        ret = avpriv_slicethread_create_shared(&c->slicethread, (void*) sws,
+                                               ff_sws_slice_worker, c->nb_threads,
+                                               c->thread_pool);
+    else
+        ret = avpriv_slicethread_create(&c->slicethread, (void*) sws,
+                                        ff_sws_slice_worker, NULL, c->nb_threads);
     if (ret == AVERROR(ENOSYS)) {
         c->nb_threads = 1;
         return 0;
@@ -2078,6 +2246,19 @@ static int context_init_threaded(SwsContext *sws,
     return 0;
 }
 
+int sws_set_thread_pool(SwsContext *sws, AVBufferRef *pool)
+{
+    SwsInternal *c = sws_internal(sws);
+
+    av_buffer_unref(&c->thread_pool);
+    if (pool) {
+        c->thread_pool = av_buffer_ref(pool);
+        if (!c->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *sws, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -2456,6 +2637,7 @@ void sws_freeContext(SwsContext *sws)
     av_freep(&c->slice_err);
 
     avpriv_slicethread_free(&c->slicethread);
+    av_buffer_unref(&c->thread_pool);
 
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
@@ -2465,6 +2647,27 @@ void sws_freeContext(SwsContext *sws)
 
     av_freep(&c->src_ranges.ranges);
 
+    /* shared filters are released here, the av_freep() calls below
+     * then only free the ones owned by this context */
+    if (c->filter_cache[0]) {
+        c->hLumFilter    = NULL;
+        c->hLumFilterPos = NULL;
+    }
+    if (c->filter_cache[1]) {
+        c->hChrFilter    = NULL;
+        c->hChrFilterPos = NULL;
+    }
+    if (c->filter_cache[2]) {
+        c->vLumFilter    = NULL;
+        c->vLumFilterPos = NULL;
+    }
+    if (c->filter_cache[3]) {
+        c->vChrFilter    = NULL;
+        c->vChrFilterPos = NULL;
+    }
+    for (i = 0; i < 4; i++)
+        filter_cache_unref(&c->filter_cache[i]);
+
     av_freep(&c->vLumFilter);
     av_freep(&c->vChrFilter);
     av_freep(&c->hLumFilter);
@@ -27,17 +27,25 @@ SECTION_RODATA 32
 
 minshort:      times 8 dw 0x8000
 yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
+yuv2yuvX_14_start:  times 4 dd 0x1000
+yuv2yuvX_12_start:  times 4 dd 0x4000
 yuv2yuvX_10_start:  times 4 dd 0x10000
 yuv2yuvX_9_start:   times 4 dd 0x20000
+yuv2yuvX_14_upper:  times 8 dw 0x3fff
+yuv2yuvX_12_upper:  times 8 dw 0xfff
 yuv2yuvX_10_upper:  times 8 dw 0x3ff
 yuv2yuvX_9_upper:   times 8 dw 0x1ff
 pd_4:          times 4 dd 4
+pw_1:          times 8 dw 1
+pw_4:          times 8 dw 4
 pd_4min0x40000:times 4 dd 4 - (0x40000)
 pw_16:         times 8 dw 16
 pw_32:         times 8 dw 32
 pd_255:        times 8 dd 255
 pw_512:        times 8 dw 512
 pw_1024:       times 8 dw 1024
+pw_4096:       times 8 dw 4096
+pw_16384:      times 8 dw 16384
 pd_65535_invf:             times 8 dd 0x37800080 ;1.0/65535.0
 pd_yuv2gbrp16_start:       times 8 dd -0x40000000
 pd_yuv2gbrp_y_start:       times 8 dd  (1 << 9)
@@ -106,7 +114,7 @@ SECTION .text
 ;                                     const uint8_t *dither, int offset)
 ;
 ; Scale one or $filterSize lines of source data to generate one line of output
-; data. The input is 15 bits in int16_t if $output_size is [8,10] and 19 bits in
+; data. The input is 15 bits in int16_t if $output_size is [8,14] and 19 bits in
 ; int32_t if $output_size is 16. $filter is 12 bits. $filterSize is a multiple
 ; of 2. $offset is either 0 or 3. $dither holds 8 values.
 ;-----------------------------------------------------------------------------
@@ -133,10 +141,10 @@ SECTION .text
     mova            m2,  m8
     mova            m1,  m_dith
 %endif ; x86-32/64
-%else ; %1 == 9/10/16
+%else ; %1 == 9/10/12/14/16
     mova            m1, [yuv2yuvX_%1_start]
     mova            m2,  m1
-%endif ; %1 == 8/9/10/16
+%endif ; %1 == 8/9/10/12/14/16
     movsx     cntr_reg,  fltsizem
 .filterloop_%2_ %+ %%i:
     ; input pixels
@@ -199,19 +207,21 @@ SECTION .text
     packssdw        m2,  m1
     packuswb        m2,  m2
     movh   [dstq+r5*1],  m2
-%else ; %1 == 9/10/16
+%else ; %1 == 9/10/12/14/16
 %if %1 == 16
     packssdw        m2,  m1
     paddw           m2, [minshort]
-%else ; %1 == 9/10
-%if cpuflag(sse4)
+%else ; %1 == 9/10/12/14
+    ; the sums of 12 and 14 bit output can exceed the signed word range
+    ; that pminsw clips against, so saturate them with packssdw instead
+%if cpuflag(sse4) && %1 <= 10
     packusdw        m2,  m1
-%else ; mmxext/sse2
+%else ; mmxext/sse2, or 12/14 bits
     packssdw        m2,  m1
     pmaxsw          m2,  m6
 %endif ; mmxext/sse2/sse4/avx
     pminsw          m2, [yuv2yuvX_%1_upper]
-%endif ; %1 == 9/10/16
+%endif ; %1 == 9/10/12/14/16
     mov%2   [dstq+r5*2],  m2
 %endif ; %1 == 8/9/10/16
 
@@ -234,9 +244,9 @@ SECTION .text
 %endif
 
 cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
-%if %1 == 8 || %1 == 9 || %1 == 10
+%if %1 != 16
     pxor            m6,  m6
-%endif ; %1 == 8/9/10
+%endif ; %1 != 16
 
 %if %1 == 8
 %if ARCH_X86_32
@@ -309,9 +319,9 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %else ; x86-64
     RET
 %endif ; x86-32/64
-%else ; %1 == 9/10/16
+%else ; %1 == 9/10/12/14/16
     RET
-%endif ; %1 == 8/9/10/16
+%endif ; %1 == 8/9/10/12/14/16
 %endmacro
 
 %if ARCH_X86_32 && HAVE_ALIGNED_STACK == 0
@@ -323,11 +333,15 @@ INIT_XMM sse2
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 
 INIT_XMM sse4
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 yuv2planeX_fn 16,  8, 5
 
 %if HAVE_AVX_EXTERNAL
@@ -335,6 +349,8 @@ INIT_XMM avx
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 %endif
 
 ; %1=outout-bpc, %2=alignment (u/a)
@@ -367,7 +383,7 @@ yuv2planeX_fn 10,  7, 5
 %endif ; mmx/sse2/sse4/avx
     mov%2    [dstq+wq*2+mmsize*0], m0
     mov%2    [dstq+wq*2+mmsize*1], m2
-%else ; %1 == 9/10
+%else ; %1 == 9/10/12/14
     paddsw          m0, m2, [srcq+wq*2+mmsize*0]
     paddsw          m1, m2, [srcq+wq*2+mmsize*1]
     psraw           m0, 15 - %1
@@ -420,6 +436,14 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     pxor            m4, m4
     mova            m3, [pw_1024]
     mova            m2, [pw_16]
+%elif %1 == 12
+    pxor            m4, m4
+    mova            m3, [pw_4096]
+    mova            m2, [pw_4]
+%elif %1 == 14
+    pxor            m4, m4
+    mova            m3, [pw_16384]
+    mova            m2, [pw_1]
 %else ; %1 == 16
 %if cpuflag(sse4) ; sse4/avx
     mova            m4, [pd_4]
@@ -443,6 +467,8 @@ INIT_XMM sse2
 yuv2plane1_fn  8, 5, 5
 yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 12, 5, 3
+yuv2plane1_fn 14, 5, 3
 yuv2plane1_fn 16, 6, 3
 
 INIT_XMM sse4
@@ -453,6 +479,8 @@ INIT_XMM avx
 yuv2plane1_fn  8, 5, 5
 yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 12, 5, 3
+yuv2plane1_fn 14, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
 
@@ -270,7 +270,9 @@ void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
 #define VSCALEX_FUNCS(opt) \
     VSCALEX_FUNC(8,  opt); \
     VSCALEX_FUNC(9,  opt); \
-    VSCALEX_FUNC(10, opt)
+    VSCALEX_FUNC(10, opt); \
+    VSCALEX_FUNC(12, opt); \
+    VSCALEX_FUNC(14, opt)
 
 VSCALEX_FUNC(8, mmxext);
 VSCALEX_FUNCS(sse2);
@@ -285,6 +287,8 @@ void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int ds
     VSCALE_FUNC(8,  opt1); \
     VSCALE_FUNC(9,  opt2); \
     VSCALE_FUNC(10, opt2); \
+    VSCALE_FUNC(12, opt2); \
+    VSCALE_FUNC(14, opt2); \
     VSCALE_FUNC(16, opt1)
 
 VSCALE_FUNCS(sse2, sse2);
@@ -538,6 +542,8 @@ av_cold void ff_sws_init_swscale_x86(SwsInternal *c)
 #define ASSIGN_VSCALEX_FUNC(vscalefn, opt, do_16_case, condition_8bit) \
 switch(c->dstBpc){ \
     case 16:                          do_16_case;                          break; \
+    case 14: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2planeX_14_ ## opt; break; \
+    case 12: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2planeX_12_ ## opt; break; \
     case 10: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2planeX_10_ ## opt; break; \
     case 9:  if (!isBE(c->dstFormat)) vscalefn = ff_yuv2planeX_9_  ## opt; break; \
     case 8: if ((condition_8bit) && !c->use_mmx_vfilter) vscalefn = ff_yuv2planeX_8_  ## opt; break; \
@@ -545,6 +551,8 @@ switch(c->dstBpc){ \
 #define ASSIGN_VSCALE_FUNC(vscalefn, opt) \
     switch(c->dstBpc){ \
     case 16: if (!isBE(c->dstFormat)) vscalefn = ff_yuv2plane1_16_ ## opt; break; \
+    case 14: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2plane1_14_ ## opt; break; \
+    case 12: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2plane1_12_ ## opt; break; \
     case 10: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2plane1_10_ ## opt; break; \
     case 9:  if (!isBE(c->dstFormat)) vscalefn = ff_yuv2plane1_9_  ## opt;  break; \
     case 8:                           vscalefn = ff_yuv2plane1_8_  ## opt;  break; \
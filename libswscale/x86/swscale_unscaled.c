@@ -0,0 +1,307 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/avassert.h"
+#include "libavutil/cpu.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/x86/cpu.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#if HAVE_X86ASM
+
+typedef void (*copy_up_16_fn)(uint16_t *dst, const uint16_t *src, int w,
+                              int lshift, int rshift);
+typedef void (*copy_up_8_fn)(uint16_t *dst, const uint8_t *src, int w,
+                             int lshift, int rshift);
+typedef void (*interleave_up_16_fn)(uint16_t *dst, const uint16_t *src1,
+                                    const uint16_t *src2, int w, int shift);
+typedef void (*copy_down_16_fn)(uint16_t *dst, const uint16_t *src, int w,
+                                int shift);
+typedef void (*deinterleave_down_16_fn)(uint16_t *dst1, uint16_t *dst2,
+                                        const uint16_t *src, int w, int shift);
+
+#define DECLARE_UNSCALED_FUNCS(ext)                                         \
+void ff_copy_up_16_##ext(uint16_t *dst, const uint16_t *src, int w,         \
+                         int lshift, int rshift);                           \
+void ff_copy_up_8_##ext(uint16_t *dst, const uint8_t *src, int w,           \
+                        int lshift, int rshift);                            \
+void ff_interleave_up_16_##ext(uint16_t *dst, const uint16_t *src1,         \
+                               const uint16_t *src2, int w, int shift);    \
+void ff_copy_down_16_##ext(uint16_t *dst, const uint16_t *src, int w,       \
+                           int shift);                                      \
+void ff_deinterleave_down_16_##ext(uint16_t *dst1, uint16_t *dst2,          \
+                                   const uint16_t *src, int w, int shift);
+
+DECLARE_UNSCALED_FUNCS(sse2)
+DECLARE_UNSCALED_FUNCS(avx2)
+
+/* The SIMD functions handle multiples of 16 pixels, the rest is done here. */
+static av_always_inline void copy_up_16(copy_up_16_fn fn, uint16_t *dst,
+                                        const uint16_t *src, int w,
+                                        int lshift, int rshift)
+{
+    int x = w & ~15;
+
+    if (x)
+        fn(dst, src, x, lshift, rshift);
+    for (; x < w; x++)
+        dst[x] = (src[x] << lshift) | (src[x] >> rshift);
+}
+
+static av_always_inline void copy_up_8(copy_up_8_fn fn, uint16_t *dst,
+                                       const uint8_t *src, int w,
+                                       int lshift, int rshift)
+{
+    int x = w & ~15;
+
+    if (x)
+        fn(dst, src, x, lshift, rshift);
+    for (; x < w; x++)
+        dst[x] = (src[x] << lshift) | (src[x] >> rshift);
+}
+
+static av_always_inline int planar_to_p01x(SwsInternal *c,
+                                           const uint8_t *const src8[],
+                                           const int srcStride[],
+                                           int srcSliceY, int srcSliceH,
+                                           uint8_t *const dstParam8[],
+                                           const int dstStride[],
+                                           copy_up_16_fn copy_fn,
+                                           interleave_up_16_fn interleave_fn)
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const uint16_t *src0 = (const uint16_t *)src8[0];
+    const uint16_t *src1 = (const uint16_t *)src8[1];
+    const uint16_t *src2 = (const uint16_t *)src8[2];
+    uint16_t *dstY  = (uint16_t *)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstUV = (uint16_t *)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    const int shiftY  = dst_format->comp[0].depth + dst_format->comp[0].shift -
+                        src_format->comp[0].depth - src_format->comp[0].shift;
+    const int shiftUV = dst_format->comp[1].depth + dst_format->comp[1].shift -
+                        src_format->comp[1].depth - src_format->comp[1].shift;
+    const int chrW  = c->srcW / 2;
+    const int chrW16 = chrW & ~15;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2));
+
+    for (int y = 0; y < srcSliceH; y++) {
+        copy_up_16(copy_fn, dstY, src0, c->srcW, shiftY, 16);
+        src0 += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & 1)) {
+            if (chrW16)
+                interleave_fn(dstUV, src1, src2, chrW16, shiftUV);
+            for (int x = chrW16; x < chrW; x++) {
+                dstUV[2 * x    ] = src1[x] << shiftUV;
+                dstUV[2 * x + 1] = src2[x] << shiftUV;
+            }
+            src1  += srcStride[1] / 2;
+            src2  += srcStride[2] / 2;
+            dstUV += dstStride[1] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+/* Same output as ff_p01x_to_planar_wrapper(). */
+static av_always_inline int p01x_to_planar(SwsInternal *c,
+                                           const uint8_t *const src8[],
+                                           const int srcStride[],
+                                           int srcSliceY, int srcSliceH,
+                                           uint8_t *const dstParam8[],
+                                           const int dstStride[],
+                                           copy_down_16_fn copy_fn,
+                                           deinterleave_down_16_fn deinterleave_fn)
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const uint16_t *srcY  = (const uint16_t *)src8[0];
+    const uint16_t *srcUV = (const uint16_t *)src8[1];
+    uint16_t *dstY = (uint16_t *)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstU = (uint16_t *)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
+    uint16_t *dstV = (uint16_t *)(dstParam8[2] + dstStride[2] * srcSliceY / 2);
+    const int shiftY  = src_format->comp[0].shift - dst_format->comp[0].shift;
+    const int shiftUV = src_format->comp[1].shift - dst_format->comp[1].shift;
+    const int lumW16 = c->srcW & ~15;
+    const int chrW16 = c->chrSrcW & ~15;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    for (int y = 0; y < srcSliceH; y++) {
+        if (lumW16)
+            copy_fn(dstY, srcY, lumW16, shiftY);
+        for (int x = lumW16; x < c->srcW; x++)
+            dstY[x] = srcY[x] >> shiftY;
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & 1)) {
+            if (chrW16)
+                deinterleave_fn(dstU, dstV, srcUV, chrW16, shiftUV);
+            for (int x = chrW16; x < c->chrSrcW; x++) {
+                dstU[x] = srcUV[2 * x    ] >> shiftUV;
+                dstV[x] = srcUV[2 * x + 1] >> shiftUV;
+            }
+            srcUV += srcStride[1] / 2;
+            dstU  += dstStride[1] / 2;
+            dstV  += dstStride[2] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+/* Same output as the depth increasing paths of ff_planar_copy_wrapper(). */
+static av_always_inline int planar_copy_up(SwsInternal *c,
+                                           const uint8_t *const src[],
+                                           const int srcStride[],
+                                           int srcSliceY, int srcSliceH,
+                                           uint8_t *const dst[],
+                                           const int dstStride[],
+                                           copy_up_16_fn copy16_fn,
+                                           copy_up_8_fn copy8_fn)
+{
+    const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
+
+    for (int plane = 0; plane < 4 && dst[plane]; plane++) {
+        const int length = (plane == 0 || plane == 3) ? c->srcW    : AV_CEIL_RSHIFT(c->srcW,    c->chrDstHSubSample);
+        const int y      = (plane == 0 || plane == 3) ? srcSliceY  : AV_CEIL_RSHIFT(srcSliceY,  c->chrDstVSubSample);
+        const int height = (plane == 0 || plane == 3) ? srcSliceH  : AV_CEIL_RSHIFT(srcSliceH,  c->chrDstVSubSample);
+        const int shiftonly = plane == 1 || plane == 2 || (!c->srcRange && plane == 0);
+        const int src_depth = desc_src->comp[plane].depth;
+        const int dst_depth = desc_dst->comp[plane].depth;
+        const int lshift = dst_depth - src_depth;
+        const int rshift = shiftonly ? 16 : 2 * src_depth - dst_depth;
+        const uint8_t *srcPtr = src[plane];
+        uint16_t *dstPtr = (uint16_t *)(dst[plane] + dstStride[plane] * y);
+
+        // ignore palette for GRAY8
+        if (plane == 1 && !dst[2])
+            continue;
+
+        for (int i = 0; i < height; i++) {
+            if (src_depth == 8)
+                copy_up_8(copy8_fn, dstPtr, srcPtr, length, lshift, rshift);
+            else
+                copy_up_16(copy16_fn, dstPtr, (const uint16_t *)srcPtr,
+                           length, lshift, rshift);
+            srcPtr += srcStride[plane];
+            dstPtr += dstStride[plane] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+#define UNSCALED_WRAPPERS(ext)                                                  \
+static int planar_to_p01x_##ext(SwsInternal *c, const uint8_t *const src[],     \
+                                const int srcStride[], int srcSliceY,           \
+                                int srcSliceH, uint8_t *const dst[],            \
+                                const int dstStride[])                          \
+{                                                                               \
+    return planar_to_p01x(c, src, srcStride, srcSliceY, srcSliceH,              \
+                          dst, dstStride, ff_copy_up_16_##ext,                  \
+                          ff_interleave_up_16_##ext);                           \
+}                                                                               \
+                                                                                \
+static int p01x_to_planar_##ext(SwsInternal *c, const uint8_t *const src[],     \
+                                const int srcStride[], int srcSliceY,           \
+                                int srcSliceH, uint8_t *const dst[],            \
+                                const int dstStride[])                          \
+{                                                                               \
+    return p01x_to_planar(c, src, srcStride, srcSliceY, srcSliceH,              \
+                          dst, dstStride, ff_copy_down_16_##ext,                \
+                          ff_deinterleave_down_16_##ext);                       \
+}                                                                               \
+                                                                                \
+static int planar_copy_up_##ext(SwsInternal *c, const uint8_t *const src[],     \
+                                const int srcStride[], int srcSliceY,           \
+                                int srcSliceH, uint8_t *const dst[],            \
+                                const int dstStride[])                          \
+{                                                                               \
+    return planar_copy_up(c, src, srcStride, srcSliceY, srcSliceH,              \
+                          dst, dstStride, ff_copy_up_16_##ext,                  \
+                          ff_copy_up_8_##ext);                                  \
+}
+
+UNSCALED_WRAPPERS(sse2)
+#if HAVE_AVX2_EXTERNAL
+UNSCALED_WRAPPERS(avx2)
+#endif
+
+/* Whether ff_planar_copy_wrapper() was selected and takes its depth
+ * increasing path, for native endian formats with the same planes. */
+static int is_planar_copy_up(const SwsInternal *c)
+{
+    const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
+    const int src_depth = desc_src->comp[0].depth;
+    const int dst_depth = desc_dst->comp[0].depth;
+
+    if (c->convert_unscaled != ff_planar_copy_wrapper)
+        return 0;
+    if ((desc_src->flags | desc_dst->flags) & (AV_PIX_FMT_FLAG_BE | AV_PIX_FMT_FLAG_FLOAT) ||
+        desc_src->nb_components != desc_dst->nb_components)
+        return 0;
+
+    return src_depth >= 8 && src_depth < dst_depth && dst_depth <= 16;
+}
+
+av_cold void ff_get_unscaled_swscale_x86(SwsInternal *c)
+{
+    int cpu_flags = av_get_cpu_flags();
+    const int p01x        = c->convert_unscaled == ff_planar_to_p01x_wrapper;
+    const int p01x_planar = c->convert_unscaled == ff_p01x_to_planar_wrapper;
+    const int copy_up     = is_planar_copy_up(c);
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        if (p01x)
+            c->convert_unscaled = planar_to_p01x_sse2;
+        if (p01x_planar)
+            c->convert_unscaled = p01x_to_planar_sse2;
+        if (copy_up)
+            c->convert_unscaled = planar_copy_up_sse2;
+    }
+#if HAVE_AVX2_EXTERNAL
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        if (p01x)
+            c->convert_unscaled = planar_to_p01x_avx2;
+        if (p01x_planar)
+            c->convert_unscaled = p01x_to_planar_avx2;
+        if (copy_up)
+            c->convert_unscaled = planar_copy_up_avx2;
+    }
+#endif
+}
+
+#else
+
+av_cold void ff_get_unscaled_swscale_x86(SwsInternal *c)
+{
+}
+
+#endif /* HAVE_X86ASM */
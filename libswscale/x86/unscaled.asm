@@ -0,0 +1,223 @@
+;******************************************************************************
+;* x86-optimized high bit depth repacking for the unscaled converters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; All functions process 16 pixels per iteration, w must be a positive
+; multiple of 16. The depth increasing functions take the shift counts in
+; xm2 (left) and xm3 (right); a right shift of 16 or more clears the
+; replicated bits.
+
+; %1 = pixels/result, %2 = tmp
+%macro SHIFT_UP 2
+    psrlw           %2, %1, xm3
+    psllw           %1, xm2
+    por             %1, %2
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_copy_up_16(uint16_t *dst, const uint16_t *src, int w,
+;                    int lshift, int rshift);
+;
+; dst[x] = (src[x] << lshift) | (src[x] >> rshift)
+;-----------------------------------------------------------------------------
+%macro COPY_UP_16 0
+cglobal copy_up_16, 5, 5, 6, dst, src, w, lshift, rshift
+    movd            xm2, lshiftd
+    movd            xm3, rshiftd
+    movsxdifnidn    wq, wd
+    lea             srcq, [srcq + wq*2]
+    lea             dstq, [dstq + wq*2]
+    neg             wq
+.loop:
+    movu            m0, [srcq + wq*2]
+%if mmsize == 16
+    movu            m1, [srcq + wq*2 + 16]
+%endif
+    SHIFT_UP        m0, m4
+%if mmsize == 16
+    SHIFT_UP        m1, m5
+    movu            [dstq + wq*2 + 16], m1
+%endif
+    movu            [dstq + wq*2], m0
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_copy_up_8(uint16_t *dst, const uint8_t *src, int w,
+;                   int lshift, int rshift);
+;-----------------------------------------------------------------------------
+%macro COPY_UP_8 0
+cglobal copy_up_8, 5, 5, 6, dst, src, w, lshift, rshift
+    movd            xm2, lshiftd
+    movd            xm3, rshiftd
+    movsxdifnidn    wq, wd
+    add             srcq, wq
+    lea             dstq, [dstq + wq*2]
+    neg             wq
+%if mmsize == 16
+    pxor            m5, m5
+%endif
+.loop:
+%if mmsize == 32
+    pmovzxbw        m0, [srcq + wq]
+    SHIFT_UP        m0, m4
+%else
+    movu            m0, [srcq + wq]
+    punpckhbw       m1, m0, m5
+    punpcklbw       m0, m5
+    SHIFT_UP        m0, m4
+    SHIFT_UP        m1, m4
+    movu            [dstq + wq*2 + 16], m1
+%endif
+    movu            [dstq + wq*2], m0
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_interleave_up_16(uint16_t *dst, const uint16_t *src1,
+;                          const uint16_t *src2, int w, int shift);
+;
+; dst[2*x] = src1[x] << shift, dst[2*x+1] = src2[x] << shift
+;-----------------------------------------------------------------------------
+%macro INTERLEAVE_UP_16 0
+cglobal interleave_up_16, 5, 5, 4, dst, src1, src2, w, shift
+    movd            xm2, shiftd
+    movsxdifnidn    wq, wd
+    lea             src1q, [src1q + wq*2]
+    lea             src2q, [src2q + wq*2]
+    lea             dstq, [dstq + wq*4]
+    neg             wq
+.loop:
+%assign i 0
+%rep 32 / mmsize
+    movu            m0, [src1q + wq*2 + i*mmsize]
+    movu            m1, [src2q + wq*2 + i*mmsize]
+    psllw           m0, xm2
+    psllw           m1, xm2
+    punpckhwd       m3, m0, m1
+    punpcklwd       m0, m1
+%if mmsize == 32
+    ; punpck{l,h}wd interleave within each lane, restore the pixel order
+    vperm2i128      m1, m0, m3, 0x20
+    vperm2i128      m3, m0, m3, 0x31
+    movu            [dstq + wq*4 + (2*i+0)*mmsize], m1
+%else
+    movu            [dstq + wq*4 + (2*i+0)*mmsize], m0
+%endif
+    movu            [dstq + wq*4 + (2*i+1)*mmsize], m3
+%assign i i+1
+%endrep
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_copy_down_16(uint16_t *dst, const uint16_t *src, int w, int shift);
+;
+; dst[x] = src[x] >> shift
+;-----------------------------------------------------------------------------
+%macro COPY_DOWN_16 0
+cglobal copy_down_16, 4, 4, 3, dst, src, w, shift
+    movd            xm2, shiftd
+    movsxdifnidn    wq, wd
+    lea             srcq, [srcq + wq*2]
+    lea             dstq, [dstq + wq*2]
+    neg             wq
+.loop:
+%assign i 0
+%rep 32 / mmsize
+    movu            m0, [srcq + wq*2 + i*mmsize]
+    psrlw           m0, xm2
+    movu            [dstq + wq*2 + i*mmsize], m0
+%assign i i+1
+%endrep
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_deinterleave_down_16(uint16_t *dst1, uint16_t *dst2,
+;                              const uint16_t *src, int w, int shift);
+;
+; dst1[x] = src[2*x] >> shift, dst2[x] = src[2*x+1] >> shift
+;-----------------------------------------------------------------------------
+%macro DEINTERLEAVE_DOWN_16 0
+cglobal deinterleave_down_16, 5, 5, 5, dst1, dst2, src, w, shift
+    movd            xm4, shiftd
+    movsxdifnidn    wq, wd
+    lea             srcq, [srcq + wq*4]
+    lea             dst1q, [dst1q + wq*2]
+    lea             dst2q, [dst2q + wq*2]
+    neg             wq
+.loop:
+%assign i 0
+%rep 32 / mmsize
+    movu            m0, [srcq + wq*4 + (2*i+0)*mmsize]
+    movu            m1, [srcq + wq*4 + (2*i+1)*mmsize]
+    ; sign extend both halves of each dword so that the signed saturation
+    ; of packssdw keeps all 16 bits
+    pslld           m2, m0, 16
+    pslld           m3, m1, 16
+    psrad           m2, 16
+    psrad           m3, 16
+    psrad           m0, 16
+    psrad           m1, 16
+    packssdw        m2, m3
+    packssdw        m0, m1
+%if mmsize == 32
+    ; packssdw packs within each lane, restore the pixel order
+    vpermq          m2, m2, q3120
+    vpermq          m0, m0, q3120
+%endif
+    psrlw           m2, xm4
+    psrlw           m0, xm4
+    movu            [dst1q + wq*2 + i*mmsize], m2
+    movu            [dst2q + wq*2 + i*mmsize], m0
+%assign i i+1
+%endrep
+    add             wq, 16
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+COPY_UP_16
+COPY_UP_8
+INTERLEAVE_UP_16
+COPY_DOWN_16
+DEINTERLEAVE_DOWN_16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+COPY_UP_16
+COPY_UP_8
+INTERLEAVE_UP_16
+COPY_DOWN_16
+DEINTERLEAVE_DOWN_16
+%endif
@@ -0,0 +1,238 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/aom_film_grain.h"
+#include "libavutil/mem_internal.h"
+
+#define LUT_SIZE   ((FF_AOM_GRAIN_HEIGHT + 1) * FF_AOM_GRAIN_WIDTH)
+#define STRIDE     128 // in samples, a multiple of the 32x32 block size
+#define ROWS       32
+
+static void init_params(AVFilmGrainParams *fgp)
+{
+    AVFilmGrainAOMParams *aom = &fgp->codec.aom;
+
+    memset(fgp, 0, sizeof(*fgp));
+    fgp->type = AV_FILM_GRAIN_PARAMS_AV1;
+    fgp->seed = rnd() & 0xFFFF;
+
+    aom->num_y_points             = 1 + rnd() % 14;
+    aom->chroma_scaling_from_luma = rnd() & 1;
+    aom->scaling_shift            = 8 + (rnd() & 3);
+    aom->ar_coeff_lag             = rnd() & 3;
+    aom->ar_coeff_shift           = 6 + (rnd() & 3);
+    aom->grain_scale_shift        = rnd() & 3;
+    aom->overlap_flag             = rnd() & 1;
+    aom->limit_output_range       = rnd() & 1;
+    for (int i = 0; i < FF_ARRAY_ELEMS(aom->ar_coeffs_y); i++)
+        aom->ar_coeffs_y[i] = rnd();
+    for (int uv = 0; uv < 2; uv++) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(aom->ar_coeffs_uv[uv]); i++)
+            aom->ar_coeffs_uv[uv][i] = rnd();
+        aom->uv_mult[uv]      = (int) (rnd() & 0xFF) - 128;
+        aom->uv_mult_luma[uv] = (int) (rnd() & 0xFF) - 128;
+        aom->uv_offset[uv]    = (int) (rnd() & 0x1FF) - 256;
+    }
+}
+
+static void randomize_pixels(void *buf, int size, int bpc, int bitdepth)
+{
+    for (int i = 0; i < size; i++) {
+        if (bpc > 8)
+            ((uint16_t *) buf)[i] = rnd() & ((1 << bitdepth) - 1);
+        else
+            ((uint8_t *) buf)[i] = rnd();
+    }
+}
+
+static void randomize_grain(void *buf, int size, int bpc, int bitdepth)
+{
+    for (int i = 0; i < size; i++) {
+        if (bpc > 8)
+            ((int16_t *) buf)[i] = (int) (rnd() & ((256 << (bitdepth - 8)) - 1)) -
+                                   (128 << (bitdepth - 8));
+        else
+            ((int8_t *) buf)[i] = rnd();
+    }
+}
+
+static void check_generate_grain(const AOMFilmGrainDSPContext *c,
+                                 int bpc, int bitdepth)
+{
+    LOCAL_ALIGNED_32(int16_t, luma,    [LUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, lut_ref, [LUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, lut_new, [LUT_SIZE]);
+    const int size = LUT_SIZE * (bpc > 8 ? 2 : 1);
+    AVFilmGrainParams fgp;
+
+    init_params(&fgp);
+
+    if (check_func(c->generate_grain_y, "generate_grain_y_%dbpc", bpc)) {
+        declare_func(void, void *buf, const AVFilmGrainParams *params,
+                     int bitdepth);
+
+        memset(lut_ref, 0, sizeof(int16_t[LUT_SIZE]));
+        memset(lut_new, 0, sizeof(int16_t[LUT_SIZE]));
+        call_ref(lut_ref, &fgp, bitdepth);
+        call_new(lut_new, &fgp, bitdepth);
+        if (memcmp(lut_ref, lut_new, size))
+            fail();
+        bench_new(lut_new, &fgp, bitdepth);
+    }
+    report("generate_grain_y");
+
+    for (int layout = 0; layout < 3; layout++) {
+        static const char *const names[3] = { "420", "422", "444" };
+        const int subx = layout < 2, suby = layout < 1;
+
+        if (check_func(c->generate_grain_uv, "generate_grain_uv_%s_%dbpc",
+                       names[layout], bpc)) {
+            declare_func(void, void *buf, const void *buf_y,
+                         const AVFilmGrainParams *params, int uv,
+                         int subx, int suby, int bitdepth);
+
+            for (int uv = 0; uv < 2; uv++) {
+                randomize_grain(luma, LUT_SIZE, bpc, bitdepth);
+                memset(lut_ref, 0, sizeof(int16_t[LUT_SIZE]));
+                memset(lut_new, 0, sizeof(int16_t[LUT_SIZE]));
+                call_ref(lut_ref, luma, &fgp, uv, subx, suby, bitdepth);
+                call_new(lut_new, luma, &fgp, uv, subx, suby, bitdepth);
+                if (memcmp(lut_ref, lut_new, size))
+                    fail();
+            }
+            bench_new(lut_new, luma, &fgp, 1, subx, suby, bitdepth);
+        }
+    }
+    report("generate_grain_uv");
+}
+
+static void check_fgy(const AOMFilmGrainDSPContext *c, int bpc, int bitdepth)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(int16_t,  lut,     [LUT_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t,  scaling, [4096]);
+    const ptrdiff_t stride = STRIDE * (bpc > 8 ? 2 : 1);
+    const int size = ROWS * STRIDE * (bpc > 8 ? 2 : 1);
+    AVFilmGrainParams fgp;
+
+    declare_func(void, void *dst_row, const void *src_row, ptrdiff_t stride,
+                 const AVFilmGrainParams *params, size_t pw,
+                 const uint8_t *scaling, const void *grain_lut,
+                 int bh, int row_num, int bitdepth);
+
+    if (check_func(c->fgy_32x32xn, "fgy_32x32xn_%dbpc", bpc)) {
+        for (int i = 0; i < 4; i++) {
+            const size_t pw  = 1 + rnd() % STRIDE;
+            const int bh     = 1 + rnd() % ROWS;
+            const int row_num = rnd() & 1;
+
+            init_params(&fgp);
+            randomize_pixels(src, ROWS * STRIDE, bpc, bitdepth);
+            randomize_pixels(dst_ref, ROWS * STRIDE, bpc, bitdepth);
+            memcpy(dst_new, dst_ref, size);
+            randomize_grain(lut, LUT_SIZE, bpc, bitdepth);
+            for (int j = 0; j < 4096; j++)
+                scaling[j] = rnd();
+
+            call_ref(dst_ref, src, stride, &fgp, pw, scaling, lut,
+                     bh, row_num, bitdepth);
+            call_new(dst_new, src, stride, &fgp, pw, scaling, lut,
+                     bh, row_num, bitdepth);
+            if (memcmp(dst_ref, dst_new, size))
+                fail();
+        }
+        bench_new(dst_new, src, stride, &fgp, STRIDE, scaling, lut,
+                  ROWS, 1, bitdepth);
+    }
+    report("fgy_32x32xn");
+}
+
+static void check_fguv(const AOMFilmGrainDSPContext *c, int bpc, int bitdepth)
+{
+    LOCAL_ALIGNED_32(uint16_t, luma,    [ROWS * STRIDE * 2]);
+    LOCAL_ALIGNED_32(uint16_t, src,     [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(int16_t,  lut,     [LUT_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t,  scaling, [4096]);
+    const ptrdiff_t stride = STRIDE * (bpc > 8 ? 2 : 1);
+    const int size = ROWS * STRIDE * (bpc > 8 ? 2 : 1);
+    AVFilmGrainParams fgp;
+
+    declare_func(void, void *dst_row, const void *src_row, ptrdiff_t stride,
+                 const AVFilmGrainParams *params, size_t pw,
+                 const uint8_t *scaling, const void *grain_lut,
+                 int bh, int row_num, const void *luma_row,
+                 ptrdiff_t luma_stride, int uv, int is_id,
+                 int sx, int sy, int bitdepth);
+
+    for (int layout = 0; layout < 3; layout++) {
+        static const char *const names[3] = { "420", "422", "444" };
+        const int sx = layout < 2, sy = layout < 1;
+
+        if (!check_func(c->fguv_32x32xn, "fguv_32x32xn_%s_%dbpc",
+                        names[layout], bpc))
+            continue;
+
+        for (int i = 0; i < 4; i++) {
+            const size_t pw   = 1 + rnd() % (STRIDE >> sx);
+            const int bh      = 1 + rnd() % (ROWS >> sy);
+            const int row_num = rnd() & 1;
+            const int uv      = rnd() & 1;
+            const int is_id   = rnd() & 1;
+
+            init_params(&fgp);
+            randomize_pixels(luma, ROWS * STRIDE * 2, bpc, bitdepth);
+            randomize_pixels(src, ROWS * STRIDE, bpc, bitdepth);
+            randomize_pixels(dst_ref, ROWS * STRIDE, bpc, bitdepth);
+            memcpy(dst_new, dst_ref, size);
+            randomize_grain(lut, LUT_SIZE, bpc, bitdepth);
+            for (int j = 0; j < 4096; j++)
+                scaling[j] = rnd();
+
+            call_ref(dst_ref, src, stride, &fgp, pw, scaling, lut, bh,
+                     row_num, luma, stride * 2, uv, is_id, sx, sy, bitdepth);
+            call_new(dst_new, src, stride, &fgp, pw, scaling, lut, bh,
+                     row_num, luma, stride * 2, uv, is_id, sx, sy, bitdepth);
+            if (memcmp(dst_ref, dst_new, size))
+                fail();
+        }
+        bench_new(dst_new, src, stride, &fgp, STRIDE >> sx, scaling, lut,
+                  ROWS >> sy, 1, luma, stride * 2, 0, 0, sx, sy, bitdepth);
+    }
+    report("fguv_32x32xn");
+}
+
+void checkasm_check_aom_film_grain(void)
+{
+    for (int bpc = 8; bpc <= 16; bpc += 8) {
+        const int bitdepth = bpc > 8 ? 10 + 2 * (rnd() & 1) : 8;
+        AOMFilmGrainDSPContext c;
+
+        ff_aom_film_grain_dsp_init(&c, bpc);
+
+        check_generate_grain(&c, bpc, bitdepth);
+        check_fgy(&c, bpc, bitdepth);
+        check_fguv(&c, bpc, bitdepth);
+    }
+}
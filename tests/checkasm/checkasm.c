@@ -169,6 +169,8 @@ static const struct {
         { "h264qpel", checkasm_check_h264qpel },
     #endif
     #if CONFIG_HEVC_DECODER
+        { "aom_film_grain", checkasm_check_aom_film_grain },
+        { "h274dsp", checkasm_check_h274dsp },
         { "hevc_add_res", checkasm_check_hevc_add_res },
         { "hevc_deblock", checkasm_check_hevc_deblock },
         { "hevc_idct", checkasm_check_hevc_idct },
@@ -253,6 +255,7 @@ static const struct {
     #if CONFIG_AFIR_FILTER
         { "af_afir", checkasm_check_afir },
     #endif
+        { "drawutils", checkasm_check_drawutils },
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
@@ -294,6 +297,9 @@ static const struct {
         { "float_dsp", checkasm_check_float_dsp },
         { "lls",       checkasm_check_lls },
         { "av_tx",     checkasm_check_av_tx },
+#if CONFIG_PIXELUTILS
+        { "pixelutils", checkasm_check_pixelutils },
+#endif
 #endif
     { NULL }
 };
@@ -0,0 +1,73 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+       int j;                            \
+       uint8_t *tmp_buf = (uint8_t *)buf;\
+       for (j = 0; j < size; j++)        \
+           tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+static void check_blend_row8(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, mask,    [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    FFDrawContext draw;
+
+    declare_func(void, uint8_t *dst, const uint8_t *mask, int w,
+                 unsigned src, unsigned alpha);
+
+    if (ff_draw_init(&draw, AV_PIX_FMT_YUV420P, 0) < 0)
+        return;
+
+    if (check_func(draw.blend_row8, "blend_row8")) {
+        for (int w = 16; w <= WIDTH; w += 48) {
+            /* same alpha scaling as ff_blend_mask() */
+            const unsigned alpha = (0x10307 * (rnd() & 0xFF) + 0x3) >> 8;
+            const unsigned src   = rnd() & 0xFF;
+
+            randomize_buffers(mask, WIDTH);
+            randomize_buffers(dst_ref, WIDTH);
+            memcpy(dst_new, dst_ref, WIDTH);
+            /* exercise the extremes of the mask */
+            mask[0] = 0;
+            mask[1] = 0xFF;
+
+            call_ref(dst_ref, mask, w, src, alpha);
+            call_new(dst_new, mask, w, src, alpha);
+            if (memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+        }
+        bench_new(dst_new, mask, WIDTH, 0xFF, 0x10203);
+    }
+}
+
+void checkasm_check_drawutils(void)
+{
+    check_blend_row8();
+    report("blend_row8");
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/h274.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 1928
+
+#define randomize_buffer(buf, size)     \
+    do {                                \
+        for (int i = 0; i < size; i++)  \
+            buf[i] = rnd();             \
+    } while (0)
+
+static void check_avg_8x8(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [8 * 64]);
+    uint16_t ref, new;
+
+    declare_func(uint16_t, const uint8_t *in, ptrdiff_t in_stride);
+
+    randomize_buffer(src, 8 * 64);
+    ref = call_ref(src, 64);
+    new = call_new(src, 64);
+    if (ref != new)
+        fail();
+    bench_new(src, 64);
+}
+
+static void check_synth_grain_8x8(void)
+{
+    LOCAL_ALIGNED_32(int8_t, db,      [8 * 64]);
+    LOCAL_ALIGNED_32(int8_t, dst_ref, [8 * 32]);
+    LOCAL_ALIGNED_32(int8_t, dst_new, [8 * 32]);
+    const int16_t scale = (int16_t) (rnd() & 0x1FF) - 255;
+    const uint8_t shift = 8 + rnd() % 6;
+
+    declare_func(void, int8_t *out, ptrdiff_t out_stride,
+                 int16_t scale, uint8_t shift, const int8_t *db);
+
+    randomize_buffer(db, 8 * 64);
+    memset(dst_ref, 0, 8 * 32);
+    memset(dst_new, 0, 8 * 32);
+    call_ref(dst_ref, 32, scale, shift, db);
+    call_new(dst_new, 32, scale, shift, db);
+    if (memcmp(dst_ref, dst_new, 8 * 32))
+        fail();
+    bench_new(dst_new, 32, scale, shift, db);
+}
+
+static void check_deblock_8x8(void)
+{
+    LOCAL_ALIGNED_32(int8_t, dst_ref, [8 * 32]);
+    LOCAL_ALIGNED_32(int8_t, dst_new, [8 * 32]);
+
+    declare_func(void, int8_t *out, ptrdiff_t out_stride);
+
+    randomize_buffer(dst_ref, 8 * 32);
+    memcpy(dst_new, dst_ref, 8 * 32);
+    call_ref(dst_ref + 8, 32);
+    call_new(dst_new + 8, 32);
+    if (memcmp(dst_ref, dst_new, 8 * 32))
+        fail();
+    bench_new(dst_new + 8, 32);
+}
+
+static void check_add_grain_clip(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [WIDTH]);
+    LOCAL_ALIGNED_32(int8_t,  grain,   [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+
+    declare_func(void, uint8_t *out, const uint8_t *in,
+                 const int8_t *grain, int n);
+
+    for (int w = WIDTH - 8; w <= WIDTH; w++) {
+        randomize_buffer(src, WIDTH);
+        randomize_buffer(grain, WIDTH);
+        memset(dst_ref, 0, WIDTH);
+        memset(dst_new, 0, WIDTH);
+        call_ref(dst_ref, src, grain, w);
+        call_new(dst_new, src, grain, w);
+        if (memcmp(dst_ref, dst_new, WIDTH))
+            fail();
+    }
+    bench_new(dst_new, src, grain, WIDTH);
+}
+
+void checkasm_check_h274dsp(void)
+{
+    H274DSPContext h;
+
+    ff_h274dsp_init(&h);
+
+    if (check_func(h.avg_8x8, "avg_8x8"))
+        check_avg_8x8();
+    report("avg_8x8");
+
+    if (check_func(h.synth_grain_8x8, "synth_grain_8x8"))
+        check_synth_grain_8x8();
+    report("synth_grain_8x8");
+
+    if (check_func(h.deblock_8x8, "deblock_8x8"))
+        check_deblock_8x8();
+    report("deblock_8x8");
+
+    if (check_func(h.add_grain_clip, "add_grain_clip"))
+        check_add_grain_clip();
+    report("add_grain_clip");
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixelutils.h"
+
+#define MAX_BLOCK 32
+#define STRIDE    (2 * MAX_BLOCK)
+#define BUF_SIZE  (STRIDE * (MAX_BLOCK + 1))
+
+#define randomize_buffers(buf)                  \
+    do {                                        \
+        for (int j = 0; j < BUF_SIZE; j += 4)   \
+            AV_WN32A(buf + j, rnd());           \
+    } while (0)
+
+static void check_sad(const uint8_t *src1, const uint8_t *src2)
+{
+    static const char *const align_names[] = { "unaligned", "src1_aligned", "aligned" };
+
+    declare_func(int, const uint8_t *src1, ptrdiff_t stride1,
+                      const uint8_t *src2, ptrdiff_t stride2);
+
+    for (int bits = 1; bits <= 5; bits++) {
+        const int size = 1 << bits;
+
+        for (int aligned = 0; aligned <= 2; aligned++) {
+            /* the misaligned offsets also have to stay valid for the
+             * aligned versions of the functions */
+            const int off1 = aligned >= 1 ? 0 : 1 + rnd() % (MAX_BLOCK - 1);
+            const int off2 = aligned >= 2 ? 0 : 1 + rnd() % (MAX_BLOCK - 1);
+
+            if (check_func(av_pixelutils_get_sad_fn(bits, bits, aligned, NULL),
+                           "sad_%dx%d_%s", size, size, align_names[aligned])) {
+                int ref, new;
+
+                ref = call_ref(src1 + off1, STRIDE, src2 + off2, STRIDE);
+                new = call_new(src1 + off1, STRIDE, src2 + off2, STRIDE);
+                if (ref != new) {
+                    fprintf(stderr, "sad %dx%d: %d != %d\n", size, size, ref, new);
+                    fail();
+                }
+                /* largest possible difference */
+                ref = call_ref(src1 + BUF_SIZE, STRIDE, src2 + BUF_SIZE, STRIDE);
+                new = call_new(src1 + BUF_SIZE, STRIDE, src2 + BUF_SIZE, STRIDE);
+                if (ref != new) {
+                    fprintf(stderr, "sad %dx%d: %d != %d\n", size, size, ref, new);
+                    fail();
+                }
+                bench_new(src1 + off1, STRIDE, src2 + off2, STRIDE);
+            }
+        }
+    }
+}
+
+void checkasm_check_pixelutils(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [2 * BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [2 * BUF_SIZE]);
+
+    randomize_buffers(src1);
+    randomize_buffers(src2);
+    memset(src1 + BUF_SIZE, 0x00, BUF_SIZE);
+    memset(src2 + BUF_SIZE, 0xFF, BUF_SIZE);
+
+    check_sad(src1, src2);
+    report("sad");
+}
@@ -395,6 +395,99 @@ static void check_input_planar_rgb_to_a(void)
     sws_freeContext(sws);
 }
 
+#undef LARGEST_INPUT_SIZE
+
+static const int planar_yuv_fmts[] = {
+    AV_PIX_FMT_YUV444P9,
+    AV_PIX_FMT_YUV444P10,
+    AV_PIX_FMT_YUV444P12,
+    AV_PIX_FMT_YUV444P14,
+};
+
+/* The vertical output stage of gbrp9..14 to yuv444p9..14, which writes
+ * the 15-bit intermediates of the planar RGB input functions. */
+static void check_output_yuv444p1x(void)
+{
+    SwsContext *sws;
+    SwsInternal *c;
+    const AVPixFmtDescriptor *desc;
+    int fmi, fsi, isi, i;
+    int dstW;
+    static const int filter_sizes[] = {2, 4, 8, 16};
+#define LARGEST_INPUT_SIZE 512
+    static const int input_sizes[] = {8, 24, 128, 144, 256, 512};
+    const int16_t *src[LARGEST_FILTER];
+
+    LOCAL_ALIGNED_16(int16_t, src_pixels, [LARGEST_FILTER * LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_16(int16_t, filter, [LARGEST_FILTER]);
+    LOCAL_ALIGNED_16(uint16_t, dst0, [LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_16(uint16_t, dst1, [LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    randomize_buffers((uint8_t*)src_pixels, LARGEST_FILTER * LARGEST_INPUT_SIZE * sizeof(int16_t));
+    randomize_buffers(dither, 8);
+    for (i = 0; i < LARGEST_FILTER; i++)
+        src[i] = &src_pixels[i * LARGEST_INPUT_SIZE];
+
+    sws = sws_alloc_context();
+    if (sws_init_context(sws, NULL, NULL) < 0)
+        fail();
+
+    c = sws_internal(sws);
+    for (fmi = 0; fmi < FF_ARRAY_ELEMS(planar_yuv_fmts); fmi++) {
+        desc = av_pix_fmt_desc_get(planar_yuv_fmts[fmi]);
+        c->dstFormat = planar_yuv_fmts[fmi];
+        c->dstBpc    = desc->comp[0].depth;
+        ff_sws_init_scale(c);
+
+        for (isi = 0; isi < FF_ARRAY_ELEMS(input_sizes); isi++) {
+            dstW = input_sizes[isi];
+
+            if (check_func(c->yuv2plane1, "yuv2%s_1_%d", desc->name, dstW)) {
+                declare_func(void, const int16_t *src, uint8_t *dest,
+                             int dstW, const uint8_t *dither, int offset);
+
+                memset(dst0, 0xFF, LARGEST_INPUT_SIZE * sizeof(uint16_t));
+                memset(dst1, 0xFF, LARGEST_INPUT_SIZE * sizeof(uint16_t));
+                call_ref(src[0], (uint8_t*)dst0, dstW, dither, 0);
+                call_new(src[0], (uint8_t*)dst1, dstW, dither, 0);
+                if (memcmp(dst0, dst1, dstW * sizeof(uint16_t)))
+                    fail();
+                bench_new(src[0], (uint8_t*)dst1, dstW, dither, 0);
+            }
+
+            for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+                const int filter_size = filter_sizes[fsi];
+
+                if (!check_func(c->yuv2planeX, "yuv2%s_X_%d_%d", desc->name,
+                                filter_size, dstW))
+                    continue;
+
+                {
+                    declare_func(void, const int16_t *filter, int filterSize,
+                                 const int16_t **src, uint8_t *dest, int dstW,
+                                 const uint8_t *dither, int offset);
+
+                    // coefficients that add up to 4096, with negative ones,
+                    // which the 32-bit sums hold for any input
+                    for (i = 0; i < filter_size; i++)
+                        filter[i] = -((1 << 12) / (filter_size - 1));
+                    filter[rnd() % filter_size] = (1 << 13) - 1;
+
+                    memset(dst0, 0xFF, LARGEST_INPUT_SIZE * sizeof(uint16_t));
+                    memset(dst1, 0xFF, LARGEST_INPUT_SIZE * sizeof(uint16_t));
+                    call_ref(filter, filter_size, src, (uint8_t*)dst0, dstW, dither, 0);
+                    call_new(filter, filter_size, src, (uint8_t*)dst1, dstW, dither, 0);
+                    if (memcmp(dst0, dst1, dstW * sizeof(uint16_t)))
+                        fail();
+                    bench_new(filter, filter_size, src, (uint8_t*)dst1, dstW, dither, 0);
+                }
+            }
+        }
+    }
+    sws_freeContext(sws);
+}
+
 void checkasm_check_sw_gbrp(void)
 {
     check_output_yuv2gbrp();
@@ -408,4 +501,7 @@ void checkasm_check_sw_gbrp(void)
 
     check_input_planar_rgb_to_a();
     report("input_planar_rgb_a");
+
+    check_output_yuv444p1x();
+    report("output_yuv444p1x");
 }
@@ -128,8 +128,110 @@ static void check_semiplanar(int dst_pix_fmt)
 #undef NUM_LINES
 #undef MAX_LINE_SIZE
 
+typedef struct Conversion {
+    enum AVPixelFormat src, dst;
+} Conversion;
+
+static const Conversion conversions_up[] = {
+    { AV_PIX_FMT_YUV420P10, AV_PIX_FMT_P010      },
+    { AV_PIX_FMT_YUV420P12, AV_PIX_FMT_P016      },
+    { AV_PIX_FMT_YUV420P16, AV_PIX_FMT_P010      },
+    { AV_PIX_FMT_YUV420P,   AV_PIX_FMT_YUV420P10 },
+    { AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV420P16 },
+    { AV_PIX_FMT_YUV444P12, AV_PIX_FMT_YUV444P16 },
+    { AV_PIX_FMT_GRAY10,    AV_PIX_FMT_GRAY12    },
+};
+
+static const Conversion conversions_down[] = {
+    { AV_PIX_FMT_P010, AV_PIX_FMT_YUV420P10 },
+    { AV_PIX_FMT_P012, AV_PIX_FMT_YUV420P12 },
+    { AV_PIX_FMT_P016, AV_PIX_FMT_YUV420P16 },
+};
+
+static void check_repack(const Conversion *conversions, int nb_conversions)
+{
+#define NUM_LINES 4
+#define MAX_LINE_SIZE 1920
+#define PLANE_SIZE (MAX_LINE_SIZE * 2 * NUM_LINES)
+    static const int input_sizes[] = {8, 24, 128, 1080, MAX_LINE_SIZE};
+
+    declare_func(int, SwsInternal *c, const uint8_t *src[],
+                      int srcStride[], int srcSliceY, int srcSliceH,
+                      uint8_t *dst[], int dstStride[]);
+
+    LOCAL_ALIGNED_32(uint8_t, src_buf,  [3 * PLANE_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_buf, [3 * PLANE_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_buf, [3 * PLANE_SIZE]);
+
+    randomize_buffers(src_buf, 3 * PLANE_SIZE);
+
+    for (int ci = 0; ci < nb_conversions; ci++) {
+        enum AVPixelFormat src_pix_fmt = conversions[ci].src;
+        enum AVPixelFormat dst_pix_fmt = conversions[ci].dst;
+        const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src_pix_fmt);
+        const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_pix_fmt);
+        int nb_planes = av_pix_fmt_count_planes(dst_pix_fmt);
+
+        for (int isi = 0; isi < FF_ARRAY_ELEMS(input_sizes); isi++) {
+            SwsContext *sws;
+            SwsInternal *c;
+            int width = input_sizes[isi];
+            int srcStride[4] = { 0 }, dstStride[4] = { 0 };
+
+            for (int i = 0; i < av_pix_fmt_count_planes(src_pix_fmt); i++)
+                srcStride[i] = MAX_LINE_SIZE * 2;
+            for (int i = 0; i < nb_planes; i++)
+                dstStride[i] = MAX_LINE_SIZE * 2;
+
+            sws = sws_getContext(width, NUM_LINES, src_pix_fmt,
+                                 width, NUM_LINES, dst_pix_fmt,
+                                 0, NULL, NULL, NULL);
+            if (!sws)
+                fail();
+
+            c = sws_internal(sws);
+            if (check_func(c->convert_unscaled, "%s_%s_%d", src_desc->name, dst_desc->name, width)) {
+                /* some converters advance the plane pointers they are given */
+                const uint8_t *src_planes[4] = { 0 }, *src[4];
+                uint8_t *dst0[4] = { 0 }, *dst1[4] = { 0 };
+
+                for (int i = 0; i < av_pix_fmt_count_planes(src_pix_fmt); i++)
+                    src_planes[i] = src_buf + i * PLANE_SIZE;
+                for (int i = 0; i < nb_planes; i++) {
+                    dst0[i] = dst0_buf + i * PLANE_SIZE;
+                    dst1[i] = dst1_buf + i * PLANE_SIZE;
+                }
+                memset(dst0_buf, 0xFF, 3 * PLANE_SIZE);
+                memset(dst1_buf, 0xFF, 3 * PLANE_SIZE);
+
+                memcpy(src, src_planes, sizeof(src));
+                call_ref(c, src, srcStride, 0, NUM_LINES, dst0, dstStride);
+                memcpy(src, src_planes, sizeof(src));
+                call_new(c, src, srcStride, 0, NUM_LINES, dst1, dstStride);
+
+                if (memcmp(dst0_buf, dst1_buf, 3 * PLANE_SIZE))
+                    fail();
+
+                memcpy(src, src_planes, sizeof(src));
+                bench_new(c, src, srcStride, 0, NUM_LINES, dst0, dstStride);
+            }
+            sws_freeContext(sws);
+        }
+    }
+}
+
+#undef NUM_LINES
+#undef MAX_LINE_SIZE
+#undef PLANE_SIZE
+
 void checkasm_check_sw_yuv2yuv(void)
 {
     check_semiplanar(AV_PIX_FMT_YUV420P);
     report("yuv420p");
+
+    check_repack(conversions_up, FF_ARRAY_ELEMS(conversions_up));
+    report("planar_up");
+
+    check_repack(conversions_down, FF_ARRAY_ELEMS(conversions_down));
+    report("p01x_to_planar");
 }
@@ -323,6 +323,23 @@ enc_external(){
     run ffprobe${PROGSUF}${EXECSUF} -bitexact $probe_opt $encfile || return
 }
 
+# mux with the dash muxer with and without io_queue_size, which must give the
+# same files
+dash_io_queue(){
+    queuedir="${outdir}/${test}-queue"
+    syncdir="${outdir}/${test}-sync"
+    rm -rf $queuedir $syncdir
+    mkdir -p $queuedir $syncdir
+    ffmpeg "$@" -io_queue_size 2 -f dash -y $(target_path $queuedir/out.mpd) || return
+    ffmpeg "$@" -f dash -y $(target_path $syncdir/out.mpd) || return
+    test "$(ls $queuedir)" = "$(ls $syncdir)" || { echo "different files written"; return 1; }
+    for file in $(ls $syncdir); do
+        (cd $queuedir && do_md5sum $file)
+        cmp -s $queuedir/$file $syncdir/$file || { echo "$file differs"; return 1; }
+    done
+    test $keep -ge 1 || rm -rf $queuedir $syncdir
+}
+
 # FIXME: There is a certain duplication between the avconv-related helper
 # functions above and below that should be refactored.
 ffmpeg2="$target_exec ${target_path}/ffmpeg${PROGSUF}${EXECSUF}"
@@ -538,6 +555,21 @@ pixdesc(){
     cat $md5file1
 }
 
+enc_threads_match(){
+    src=$1
+    enc_fmt=$2
+    shift 2
+    md5file1="${outdir}/${test}-serial.md5"
+    md5file2="${outdir}/${test}-threads.md5"
+    cleanfiles="$cleanfiles $md5file1 $md5file2"
+
+    ffmpeg $DEC_OPTS -i $(target_path $src) $FLAGS "$@" -threads 1 \
+        -f $enc_fmt md5:$md5file1 || return
+    ffmpeg $DEC_OPTS -i $(target_path $src) $FLAGS "$@" -threads 4 -thread_type slice \
+        -f $enc_fmt md5:$md5file2 || return
+    diff -q $md5file1 $md5file2
+}
+
 video_filter(){
     filters=$1
     shift
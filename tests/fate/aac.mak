@@ -240,6 +240,24 @@ fate-aac-pred-encode: CMP_TARGET = 662
 fate-aac-pred-encode: FUZZ = 12
 fate-aac-pred-encode: SIZE_TOLERANCE = 3560
 
+# main profile prediction of a channel pair, without external samples
+FATE_AAC_PRED_AREF-$(call ENCMUX, AAC, ADTS, WAV_DEMUXER ARESAMPLE_FILTER) += fate-aac-pred-aref-encode
+fate-aac-pred-aref-encode: ./tests/data/asynth-44100-2.wav
+fate-aac-pred-aref-encode: CMD = enc_dec_pcm adts wav s16le $(REF) -profile:a aac_main -c:a aac -aac_coder fast -aac_pred 1 -aac_is 0 -aac_pns 0 -aac_ms 1 -aac_tns 0 -b:a 128k -fflags +bitexact -flags +bitexact
+fate-aac-pred-aref-encode: CMP = stddev
+fate-aac-pred-aref-encode: REF = ./tests/data/asynth-44100-2.wav
+fate-aac-pred-aref-encode: CMP_SHIFT = -4096
+fate-aac-pred-aref-encode: CMP_TARGET = 3561
+fate-aac-pred-aref-encode: SIZE_TOLERANCE = 2464
+fate-aac-pred-aref-encode: FUZZ = 10
+
+# the channel elements searched with slice threads must give the serial output
+FATE_AAC_THREADS-$(call ENCMUX, AAC, ADTS, WAV_DEMUXER MD5_PROTOCOL ARESAMPLE_FILTER) += fate-aac-slice-threads-encode fate-aac-pred-slice-threads-encode
+fate-aac-slice-threads-encode fate-aac-pred-slice-threads-encode: tests/data/asynth-44100-6.wav
+fate-aac-slice-threads-encode: CMD = enc_threads_match tests/data/asynth-44100-6.wav adts -af aresample -c:a aac -b:a 384k
+fate-aac-pred-slice-threads-encode: CMD = enc_threads_match tests/data/asynth-44100-6.wav adts -af aresample -c:a aac -profile:a aac_main -aac_coder fast -aac_pred 1 -b:a 384k
+fate-aac-slice-threads-encode fate-aac-pred-slice-threads-encode: CMP = null
+
 FATE_AAC_LATM += fate-aac-latm_000000001180bc60
 fate-aac-latm_000000001180bc60: CMD = pcm -i $(TARGET_SAMPLES)/aac/latm_000000001180bc60.mpg
 fate-aac-latm_000000001180bc60: REF = $(SAMPLES)/aac/latm_000000001180bc60.s16
@@ -266,6 +284,7 @@ FATE_AAC_ENCODE-$(call ENCMUX, AAC, ADTS, ARESAMPLE_FILTER) += $(FATE_AAC_ENCODE
 FATE_AAC_BSF-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER) += fate-aac-autobsf-adtstoasc
 
 FATE_SAMPLES_FFMPEG += $(FATE_AAC_ALL) $(FATE_AAC_ENCODE-yes) $(FATE_AAC_BSF-yes)
+FATE_FFMPEG += $(FATE_AAC_PRED_AREF-yes) $(FATE_AAC_THREADS-yes)
 
-fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes)
+fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes) $(FATE_AAC_PRED_AREF-yes) $(FATE_AAC_THREADS-yes)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
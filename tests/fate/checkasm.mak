@@ -3,10 +3,12 @@ FATE_CHECKASM = fate-checkasm-aacencdsp                                 \
                 fate-checkasm-ac3dsp                                    \
                 fate-checkasm-af_afir                                   \
                 fate-checkasm-alacdsp                                   \
+                fate-checkasm-aom_film_grain                            \
                 fate-checkasm-audiodsp                                  \
                 fate-checkasm-av_tx                                     \
                 fate-checkasm-blockdsp                                  \
                 fate-checkasm-bswapdsp                                  \
+                fate-checkasm-drawutils                                 \
                 fate-checkasm-exrdsp                                    \
                 fate-checkasm-fdctdsp                                   \
                 fate-checkasm-fixed_dsp                                 \
@@ -19,6 +21,7 @@ FATE_CHECKASM = fate-checkasm-aacencdsp                                 \
                 fate-checkasm-h264dsp                                   \
                 fate-checkasm-h264pred                                  \
                 fate-checkasm-h264qpel                                  \
+                fate-checkasm-h274dsp                                   \
                 fate-checkasm-hevc_add_res                              \
                 fate-checkasm-hevc_deblock                              \
                 fate-checkasm-hevc_idct                                 \
@@ -36,6 +39,7 @@ FATE_CHECKASM = fate-checkasm-aacencdsp                                 \
                 fate-checkasm-mpegvideoencdsp                           \
                 fate-checkasm-opusdsp                                   \
                 fate-checkasm-pixblockdsp                               \
+                fate-checkasm-pixelutils                                \
                 fate-checkasm-sbrdsp                                    \
                 fate-checkasm-rv34dsp                                   \
                 fate-checkasm-rv40dsp                                   \
@@ -0,0 +1,6 @@
+# the segments leaving the window are deleted by the queue as well
+FATE_DASHENC-$(call ALLYES, DASH_MUXER MP4_MUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-dash-io-queue
+fate-dash-io-queue: CMD = dash_io_queue -f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -map 0 -af aresample -codec:a mp2fixed -fflags +bitexact -flags +bitexact -seg_duration 3 -window_size 3 -extra_window_size 0
+
+FATE_FFMPEG += $(FATE_DASHENC-yes)
+fate-dashenc: $(FATE_DASHENC-yes)
@@ -193,6 +193,14 @@ fate-copy-shortest1 fate-copy-shortest2: tests/data/audio_shorter_than_video.nut
 fate-copy-shortest1: CMD = framemd5 -auto_conversion_filters -fflags +bitexact -flags +bitexact -f lavfi -i "sine=3000:d=10" -f lavfi -i "sine=1000:d=1" -i $(TARGET_PATH)/tests/data/audio_shorter_than_video.nut -filter_complex "[0:a:0][1:a:0]amix=inputs=2[audio]" -map 2:v:0 -map "[audio]" -fflags +bitexact -flags +bitexact -c:v copy -c:a ac3_fixed -shortest
 fate-copy-shortest2: CMD = framemd5 -auto_conversion_filters -fflags +bitexact -flags +bitexact -f lavfi -i "sine=3000:d=10" -i $(TARGET_PATH)/tests/data/audio_shorter_than_video.nut -filter_complex "[0:a:0][1:a:0]amix=inputs=2[audio]" -map 1:v:0 -map "[audio]" -fflags +bitexact -flags +bitexact -c:v copy -c:a ac3_fixed -shortest
 
+# read the packets from the file mapped into memory, as references to it
+FATE_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER) += fate-file-mmap fate-file-mmap-copy
+fate-file-mmap fate-file-mmap-copy: tests/data/vsynth1.yuv
+fate-file-mmap: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+                      mov "-c:v mpeg4 -qscale 10 -frames:v 10" "" "" "" "-mmap 1"
+fate-file-mmap-copy: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+                           mov "-c:v mpeg4 -qscale 10 -frames:v 10" "-c copy" "" "" "-mmap 1"
+
 fate-streamcopy: $(FATE_STREAMCOPY-yes)
 FATE_SAMPLES_FFMPEG-yes += $(FATE_STREAMCOPY-yes)
 
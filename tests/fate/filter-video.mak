@@ -82,6 +82,18 @@ fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC, LAVFI_INDEV) += fate-filter-lavd-testsrc
 fate-filter-lavd-testsrc: CMD = framecrc -f lavfi -i testsrc=r=7:n=2:d=10
 
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 HFLIP VFLIP NEGATE SPLIT HSTACK, LAVFI_INDEV) += fate-filter-pipeline
+fate-filter-pipeline: CMD = framecrc -filter_pipeline -filter_threads 4 -f lavfi -i testsrc2=r=7:d=3 -vf "hflip,negate,split[a][b];[a]vflip[c];[c][b]hstack"
+
+# drawtext uses the default font found by fontconfig
+FATE_FILTER-$(call ALLYES, DRAWTEXT_FILTER FORMAT_FILTER LIBFONTCONFIG) += fate-filter-drawtext-cache
+fate-filter-drawtext-cache: libavfilter/tests/drawtext$(EXESUF)
+fate-filter-drawtext-cache: CMD = run libavfilter/tests/drawtext$(EXESUF)
+
+FATE_FILTER-$(CONFIG_SCALE_FILTER) += fate-filter-scale-crop
+fate-filter-scale-crop: libavfilter/tests/scale_crop$(EXESUF)
+fate-filter-scale-crop: CMD = run libavfilter/tests/scale_crop$(EXESUF)
+
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2) += $(addprefix fate-filter-testsrc2-, yuv420p yuv444p rgb24 rgba)
 fate-filter-testsrc2-%: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt $(word 4, $(subst -, ,$(@)))
 
@@ -152,6 +164,10 @@ FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC FORMAT CONCAT SCALE, LAVFI_INDEV FILE
 fate-filter-lavd-scalenorm: tests/data/filtergraphs/scalenorm
 fate-filter-lavd-scalenorm: CMD = framecrc -f lavfi -graph_file $(TARGET_PATH)/tests/data/filtergraphs/scalenorm -i dummy
 
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FORMAT MULTISCALE) += fate-filter-multiscale fate-filter-multiscale-nocascade
+fate-filter-multiscale: CMD = framecrc -lavfi "testsrc2=r=5:d=1:s=320x240,format=rgb24,multiscale=sizes=320x240|160x120|100x76:cascade=1:flags=+accurate_rnd+bitexact[a][b][c]" -map "[a]" -map "[b]" -map "[c]"
+fate-filter-multiscale-nocascade: CMD = framecrc -lavfi "testsrc2=r=5:d=1:s=320x240,format=rgb24,multiscale=sizes=160x120|100x76:cascade=0:flags=+accurate_rnd+bitexact[a][b]" -map "[a]" -map "[b]"
+
 FATE_FILTER-$(call FILTERFRAMECRC, FRAMERATE TESTSRC2) += fate-filter-framerate-up fate-filter-framerate-down
 fate-filter-framerate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=10 -t 1
 fate-filter-framerate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=1 -t 1
@@ -164,6 +180,16 @@ FATE_FILTER-$(call FILTERFRAMECRC, MINTERPOLATE TESTSRC2) += fate-filter-minterp
 fate-filter-minterpolate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
 fate-filter-minterpolate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=1 -t 1
 
+# the threaded motion search and compensation must match the serial output
+FATE_FILTER-$(call FILTERFRAMECRC, MINTERPOLATE TESTSRC2) += fate-filter-minterpolate-up-threads
+fate-filter-minterpolate-up-threads: CMD = framecrc -filter_complex_threads 4 -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
+fate-filter-minterpolate-up-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-minterpolate-up
+
+FATE_FILTER-$(call FILTERFRAMECRC, MINTERPOLATE TESTSRC2) += fate-filter-minterpolate-umh-aobmc fate-filter-minterpolate-umh-aobmc-threads
+fate-filter-minterpolate-umh-aobmc: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10:me=umh:mc_mode=aobmc:mb_size=8 -t 1
+fate-filter-minterpolate-umh-aobmc-threads: CMD = framecrc -filter_complex_threads 4 -lavfi testsrc2=r=2:d=10,minterpolate=fps=10:me=umh:mc_mode=aobmc:mb_size=8 -t 1
+fate-filter-minterpolate-umh-aobmc-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-minterpolate-umh-aobmc
+
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
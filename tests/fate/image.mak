@@ -360,10 +360,15 @@ fate-jpg-rgb-5: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpg/jpg-8930-5.
 FATE_JPG_TRANSCODE-$(call TRANSCODE, MJPEG, MJPEG IMAGE_JPEG_PIPE, IMAGE_PNG_PIPE_DEMUXER PNG_DECODER SCALE_FILTER) += fate-jpg-icc
 fate-jpg-icc: CMD = transcode png_pipe $(TARGET_SAMPLES)/png1/lena-int_rgb24.png mjpeg "-vf scale" "" "-show_frames"
 
+# restart intervals decoded by slice threads
+FATE_JPG_FFMPEG-$(call TRANSCODE, MJPEG, AVI, LAVFI_INDEV TESTSRC2_FILTER SCALE_FILTER RAWVIDEO_DECODER) += fate-jpg-slice-threads
+fate-jpg-slice-threads: CMD = transcode "lavfi -graph testsrc2=s=352x288:r=5:d=1" "foo" avi "-vf scale -c:v mjpeg -pix_fmt yuvj420p -slices 4 -qscale 5" "" "" "" "-threads 4 -thread_type slice"
+
 FATE_JPG-$(call DEMDEC, IMAGE2, MJPEG) += $(FATE_JPG)
 FATE_IMAGE_FRAMECRC += $(FATE_JPG-yes)
 FATE_IMAGE_TRANSCODE += $(FATE_JPG_TRANSCODE-yes)
-fate-jpg: $(FATE_JPG-yes) $(FATE_JPG_TRANSCODE-yes)
+FATE_FFMPEG += $(FATE_JPG_FFMPEG-yes)
+fate-jpg: $(FATE_JPG-yes) $(FATE_JPG_TRANSCODE-yes) $(FATE_JPG_FFMPEG-yes)
 
 FATE_JPEGLS += fate-jpegls-2bpc
 fate-jpegls-2bpc: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/jpegls/4.jls
@@ -33,6 +33,10 @@ fate-codec_desc: libavcodec/tests/codec_desc$(EXESUF)
 fate-codec_desc: CMD = run libavcodec/tests/codec_desc$(EXESUF)
 fate-codec_desc: CMP = null
 
+FATE_LIBAVCODEC-$(CONFIG_HEVC_DECODER) += fate-film-grain
+fate-film-grain: libavcodec/tests/film_grain$(EXESUF)
+fate-film-grain: CMD = run libavcodec/tests/film_grain$(EXESUF)
+
 FATE_LIBAVCODEC-$(CONFIG_GOLOMB) += fate-golomb
 fate-golomb: libavcodec/tests/golomb$(EXESUF)
 fate-golomb: CMD = run libavcodec/tests/golomb$(EXESUF)
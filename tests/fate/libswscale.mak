@@ -2,6 +2,10 @@ FATE_LIBSWSCALE += fate-sws-pixdesc-query
 fate-sws-pixdesc-query: libswscale/tests/pixdesc_query$(EXESUF)
 fate-sws-pixdesc-query: CMD = run libswscale/tests/pixdesc_query$(EXESUF)
 
+FATE_LIBSWSCALE += fate-sws-filter-cache
+fate-sws-filter-cache: libswscale/tests/filter_cache$(EXESUF)
+fate-sws-filter-cache: CMD = run libswscale/tests/filter_cache$(EXESUF)
+
 FATE_LIBSWSCALE += fate-sws-floatimg-cmp
 fate-sws-floatimg-cmp: libswscale/tests/floatimg_cmp$(EXESUF)
 fate-sws-floatimg-cmp: CMD = run libswscale/tests/floatimg_cmp$(EXESUF)
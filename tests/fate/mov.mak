@@ -219,6 +219,44 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-mp4-pcm-float: tests/data/asynth-44100-1.wav
 fate-mov-mp4-pcm-float: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-af aresample,pan=FR+FL+FR|c0=c0|c1=c0|c2=c0 -c:a pcm_f32le" "-map 0 -c copy -frames:a 0"
 
+# Test reading fragments on demand, and seeking into fragments which were not read yet
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) \
+                          += fate-mov-frag-window
+fate-mov-frag-window: tests/data/asynth-44100-1.wav
+fate-mov-frag-window: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-c:a pcm_s16le -movflags +frag_keyframe+empty_moov -frag_duration 200000" "-c copy" "" "" "-frag_window 2 -ss 2"
+
+# Test reading linearly after seeking back into fragments which were dropped
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) \
+                          += fate-mov-frag-window-seek
+fate-mov-frag-window-seek: fate-mov-frag-window libavformat/tests/seek$(EXESUF)
+fate-mov-frag-window: KEEP_FILES ?= 1
+fate-mov-frag-window-seek: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/fate/mov-frag-window.mp4 -frag_window 2 -frames 4
+
+# Test reading and seeking a stream with B-frames, whose composition offsets are dropped with the fragments
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER) \
+                          += fate-mov-frag-window-ctts
+fate-mov-frag-window-ctts: tests/data/vsynth1.yuv
+fate-mov-frag-window-ctts: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv mp4 "-c:v mpeg4 -bf 2 -g 10 -qscale 10 -movflags +frag_keyframe+empty_moov" "-c copy" "" "" "-frag_window 2 -ss 1"
+
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER) \
+                          += fate-mov-frag-window-ctts-seek
+fate-mov-frag-window-ctts-seek: fate-mov-frag-window-ctts libavformat/tests/seek$(EXESUF)
+fate-mov-frag-window-ctts: KEEP_FILES ?= 1
+fate-mov-frag-window-ctts-seek: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/fate/mov-frag-window-ctts.mp4 -frag_window 2 -frames 4
+
+# Test writing the moov atom in space reserved from the stream durations
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) \
+                          += fate-mov-moov-size-auto
+fate-mov-moov-size-auto: tests/data/asynth-44100-1.wav
+fate-mov-moov-size-auto: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-c:a pcm_s16le -moov_size auto" "-c copy"
+
+# Test a moov atom exceeding the space reserved from an understated duration
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER SCALE_FILTER) \
+                          += fate-mov-moov-size-auto-overflow
+fate-mov-moov-size-auto-overflow: tests/data/vsynth1.yuv
+fate-mov-moov-size-auto-overflow: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p -r 1000" tests/data/vsynth1.yuv \
+                                        mov "-c:v mpeg4 -s 16x16 -metadata:s:v DURATION=0.01 -moov_size auto" "-c copy -ss 1.5" "" "" "" "-stream_loop 30"
+
 fate-mov-pcm-remux: tests/data/asynth-44100-1.wav
 fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -map 0 -c copy -fflags +bitexact -f mp4
 fate-mov-pcm-remux: CMP = oneline
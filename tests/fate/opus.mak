@@ -37,8 +37,15 @@ fate-opus-silk-lbrr:         CMP_TARGET = 0
 fate-opus-tron.6ch.tinypkts: CMP_SHIFT = 1440
 fate-opus-tron.6ch.tinypkts: CMP_TARGET = 0
 
+# the stereo searches run with slice threads must give the serial output
+FATE_OPUS_THREADS-$(call ENCMUX, OPUS, OGG, WAV_DEMUXER MD5_PROTOCOL ARESAMPLE_FILTER) += fate-opus-slice-threads-encode
+fate-opus-slice-threads-encode: tests/data/asynth-44100-2.wav
+fate-opus-slice-threads-encode: CMD = enc_threads_match tests/data/asynth-44100-2.wav ogg -af aresample=48000 -c:a opus -strict experimental -b:a 96k
+fate-opus-slice-threads-encode: CMP = null
+
 FATE_SAMPLES_FFMPEG += $(FATE_OPUS)
+FATE_FFMPEG += $(FATE_OPUS_THREADS-yes)
 fate-opus-celt: $(FATE_OPUS_CELT-yes)
 fate-opus-hybrid: $(FATE_OPUS_HYBRID-yes)
 fate-opus-silk: $(FATE_OPUS_SILK-yes)
-fate-opus: $(FATE_OPUS)
+fate-opus: $(FATE_OPUS) $(FATE_OPUS_THREADS-yes)
@@ -76,6 +76,13 @@ define FATE_VP8_SUITE
 FATE_VP8-$(call FRAMEMD5, IVF, VP8) += fate-vp8-test-vector-$(1)
 fate-vp8-test-vector-$(1): CMD = framemd5 -i $(TARGET_SAMPLES)/vp8-test-vectors-r1/vp80-00-comprehensive-$(1).ivf
 fate-vp8-test-vector-$(1): REF = $(SRC_PATH)/tests/ref/fate/vp8-test-vector-$(1)
+
+# the slice jobs wait for each other, they must not run on a smaller pool
+FATE_VP8-$(call FRAMEMD5, IVF, VP8) += fate-vp8-test-vector-$(1)-thread-pool
+fate-vp8-test-vector-$(1)-thread-pool: CMD = framemd5 -thread_pool 2 -i $(TARGET_SAMPLES)/vp8-test-vectors-r1/vp80-00-comprehensive-$(1).ivf
+fate-vp8-test-vector-$(1)-thread-pool: REF = $(SRC_PATH)/tests/ref/fate/vp8-test-vector-$(1)
+fate-vp8-test-vector-$(1)-thread-pool: THREADS = 4
+fate-vp8-test-vector-$(1)-thread-pool: THREAD_TYPE = slice
 endef
 
 $(foreach N,$(VP8_SUITE),$(eval $(call FATE_VP8_SUITE,$(N))))
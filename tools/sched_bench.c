@@ -0,0 +1,253 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the packet throughput of the ffmpeg scheduler in a streamcopy
+ * setup: a number of demuxer tasks, each generating small packets for a
+ * number of streams, all of which are sent to a single muxer task.
+ *
+ * usage: sched_bench [demuxers [streams [packets [packet_size]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fftools/cmdutils.h"
+#include "fftools/ffmpeg_sched.h"
+
+#include "libavcodec/packet.h"
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+const char program_name[] = "sched_bench";
+const int program_birth_year = 2024;
+
+void show_help_default(const char *opt, const char *arg)
+{
+}
+
+/* never called, the benchmark does not write an SDP */
+int print_sdp(const char *filename);
+int print_sdp(const char *filename)
+{
+    return AVERROR(ENOSYS);
+}
+
+typedef struct BenchDemux {
+    const AVClass *class;
+
+    Scheduler     *sch;
+    unsigned       idx;
+    int            nb_streams;
+    int64_t        nb_packets;
+    int            packet_size;
+} BenchDemux;
+
+typedef struct BenchMux {
+    const AVClass *class;
+
+    Scheduler     *sch;
+    unsigned       idx;
+    int64_t        nb_packets;
+    int64_t        nb_bytes;
+} BenchMux;
+
+static const AVClass demux_class = {
+    .class_name = "BenchDemux",
+    .item_name  = av_default_item_name,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static const AVClass mux_class = {
+    .class_name = "BenchMux",
+    .item_name  = av_default_item_name,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static int demux_thread(void *arg)
+{
+    BenchDemux *d = arg;
+    AVPacket *pkt = av_packet_alloc();
+    int ret = 0;
+
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    /* 1ms packets of 48kHz audio, interleaved over the streams */
+    for (int64_t i = 0; i < d->nb_packets; i++) {
+        ret = av_new_packet(pkt, d->packet_size);
+        if (ret < 0)
+            break;
+
+        pkt->stream_index = i % d->nb_streams;
+        pkt->pts          = i / d->nb_streams * 48;
+        pkt->dts          = pkt->pts;
+        pkt->duration     = 48;
+        pkt->time_base    = (AVRational){ 1, 48000 };
+        pkt->flags       |= AV_PKT_FLAG_KEY;
+
+        ret = sch_demux_send(d->sch, d->idx, pkt, 0);
+        av_packet_unref(pkt);
+        if (ret == AVERROR_EXIT) {
+            ret = 0;
+            break;
+        } else if (ret < 0 && ret != AVERROR_EOF) {
+            break;
+        }
+        ret = 0;
+    }
+
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int mux_init(void *arg)
+{
+    return 0;
+}
+
+static int mux_thread(void *arg)
+{
+    BenchMux *mux = arg;
+    AVPacket *pkt = av_packet_alloc();
+    int ret;
+
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    while (1) {
+        ret = sch_mux_receive(mux->sch, mux->idx, pkt);
+        if (pkt->stream_index < 0) {
+            ret = 0;
+            break;
+        }
+        if (ret == AVERROR_EOF) {
+            sch_mux_receive_finish(mux->sch, mux->idx, pkt->stream_index);
+            continue;
+        }
+
+        mux->nb_packets++;
+        mux->nb_bytes += pkt->size;
+        av_packet_unref(pkt);
+    }
+
+    av_packet_free(&pkt);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int     nb_demux    = argc > 1 ? atoi(argv[1]) : 1;
+    int     nb_streams  = argc > 2 ? atoi(argv[2]) : 2;
+    int64_t nb_packets  = argc > 3 ? strtoll(argv[3], NULL, 10) : 1000000;
+    int     packet_size = argc > 4 ? atoi(argv[4]) : 192;
+    BenchDemux *demux = NULL;
+    BenchMux mux = { .class = &mux_class };
+    Scheduler *sch;
+    int64_t t, transcode_ts;
+    int ret;
+
+    if (nb_demux <= 0 || nb_streams <= 0 || nb_packets <= 0 || packet_size <= 0) {
+        fprintf(stderr, "usage: %s [demuxers [streams [packets [packet_size]]]]\n",
+                argv[0]);
+        return 1;
+    }
+
+    sch = sch_alloc();
+    demux = av_calloc(nb_demux, sizeof(*demux));
+    if (!sch || !demux) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    mux.sch = sch;
+    ret = sch_add_mux(sch, mux_thread, mux_init, &mux, 0, 0);
+    if (ret < 0)
+        goto end;
+    mux.idx = ret;
+
+    for (int i = 0; i < nb_demux; i++) {
+        BenchDemux *d = &demux[i];
+
+        *d = (BenchDemux){ .class = &demux_class, .sch = sch,
+                           .nb_streams = nb_streams, .nb_packets = nb_packets,
+                           .packet_size = packet_size };
+
+        ret = sch_add_demux(sch, demux_thread, d);
+        if (ret < 0)
+            goto end;
+        d->idx = ret;
+
+        for (int j = 0; j < nb_streams; j++) {
+            int ds, ms;
+
+            ds = sch_add_demux_stream(sch, d->idx);
+            if (ds < 0) {
+                ret = ds;
+                goto end;
+            }
+            ms = sch_add_mux_stream(sch, mux.idx);
+            if (ms < 0) {
+                ret = ms;
+                goto end;
+            }
+
+            ret = sch_connect(sch, SCH_DSTREAM(d->idx, ds), SCH_MSTREAM(mux.idx, ms));
+            if (ret < 0)
+                goto end;
+
+            sch_mux_stream_buffering(sch, mux.idx, ms, 50 * 1024 * 1024, 128);
+            ret = sch_mux_stream_ready(sch, mux.idx, ms);
+            if (ret < 0)
+                goto end;
+        }
+    }
+
+    t = av_gettime_relative();
+
+    ret = sch_start(sch);
+    if (ret < 0)
+        goto end;
+
+    while (!sch_wait(sch, 100000, &transcode_ts))
+        ;
+
+    ret = sch_stop(sch, NULL);
+    t = FFMAX(av_gettime_relative() - t, 1);
+
+    printf("%d demuxers x %d streams: %"PRId64" packets (%"PRId64" bytes) "
+           "in %.3f s, %.0f packets/s\n",
+           nb_demux, nb_streams, mux.nb_packets, mux.nb_bytes,
+           t / 1000000.0, mux.nb_packets * 1000000.0 / t);
+
+    if (mux.nb_packets != nb_packets * nb_demux) {
+        fprintf(stderr, "Expected %"PRId64" packets\n", nb_packets * nb_demux);
+        ret = AVERROR_BUG;
+    }
+
+end:
+    sch_free(&sch);
+    av_freep(&demux);
+    if (ret < 0)
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+    return ret < 0;
+}